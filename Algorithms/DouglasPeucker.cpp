@@ -53,7 +53,7 @@ struct CoordinatePairCalculator
         second_lon = (coordinate_b.lon / COORDINATE_PRECISION) * RAD;
     }
 
-    int operator()(FixedPointCoordinate &other) const
+    int operator()(const FixedPointCoordinate &other) const
     {
         // set third coordinate c
         const float RAD = 0.017453292519943295769236907684886f;
@@ -82,6 +82,8 @@ struct CoordinatePairCalculator
 };
 }
 
+const SimplificationRank DouglasPeucker::NUMBER_OF_ZOOM_LEVELS;
+
 DouglasPeucker::DouglasPeucker()
     : douglas_peucker_thresholds({512440, // z0
                                   256720, // z1
@@ -119,47 +121,68 @@ void DouglasPeucker::Run(std::vector<SegmentInformation> &input_geometry, const
     input_geometry.front().necessary = true;
     input_geometry.back().necessary = true;
 
+    BOOST_ASSERT_MSG(zoom_level < NUMBER_OF_ZOOM_LEVELS, "unsupported zoom level");
+
+    // points with a precomputed rank only need a comparison, all others are generalized
+    anchor_indices.clear();
+    const unsigned last_index = static_cast<unsigned>(input_geometry.size()) - 1;
+    for (const auto i : osrm::irange(0u, last_index + 1))
+    {
+        SegmentInformation &segment = input_geometry[i];
+        if (0 == i || last_index == i ||
+            INVALID_SIMPLIFICATION_RANK == segment.simplification_rank)
+        {
+            anchor_indices.push_back(i);
+        }
+        else if (segment.simplification_rank <= zoom_level)
+        {
+            segment.necessary = true;
+        }
+    }
+
     {
-        BOOST_ASSERT_MSG(zoom_level < 19, "unsupported zoom level");
         unsigned left_border = 0;
         unsigned right_border = 1;
         // Sweep over array and identify those ranges that need to be checked
         do
         {
             // traverse list until new border element found
-            if (input_geometry[right_border].necessary)
+            if (input_geometry[anchor_indices[right_border]].necessary)
             {
                 // sanity checks
-                BOOST_ASSERT(input_geometry[left_border].necessary);
-                BOOST_ASSERT(input_geometry[right_border].necessary);
+                BOOST_ASSERT(input_geometry[anchor_indices[left_border]].necessary);
+                BOOST_ASSERT(input_geometry[anchor_indices[right_border]].necessary);
                 recursion_stack.emplace(left_border, right_border);
                 left_border = right_border;
             }
             ++right_border;
-        } while (right_border < input_geometry.size());
+        } while (right_border < anchor_indices.size());
     }
 
-    // mark locations as 'necessary' by divide-and-conquer
+    // mark locations as 'necessary' by divide-and-conquer, ranges are given as anchor positions
     while (!recursion_stack.empty())
     {
         // pop next element
         const GeometryRange pair = recursion_stack.top();
         recursion_stack.pop();
         // sanity checks
-        BOOST_ASSERT_MSG(input_geometry[pair.first].necessary, "left border mus be necessary");
-        BOOST_ASSERT_MSG(input_geometry[pair.second].necessary, "right border must be necessary");
-        BOOST_ASSERT_MSG(pair.second < input_geometry.size(), "right border outside of geometry");
+        BOOST_ASSERT_MSG(input_geometry[anchor_indices[pair.first]].necessary,
+                         "left border mus be necessary");
+        BOOST_ASSERT_MSG(input_geometry[anchor_indices[pair.second]].necessary,
+                         "right border must be necessary");
+        BOOST_ASSERT_MSG(pair.second < anchor_indices.size(), "right border outside of geometry");
         BOOST_ASSERT_MSG(pair.first < pair.second, "left border on the wrong side");
 
         int max_int_distance = 0;
         unsigned farthest_entry_index = pair.second;
-        const CoordinatePairCalculator dist_calc(input_geometry[pair.first].location,
-                                                 input_geometry[pair.second].location);
+        const CoordinatePairCalculator dist_calc(
+            input_geometry[anchor_indices[pair.first]].location,
+            input_geometry[anchor_indices[pair.second]].location);
 
         // sweep over range to find the maximum
         for (const auto i : osrm::irange(pair.first + 1, pair.second))
         {
-            const int distance = dist_calc(input_geometry[i].location);
+            const int distance = dist_calc(input_geometry[anchor_indices[i]].location);
             // found new feasible maximum?
             if (distance > max_int_distance && distance > douglas_peucker_thresholds[zoom_level])
             {
@@ -172,14 +195,84 @@ void DouglasPeucker::Run(std::vector<SegmentInformation> &input_geometry, const
         if (max_int_distance > douglas_peucker_thresholds[zoom_level])
         {
             //  mark idx as necessary
-            input_geometry[farthest_entry_index].necessary = true;
+            input_geometry[anchor_indices[farthest_entry_index]].necessary = true;
+            if (1 < (farthest_entry_index - pair.first))
+            {
+                recursion_stack.emplace(pair.first, farthest_entry_index);
+            }
+            if (1 < (pair.second - farthest_entry_index))
+            {
+                recursion_stack.emplace(farthest_entry_index, pair.second);
+            }
+        }
+    }
+}
+
+void DouglasPeucker::ComputeRanks(const std::vector<FixedPointCoordinate> &input_geometry,
+                                  std::vector<SimplificationRank> &ranks)
+{
+    ranks.assign(input_geometry.size(), NUMBER_OF_ZOOM_LEVELS);
+    if (input_geometry.empty())
+    {
+        return;
+    }
+    ranks.front() = 0;
+    ranks.back() = 0;
+
+    // Run() selects the farthest point of a range as long as it exceeds the threshold. The
+    // farthest point does not depend on the threshold, so a single generalization with the
+    // finest threshold visits all ranges. A point is kept at a zoom level if both its own
+    // distance and the ones of all points that split its range before exceed the threshold.
+    const unsigned finest_zoom_level = NUMBER_OF_ZOOM_LEVELS - 1;
+    BOOST_ASSERT(recursion_stack.empty());
+    std::stack<SimplificationRank> range_ranks;
+    if (input_geometry.size() > 2)
+    {
+        recursion_stack.emplace(0, static_cast<unsigned>(input_geometry.size()) - 1);
+        range_ranks.push(0);
+    }
+
+    while (!recursion_stack.empty())
+    {
+        const GeometryRange pair = recursion_stack.top();
+        recursion_stack.pop();
+        const SimplificationRank range_rank = range_ranks.top();
+        range_ranks.pop();
+
+        int max_int_distance = 0;
+        unsigned farthest_entry_index = pair.second;
+        const CoordinatePairCalculator dist_calc(input_geometry[pair.first],
+                                                 input_geometry[pair.second]);
+        for (const auto i : osrm::irange(pair.first + 1, pair.second))
+        {
+            const int distance = dist_calc(input_geometry[i]);
+            if (distance > max_int_distance &&
+                distance > douglas_peucker_thresholds[finest_zoom_level])
+            {
+                farthest_entry_index = i;
+                max_int_distance = distance;
+            }
+        }
+
+        if (max_int_distance > douglas_peucker_thresholds[finest_zoom_level])
+        {
+            SimplificationRank rank = range_rank;
+            while (max_int_distance <= douglas_peucker_thresholds[rank])
+            {
+                ++rank;
+            }
+            BOOST_ASSERT(rank <= finest_zoom_level);
+            ranks[farthest_entry_index] = rank;
+
             if (1 < (farthest_entry_index - pair.first))
             {
                 recursion_stack.emplace(pair.first, farthest_entry_index);
+                range_ranks.push(rank);
             }
             if (1 < (pair.second - farthest_entry_index))
             {
                 recursion_stack.emplace(farthest_entry_index, pair.second);
+                range_ranks.push(rank);
             }
         }
     }
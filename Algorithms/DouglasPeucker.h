@@ -28,6 +28,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef DOUGLASPEUCKER_H_
 #define DOUGLASPEUCKER_H_
 
+#include "../typedefs.h"
+
 #include <stack>
 #include <utility>
 #include <vector>
@@ -37,8 +39,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *
  * Input is vector of pairs. Each pair consists of the point information and a
  * bit indicating if the points is present in the generalization.
- * Note: points may also be pre-selected*/
+ * Note: points may also be pre-selected
+ *
+ * Points of compressed geometries carry a simplification rank that was
+ * precomputed by ComputeRanks during preprocessing. These are selected by
+ * comparing their rank with the zoom level, only the remaining points are
+ * generalized at query time.*/
 
+struct FixedPointCoordinate;
 struct SegmentInformation;
 
 class DouglasPeucker
@@ -49,10 +57,20 @@ class DouglasPeucker
     using GeometryRange = std::pair<unsigned, unsigned>;
     // Stack to simulate the recursion
     std::stack<GeometryRange> recursion_stack;
+    // positions of the points that are generalized at query time
+    std::vector<unsigned> anchor_indices;
 
   public:
     DouglasPeucker();
     void Run(std::vector<SegmentInformation> &input_geometry, const unsigned zoom_level);
+
+    // Computes the lowest zoom level for each point at which the generalization of the
+    // polyline between its first and last point keeps it. The end points get rank 0.
+    void ComputeRanks(const std::vector<FixedPointCoordinate> &input_geometry,
+                      std::vector<SimplificationRank> &ranks);
+
+    // rank of points that are not kept at any zoom level
+    static const SimplificationRank NUMBER_OF_ZOOM_LEVELS = 19;
 };
 
 #endif /* DOUGLASPEUCKER_H_ */
@@ -30,67 +30,67 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <osrm/Coordinate.h>
 
-void PolylineCompressor::encodeVectorSignedNumber(std::vector<int> &numbers,
-                                                  std::string &output) const
+namespace
 {
-    const unsigned end = static_cast<unsigned>(numbers.size());
-    for (unsigned i = 0; i < end; ++i)
-    {
-        numbers[i] <<= 1;
-        if (numbers[i] < 0)
-        {
-            numbers[i] = ~(numbers[i]);
-        }
-    }
-    for (const int number : numbers)
-    {
-        encodeNumber(number, output);
-    }
+// a 32 bit number takes at most 7 characters, each of which may be escaped
+constexpr std::size_t MAX_ENCODED_NUMBER_LENGTH = 14;
 }
 
-void PolylineCompressor::encodeNumber(int number_to_encode, std::string &output) const
+char *PolylineCompressor::encodeSignedNumber(int number_to_encode, char *out)
 {
+    number_to_encode <<= 1;
+    if (number_to_encode < 0)
+    {
+        number_to_encode = ~number_to_encode;
+    }
+
     while (number_to_encode >= 0x20)
     {
         const int next_value = (0x20 | (number_to_encode & 0x1f)) + 63;
-        output += static_cast<char>(next_value);
+        *out++ = static_cast<char>(next_value);
         if (92 == next_value)
         {
-            output += static_cast<char>(next_value);
+            *out++ = static_cast<char>(next_value);
         }
         number_to_encode >>= 5;
     }
 
     number_to_encode += 63;
-    output += static_cast<char>(number_to_encode);
+    *out++ = static_cast<char>(number_to_encode);
     if (92 == number_to_encode)
     {
-        output += static_cast<char>(number_to_encode);
+        *out++ = static_cast<char>(number_to_encode);
     }
+    return out;
 }
 
-JSON::String
-PolylineCompressor::printEncodedString(const std::vector<SegmentInformation> &polyline) const
+void PolylineCompressor::encodePolyline(const std::vector<SegmentInformation> &polyline,
+                                        std::string &output) const
 {
-    std::string output;
-    std::vector<int> delta_numbers;
-    if (!polyline.empty())
+    // size for the worst case once and write in place, the unused tail is cut off afterwards
+    const std::size_t initial_size = output.size();
+    output.resize(initial_size + polyline.size() * 2 * MAX_ENCODED_NUMBER_LENGTH);
+    char *const begin = &output[0];
+    char *end = begin + initial_size;
+
+    FixedPointCoordinate last_coordinate = {0, 0};
+    for (const auto &segment : polyline)
     {
-        FixedPointCoordinate last_coordinate = {0, 0};
-        for (const auto &segment : polyline)
+        if (segment.necessary)
         {
-            if (segment.necessary)
-            {
-                const int lat_diff = segment.location.lat - last_coordinate.lat;
-                const int lon_diff = segment.location.lon - last_coordinate.lon;
-                delta_numbers.emplace_back(lat_diff);
-                delta_numbers.emplace_back(lon_diff);
-                last_coordinate = segment.location;
-            }
+            end = encodeSignedNumber(segment.location.lat - last_coordinate.lat, end);
+            end = encodeSignedNumber(segment.location.lon - last_coordinate.lon, end);
+            last_coordinate = segment.location;
         }
-        encodeVectorSignedNumber(delta_numbers, output);
     }
-    JSON::String return_value(output);
+    output.resize(end - begin);
+}
+
+JSON::String
+PolylineCompressor::printEncodedString(const std::vector<SegmentInformation> &polyline) const
+{
+    JSON::String return_value;
+    encodePolyline(polyline, return_value.value);
     return return_value;
 }
 
@@ -38,11 +38,14 @@ struct SegmentInformation;
 class PolylineCompressor
 {
   private:
-    void encodeVectorSignedNumber(std::vector<int> &numbers, std::string &output) const;
-
-    void encodeNumber(int number_to_encode, std::string &output) const;
+    // writes a zig-zag encoded number to out and returns the position past the last character
+    static char *encodeSignedNumber(int number_to_encode, char *out);
 
   public:
+    // appends the geometry of all necessary segments in a single pass over the polyline
+    void encodePolyline(const std::vector<SegmentInformation> &polyline,
+                        std::string &output) const;
+
     JSON::String printEncodedString(const std::vector<SegmentInformation> &polyline) const;
 
     JSON::Array printUnencodedString(const std::vector<SegmentInformation> &polyline) const;
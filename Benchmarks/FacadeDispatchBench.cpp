@@ -0,0 +1,190 @@
+#include "../DataStructures/QueryEdge.h"
+#include "../DataStructures/SearchEngineData.h"
+#include "../DataStructures/StaticGraph.h"
+#include "../RoutingAlgorithms/BasicRoutingInterface.h"
+#include "../Server/DataStructures/BaseDataFacade.h"
+#include "../Util/OSRMException.h"
+#include "../Util/TimingUtil.h"
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using EdgeData = QueryEdge::EdgeData;
+using QueryGraph = StaticGraph<EdgeData>;
+
+constexpr unsigned RANDOM_SEED = 13;
+
+// search graph only, everything else is not needed to relax edges
+class GraphFacade final : public BaseDataFacade<EdgeData>
+{
+  public:
+    explicit GraphFacade(QueryGraph &graph) : graph(graph) {}
+
+    unsigned GetNumberOfNodes() const final { return graph.GetNumberOfNodes(); }
+    unsigned GetNumberOfEdges() const final { return graph.GetNumberOfEdges(); }
+    unsigned GetOutDegree(const NodeID n) const final { return graph.GetOutDegree(n); }
+    NodeID GetTarget(const EdgeID e) const final { return graph.GetTarget(e); }
+    EdgeData &GetEdgeData(const EdgeID e) const final { return graph.GetEdgeData(e); }
+    EdgeID BeginEdges(const NodeID n) const final { return graph.BeginEdges(n); }
+    EdgeID EndEdges(const NodeID n) const final { return graph.EndEdges(n); }
+    EdgeRange GetAdjacentEdgeRange(const NodeID node) const final
+    {
+        return graph.GetAdjacentEdgeRange(node);
+    }
+    void PrefetchNode(const NodeID n) const final { graph.PrefetchNode(n); }
+    void PrefetchEdges(const NodeID n) const final { graph.PrefetchEdges(n); }
+    EdgeID FindEdge(const NodeID from, const NodeID to) const final
+    {
+        return graph.FindEdge(from, to);
+    }
+    EdgeID FindEdgeInEitherDirection(const NodeID from, const NodeID to) const final
+    {
+        return graph.FindEdgeInEitherDirection(from, to);
+    }
+    EdgeID FindEdgeIndicateIfReverse(const NodeID from, const NodeID to, bool &result) const final
+    {
+        return graph.FindEdgeIndicateIfReverse(from, to, result);
+    }
+
+    FixedPointCoordinate GetCoordinateOfNode(const unsigned) const final { return {}; }
+    bool EdgeIsCompressed(const unsigned) const final { return false; }
+    unsigned GetGeometryIndexForEdgeID(const unsigned) const final { return 0; }
+    void GetUncompressedGeometry(const unsigned, std::vector<unsigned> &) const final {}
+    void GetUncompressedGeometryRanks(const unsigned, std::vector<SimplificationRank> &) const final
+    {
+    }
+    TurnInstruction GetTurnInstructionForEdgeID(const unsigned) const final
+    {
+        return TurnInstruction::NoTurn;
+    }
+    TravelMode GetTravelModeForEdgeID(const unsigned) const final { return TRAVEL_MODE_DEFAULT; }
+    bool LocateClosestEndPointForCoordinate(const FixedPointCoordinate &,
+                                            FixedPointCoordinate &,
+                                            const unsigned) final
+    {
+        throw OSRMException("not supported by benchmark facade");
+    }
+    bool FindPhantomNodeForCoordinate(const FixedPointCoordinate &,
+                                      PhantomNode &,
+                                      const unsigned) final
+    {
+        throw OSRMException("not supported by benchmark facade");
+    }
+    bool IncrementalFindPhantomNodeForCoordinate(const FixedPointCoordinate &,
+                                                 std::vector<PhantomNode> &,
+                                                 const unsigned,
+                                                 const unsigned) final
+    {
+        throw OSRMException("not supported by benchmark facade");
+    }
+    unsigned GetCheckSum() const final { return 0; }
+    unsigned GetNameIndexFromEdgeID(const unsigned) const final { return 0; }
+    void GetName(const unsigned, std::string &result) const final { result.clear(); }
+    std::string GetTimestamp() const final { return ""; }
+    void Prefault(const bool) final {}
+
+  private:
+    QueryGraph &graph;
+};
+
+// road network like degrees, neighbors are close in id space as after renumbering
+std::vector<QueryGraph::InputEdge> GenerateEdges(const unsigned num_nodes)
+{
+    std::mt19937 generator(RANDOM_SEED);
+    std::uniform_int_distribution<unsigned> degree(1, 5);
+    std::uniform_int_distribution<int> offset(-500, 500);
+    std::uniform_int_distribution<int> weight(1, 100);
+    std::vector<QueryGraph::InputEdge> edges;
+    for (unsigned source = 0; source < num_nodes; ++source)
+    {
+        const unsigned out_degree = degree(generator);
+        for (unsigned i = 0; i < out_degree; ++i)
+        {
+            const int target = static_cast<int>(source) + offset(generator);
+            if (target < 0 || target >= static_cast<int>(num_nodes) ||
+                static_cast<unsigned>(target) == source)
+            {
+                continue;
+            }
+            edges.emplace_back(source, target, EdgeData());
+            edges.back().data.id = 0;
+            edges.back().data.shortcut = false;
+            edges.back().data.distance = weight(generator);
+            edges.back().data.forward = true;
+            edges.back().data.backward = true;
+        }
+    }
+    return edges;
+}
+
+// one-to-all searches through the routing step that is shared by all routing algorithms
+template <class DataFacadeT>
+void Benchmark(const std::string &name,
+               DataFacadeT *facade,
+               const std::vector<NodeID> &sources,
+               SearchEngineData::QueryHeap &forward_heap,
+               SearchEngineData::QueryHeap &reverse_heap)
+{
+    const BasicRoutingInterface<DataFacadeT> routing_interface(facade);
+    std::size_t relaxed_edges = 0;
+    std::size_t settled_nodes = 0;
+
+    TIMER_START(search);
+    for (const NodeID source : sources)
+    {
+        forward_heap.Clear();
+        reverse_heap.Clear();
+        forward_heap.Insert(source, 0, source);
+        NodeID middle_node = SPECIAL_NODEID;
+        int upper_bound = std::numeric_limits<int>::max();
+        while (!forward_heap.Empty())
+        {
+            relaxed_edges += facade->GetOutDegree(forward_heap.Min());
+            ++settled_nodes;
+            routing_interface.RoutingStep(
+                forward_heap, reverse_heap, &middle_node, &upper_bound, 0, true);
+        }
+    }
+    TIMER_STOP(search);
+
+    std::cout << name << ": " << relaxed_edges / (TIMER_SEC(search) * 1000000.)
+              << " million relaxed edges/sec, " << TIMER_MSEC(search) / sources.size()
+              << " msec/search, " << settled_nodes << " settled nodes"
+              << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned num_nodes = (argc > 1 ? std::atoi(argv[1]) : 200000);
+    const unsigned num_searches = (argc > 2 ? std::atoi(argv[2]) : 20);
+
+    std::vector<QueryGraph::InputEdge> edges = GenerateEdges(num_nodes);
+    QueryGraph graph(num_nodes, edges);
+    GraphFacade facade(graph);
+    BaseDataFacade<EdgeData> *base_facade = &facade;
+
+    std::mt19937 generator(RANDOM_SEED);
+    std::uniform_int_distribution<NodeID> node(0, num_nodes - 1);
+    std::vector<NodeID> sources(num_searches);
+    std::generate(sources.begin(), sources.end(), [&]()
+                  { return node(generator); });
+
+    SearchEngineData::QueryHeap forward_heap(num_nodes);
+    SearchEngineData::QueryHeap reverse_heap(num_nodes);
+
+    std::cout << "#### " << num_nodes << " nodes, " << graph.GetNumberOfEdges() << " edges"
+              << "\n";
+    // alternate runs so neither variant profits from a warm cache alone
+    for (unsigned run = 0; run < 2; ++run)
+    {
+        Benchmark("virtual facade", base_facade, sources, forward_heap, reverse_heap);
+        Benchmark("final facade", &facade, sources, forward_heap, reverse_heap);
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include "../DataStructures/QueryNode.h"
+#include "../DataStructures/RawRouteData.h"
+#include "../Library/OSRM.h"
+#include "../Util/make_unique.hpp"
+#include "../Util/NUMAUtil.h"
+#include "../Util/OSRMException.h"
+#include "../Util/simple_logger.hpp"
+#include "../Util/TimingUtil.h"
+
+#include <osrm/Reply.h>
+#include <osrm/RouteParameters.h>
+#include <osrm/ServerPaths.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Routes between random coordinates of a dataset on threads bound to every NUMA node at once
+// and reports the throughput of each node for a placement of the dataset:
+//   off        - a single copy loaded on node 0
+//   interleave - a single copy with pages spread over all nodes
+//   replicate  - one copy per node, queried by the threads of that node
+
+constexpr unsigned RANDOM_SEED = 42;
+
+std::vector<FixedPointCoordinate> LoadCoordinates(const boost::filesystem::path &nodes_path)
+{
+    boost::filesystem::ifstream nodes_stream(nodes_path, std::ios::binary);
+    if (!nodes_stream.is_open())
+    {
+        throw OSRMException("could not open " + nodes_path.string());
+    }
+    unsigned number_of_coordinates = 0;
+    nodes_stream.read((char *)&number_of_coordinates, sizeof(unsigned));
+    std::vector<FixedPointCoordinate> coordinates;
+    coordinates.reserve(number_of_coordinates);
+    NodeInfo current_node;
+    for (unsigned i = 0; i < number_of_coordinates; ++i)
+    {
+        nodes_stream.read((char *)&current_node, sizeof(NodeInfo));
+        coordinates.emplace_back(current_node.lat, current_node.lon);
+    }
+    return coordinates;
+}
+
+int main(int argc, char **argv)
+{
+    LogPolicy::GetInstance().Unmute();
+    if (argc < 2)
+    {
+        SimpleLogger().Write(logWARNING) << "usage: " << argv[0]
+                                         << " base.osrm [off|interleave|replicate] "
+                                            "[#queries per thread] [#threads per node]";
+        return 1;
+    }
+    try
+    {
+        const std::string policy = (argc > 2 ? argv[2] : "replicate");
+        const std::vector<unsigned> numa_nodes = GetNUMANodeIds();
+        const unsigned number_of_nodes = static_cast<unsigned>(numa_nodes.size());
+        const unsigned num_queries = (argc > 3 ? std::atoi(argv[3]) : 1000);
+        const unsigned threads_per_node =
+            (argc > 4 ? std::atoi(argv[4])
+                      : std::max(1u, std::thread::hardware_concurrency() / number_of_nodes));
+        if ("off" != policy && "interleave" != policy && "replicate" != policy)
+        {
+            throw OSRMException("unknown policy " + policy);
+        }
+        const bool replicate = ("replicate" == policy);
+
+        ServerPaths server_paths;
+        server_paths["base"] = argv[1];
+        const std::vector<FixedPointCoordinate> coordinates =
+            LoadCoordinates(std::string(argv[1]) + ".nodes");
+
+        const unsigned number_of_replicas = replicate ? number_of_nodes : 1;
+        std::vector<std::unique_ptr<OSRM>> routing_machines(number_of_replicas);
+        for (unsigned replica = 0; replica < number_of_replicas; ++replica)
+        {
+            std::async(std::launch::async,
+                       [&, replica]()
+                       {
+                           if ("interleave" == policy)
+                           {
+                               SetInterleavedAllocation(true);
+                           }
+                           else
+                           {
+                               BindCurrentThreadToNUMANode(numa_nodes[replica]);
+                           }
+                           routing_machines[replica] = osrm::make_unique<OSRM>(server_paths);
+                       }).get();
+        }
+
+        std::vector<double> seconds_per_node(number_of_nodes, 0.);
+        std::vector<std::atomic<unsigned>> routes_per_node(number_of_nodes);
+        std::vector<std::thread> threads;
+        for (unsigned node = 0; node < number_of_nodes; ++node)
+        {
+            routes_per_node[node] = 0;
+            for (unsigned i = 0; i < threads_per_node; ++i)
+            {
+                threads.emplace_back(
+                    [&, node, i]()
+                    {
+                        BindCurrentThreadToNUMANode(numa_nodes[node]);
+                        OSRM &routing_machine = *routing_machines[replicate ? node : 0];
+                        std::mt19937 generator(RANDOM_SEED + node * threads_per_node + i);
+                        std::uniform_int_distribution<std::size_t> coordinate_index(
+                            0, coordinates.size() - 1);
+
+                        TIMER_START(queries);
+                        for (unsigned query = 0; query < num_queries; ++query)
+                        {
+                            RouteParameters route_parameters;
+                            route_parameters.service = "viaroute";
+                            route_parameters.coordinates.emplace_back(
+                                coordinates[coordinate_index(generator)]);
+                            route_parameters.coordinates.emplace_back(
+                                coordinates[coordinate_index(generator)]);
+                            RawRouteData raw_route;
+                            if (http::Reply::ok ==
+                                routing_machine.Route(route_parameters, raw_route))
+                            {
+                                ++routes_per_node[node];
+                            }
+                        }
+                        TIMER_STOP(queries);
+                        // the threads of a node run concurrently, count the slowest one
+                        static std::mutex seconds_mutex;
+                        std::lock_guard<std::mutex> lock(seconds_mutex);
+                        seconds_per_node[node] =
+                            std::max(seconds_per_node[node], TIMER_SEC(queries));
+                    });
+            }
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        std::cout << "policy " << policy << ", " << number_of_nodes << " numa node(s), "
+                  << threads_per_node << " thread(s) per node" << std::endl;
+        for (unsigned node = 0; node < number_of_nodes; ++node)
+        {
+            std::cout << "node " << numa_nodes[node] << ": "
+                      << (threads_per_node * num_queries / seconds_per_node[node])
+                      << " queries/s, " << routes_per_node[node].load() << " routes found"
+                      << std::endl;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        SimpleLogger().Write(logWARNING) << "exception: " << e.what();
+        return 1;
+    }
+    return 0;
+}
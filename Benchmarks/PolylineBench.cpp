@@ -0,0 +1,70 @@
+#include "../Algorithms/PolylineCompressor.h"
+#include "../DataStructures/SegmentInformation.h"
+#include "../Util/TimingUtil.h"
+
+#include <osrm/Coordinate.h>
+
+#include <cstdlib>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// random walk with street-like step sizes, every fourth point is dropped by generalization
+std::vector<SegmentInformation> GenerateRoute(const unsigned num_points)
+{
+    std::mt19937 generator(1337);
+    std::uniform_int_distribution<int> step(-2000, 2000);
+    std::vector<SegmentInformation> polyline;
+    polyline.reserve(num_points);
+    FixedPointCoordinate coordinate(52500000, 13400000);
+    for (unsigned i = 0; i < num_points; ++i)
+    {
+        coordinate.lat += step(generator);
+        coordinate.lon += step(generator);
+        polyline.emplace_back(coordinate,
+                              0,
+                              10,
+                              1.f,
+                              TurnInstruction::NoTurn,
+                              (0 != i % 4),
+                              false,
+                              TRAVEL_MODE_DEFAULT);
+    }
+    return polyline;
+}
+
+void Benchmark(const unsigned num_points, const unsigned num_runs)
+{
+    const std::vector<SegmentInformation> polyline = GenerateRoute(num_points);
+    PolylineCompressor polyline_compressor;
+    std::size_t checksum = 0;
+
+    std::cout << "#### " << num_points << " points, " << num_runs << " runs"
+              << "\n";
+    TIMER_START(encode);
+    for (unsigned i = 0; i < num_runs; ++i)
+    {
+        std::string output;
+        polyline_compressor.encodePolyline(polyline, output);
+        checksum += output.size();
+    }
+    TIMER_STOP(encode);
+    const double nsec_per_run = TIMER_NSEC(encode) / static_cast<double>(num_runs);
+    std::cout << nsec_per_run / num_points << " nsec/point, "
+              << (num_points * sizeof(SegmentInformation)) / nsec_per_run
+              << " GB/s of input read."
+              << "\n";
+
+    // keeps the loop from being optimized away
+    std::cout << "checksum: " << checksum << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned num_runs = (argc > 1 ? std::atoi(argv[1]) : 100);
+    Benchmark(50000, num_runs);
+    Benchmark(500, num_runs * 100);
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include "../DataStructures/QueryEdge.h"
+#include "../DataStructures/SearchEngineData.h"
+#include "../DataStructures/StaticGraph.h"
+#include "../RoutingAlgorithms/BasicRoutingInterface.h"
+#include "../Server/DataStructures/BaseDataFacade.h"
+#include "../Util/GraphLoader.h"
+#include "../Util/OSRMException.h"
+#include "../Util/simple_logger.hpp"
+#include "../Util/TimingUtil.h"
+
+#include <boost/filesystem.hpp>
+
+#include <cstdlib>
+
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using EdgeData = QueryEdge::EdgeData;
+using QueryGraph = StaticGraph<EdgeData>;
+
+constexpr unsigned RANDOM_SEED = 42;
+
+// search graph only, prefetching can be switched off to measure its effect
+template <bool UsePrefetch> class GraphFacade final : public BaseDataFacade<EdgeData>
+{
+  public:
+    explicit GraphFacade(QueryGraph &graph) : graph(graph) {}
+
+    unsigned GetNumberOfNodes() const final { return graph.GetNumberOfNodes(); }
+    unsigned GetNumberOfEdges() const final { return graph.GetNumberOfEdges(); }
+    unsigned GetOutDegree(const NodeID n) const final { return graph.GetOutDegree(n); }
+    NodeID GetTarget(const EdgeID e) const final { return graph.GetTarget(e); }
+    EdgeData &GetEdgeData(const EdgeID e) const final { return graph.GetEdgeData(e); }
+    EdgeID BeginEdges(const NodeID n) const final { return graph.BeginEdges(n); }
+    EdgeID EndEdges(const NodeID n) const final { return graph.EndEdges(n); }
+    EdgeRange GetAdjacentEdgeRange(const NodeID node) const final
+    {
+        return graph.GetAdjacentEdgeRange(node);
+    }
+    void PrefetchNode(const NodeID n) const final
+    {
+        if (UsePrefetch)
+        {
+            graph.PrefetchNode(n);
+        }
+    }
+    void PrefetchEdges(const NodeID n) const final
+    {
+        if (UsePrefetch)
+        {
+            graph.PrefetchEdges(n);
+        }
+    }
+    EdgeID FindEdge(const NodeID from, const NodeID to) const final
+    {
+        return graph.FindEdge(from, to);
+    }
+    EdgeID FindEdgeInEitherDirection(const NodeID from, const NodeID to) const final
+    {
+        return graph.FindEdgeInEitherDirection(from, to);
+    }
+    EdgeID FindEdgeIndicateIfReverse(const NodeID from, const NodeID to, bool &result) const final
+    {
+        return graph.FindEdgeIndicateIfReverse(from, to, result);
+    }
+
+    FixedPointCoordinate GetCoordinateOfNode(const unsigned) const final { return {}; }
+    bool EdgeIsCompressed(const unsigned) const final { return false; }
+    unsigned GetGeometryIndexForEdgeID(const unsigned) const final { return 0; }
+    void GetUncompressedGeometry(const unsigned, std::vector<unsigned> &) const final {}
+    void GetUncompressedGeometryRanks(const unsigned, std::vector<SimplificationRank> &) const final
+    {
+    }
+    TurnInstruction GetTurnInstructionForEdgeID(const unsigned) const final
+    {
+        return TurnInstruction::NoTurn;
+    }
+    TravelMode GetTravelModeForEdgeID(const unsigned) const final { return TRAVEL_MODE_DEFAULT; }
+    bool LocateClosestEndPointForCoordinate(const FixedPointCoordinate &,
+                                            FixedPointCoordinate &,
+                                            const unsigned) final
+    {
+        throw OSRMException("not supported by benchmark facade");
+    }
+    bool FindPhantomNodeForCoordinate(const FixedPointCoordinate &,
+                                      PhantomNode &,
+                                      const unsigned) final
+    {
+        throw OSRMException("not supported by benchmark facade");
+    }
+    bool IncrementalFindPhantomNodeForCoordinate(const FixedPointCoordinate &,
+                                                 std::vector<PhantomNode> &,
+                                                 const unsigned,
+                                                 const unsigned) final
+    {
+        throw OSRMException("not supported by benchmark facade");
+    }
+    unsigned GetCheckSum() const final { return 0; }
+    unsigned GetNameIndexFromEdgeID(const unsigned) const final { return 0; }
+    void GetName(const unsigned, std::string &result) const final { result.clear(); }
+    std::string GetTimestamp() const final { return ""; }
+    void Prefault(const bool) final {}
+
+  private:
+    QueryGraph &graph;
+};
+
+// node to node CH queries with the same alternation as the shortest path search
+template <unsigned Arity, bool UsePrefetch>
+void Benchmark(QueryGraph &graph, const std::vector<std::pair<NodeID, NodeID>> &queries)
+{
+    using QueryHeap =
+        BinaryHeap<NodeID, NodeID, int, HeapData, UnorderedMapStorage<NodeID, int>, Arity>;
+    using FacadeT = GraphFacade<UsePrefetch>;
+
+    FacadeT facade(graph);
+    const BasicRoutingInterface<FacadeT> routing_interface(&facade);
+    QueryHeap forward_heap(graph.GetNumberOfNodes());
+    QueryHeap reverse_heap(graph.GetNumberOfNodes());
+    std::size_t settled_nodes = 0;
+    std::size_t checksum = 0;
+
+    TIMER_START(queries);
+    for (const auto &query : queries)
+    {
+        forward_heap.Clear();
+        reverse_heap.Clear();
+        forward_heap.Insert(query.first, 0, query.first);
+        reverse_heap.Insert(query.second, 0, query.second);
+        NodeID middle_node = SPECIAL_NODEID;
+        int upper_bound = std::numeric_limits<int>::max();
+        while (0 < (forward_heap.Size() + reverse_heap.Size()))
+        {
+            if (!forward_heap.Empty())
+            {
+                routing_interface.RoutingStep(
+                    forward_heap, reverse_heap, &middle_node, &upper_bound, 0, true);
+                ++settled_nodes;
+            }
+            if (!reverse_heap.Empty())
+            {
+                routing_interface.RoutingStep(
+                    reverse_heap, forward_heap, &middle_node, &upper_bound, 0, false);
+                ++settled_nodes;
+            }
+        }
+        checksum += upper_bound;
+    }
+    TIMER_STOP(queries);
+
+    std::cout << Arity << "-ary heap, prefetch " << (UsePrefetch ? "on:  " : "off: ")
+              << settled_nodes / static_cast<double>(TIMER_NSEC(queries) / 1000.)
+              << " settled nodes/usec, " << TIMER_MSEC(queries) / (double)queries.size()
+              << " msec/query (checksum " << checksum << ")"
+              << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    LogPolicy::GetInstance().Unmute();
+    if (argc < 2)
+    {
+        SimpleLogger().Write(logWARNING) << "usage: " << argv[0] << " file.hsgr [#queries]";
+        return 1;
+    }
+    const unsigned num_queries = (argc > 2 ? std::atoi(argv[2]) : 1000);
+
+    std::vector<QueryGraph::NodeArrayEntry> node_list;
+    std::vector<QueryGraph::EdgeArrayEntry> edge_list;
+    unsigned check_sum = 0;
+    readHSGRFromStream(boost::filesystem::path(argv[1]), node_list, edge_list, &check_sum);
+    QueryGraph graph(node_list, edge_list);
+
+    std::mt19937 generator(RANDOM_SEED);
+    std::uniform_int_distribution<NodeID> node(0, graph.GetNumberOfNodes() - 1);
+    std::vector<std::pair<NodeID, NodeID>> queries;
+    for (unsigned i = 0; i < num_queries; ++i)
+    {
+        queries.emplace_back(node(generator), node(generator));
+    }
+
+    // alternate variants so neither profits from a warm cache alone
+    for (unsigned run = 0; run < 2; ++run)
+    {
+        Benchmark<2, false>(graph, queries);
+        Benchmark<2, true>(graph, queries);
+        Benchmark<4, false>(graph, queries);
+        Benchmark<4, true>(graph, queries);
+    }
+    return 0;
+}
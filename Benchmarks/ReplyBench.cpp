@@ -0,0 +1,56 @@
+#include "../Util/TimingUtil.h"
+
+#include <osrm/Reply.h>
+
+#include <boost/asio.hpp>
+
+#include <cstdlib>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// framing cost of a typical json reply, i.e. status line, headers and buffer sequence
+void Benchmark(const unsigned num_replies, const std::size_t content_size)
+{
+    http::Reply reply;
+    reply.content.resize(content_size, 'x');
+    reply.format = http::Reply::jsonFormat;
+
+    std::size_t checksum = 0;
+
+    std::cout << "#### uncompressed, " << content_size << " bytes of content"
+              << "\n";
+    TIMER_START(uncompressed);
+    for (unsigned i = 0; i < num_replies; ++i)
+    {
+        const auto buffers = reply.ToBuffers();
+        checksum += boost::asio::buffer_size(buffers[0]);
+    }
+    TIMER_STOP(uncompressed);
+    std::cout << TIMER_NSEC(uncompressed) / static_cast<double>(num_replies) << " nsec/reply."
+              << "\n";
+
+    std::cout << "#### compressed, additional header"
+              << "\n";
+    reply.headers.emplace_back("Retry-After", "1");
+    TIMER_START(compressed);
+    for (unsigned i = 0; i < num_replies; ++i)
+    {
+        const auto buffer = reply.HeaderstoBuffer(content_size / 4 + i % 10, "gzip");
+        checksum += boost::asio::buffer_size(buffer);
+    }
+    TIMER_STOP(compressed);
+    std::cout << TIMER_NSEC(compressed) / static_cast<double>(num_replies) << " nsec/reply."
+              << "\n";
+
+    // keeps the loops from being optimized away
+    std::cout << "checksum: " << checksum << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned num_replies = (argc > 1 ? std::atoi(argv[1]) : 1000000);
+    Benchmark(num_replies, 16 * 1024);
+    return 0;
+}
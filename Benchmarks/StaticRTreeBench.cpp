@@ -7,6 +7,7 @@
 
 #include <osrm/Coordinate.h>
 
+#include <iostream>
 #include <random>
 
 // Choosen by a fair W20 dice roll (this value is completely arbitrary)
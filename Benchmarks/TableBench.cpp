@@ -0,0 +1,366 @@
+#include "../Algorithms/ObjectToBase64.h"
+#include "../DataStructures/PhantomNodes.h"
+#include "../DataStructures/QueryContextPool.h"
+#include "../DataStructures/QueryDeadline.h"
+#include "../DataStructures/QueryEdge.h"
+#include "../DataStructures/QueryNode.h"
+#include "../DataStructures/StaticGraph.h"
+#include "../Library/OSRM.h"
+#include "../Plugins/DistanceTablePlugin.h"
+#include "../RoutingAlgorithms/ManyToManyRouting.h"
+#include "../Server/DataStructures/BaseDataFacade.h"
+#include "../Util/GraphLoader.h"
+#include "../Util/OSRMException.h"
+#include "../Util/simple_logger.hpp"
+#include "../Util/TimingUtil.h"
+
+#include <osrm/Reply.h>
+#include <osrm/RouteParameters.h>
+#include <osrm/ServerPaths.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using EdgeData = QueryEdge::EdgeData;
+using QueryGraph = StaticGraph<EdgeData>;
+
+constexpr unsigned RANDOM_SEED = 42;
+
+// search graph only, unpacked paths carry no names, turns or geometry
+class GraphFacade final : public BaseDataFacade<EdgeData>
+{
+  public:
+    explicit GraphFacade(QueryGraph &graph) : graph(graph) {}
+
+    unsigned GetNumberOfNodes() const final { return graph.GetNumberOfNodes(); }
+    unsigned GetNumberOfEdges() const final { return graph.GetNumberOfEdges(); }
+    unsigned GetOutDegree(const NodeID n) const final { return graph.GetOutDegree(n); }
+    NodeID GetTarget(const EdgeID e) const final { return graph.GetTarget(e); }
+    EdgeData &GetEdgeData(const EdgeID e) const final { return graph.GetEdgeData(e); }
+    EdgeID BeginEdges(const NodeID n) const final { return graph.BeginEdges(n); }
+    EdgeID EndEdges(const NodeID n) const final { return graph.EndEdges(n); }
+    EdgeRange GetAdjacentEdgeRange(const NodeID node) const final
+    {
+        return graph.GetAdjacentEdgeRange(node);
+    }
+    void PrefetchNode(const NodeID n) const final { graph.PrefetchNode(n); }
+    void PrefetchEdges(const NodeID n) const final { graph.PrefetchEdges(n); }
+    EdgeID FindEdge(const NodeID from, const NodeID to) const final
+    {
+        return graph.FindEdge(from, to);
+    }
+    EdgeID FindEdgeInEitherDirection(const NodeID from, const NodeID to) const final
+    {
+        return graph.FindEdgeInEitherDirection(from, to);
+    }
+    EdgeID FindEdgeIndicateIfReverse(const NodeID from, const NodeID to, bool &result) const final
+    {
+        return graph.FindEdgeIndicateIfReverse(from, to, result);
+    }
+
+    FixedPointCoordinate GetCoordinateOfNode(const unsigned) const final { return {}; }
+    bool EdgeIsCompressed(const unsigned) const final { return false; }
+    unsigned GetGeometryIndexForEdgeID(const unsigned) const final { return 0; }
+    void GetUncompressedGeometry(const unsigned, std::vector<unsigned> &) const final {}
+    void GetUncompressedGeometryRanks(const unsigned, std::vector<SimplificationRank> &) const final
+    {
+    }
+    TurnInstruction GetTurnInstructionForEdgeID(const unsigned) const final
+    {
+        return TurnInstruction::NoTurn;
+    }
+    TravelMode GetTravelModeForEdgeID(const unsigned) const final { return TRAVEL_MODE_DEFAULT; }
+    bool LocateClosestEndPointForCoordinate(const FixedPointCoordinate &,
+                                            FixedPointCoordinate &,
+                                            const unsigned) final
+    {
+        throw OSRMException("not supported by benchmark facade");
+    }
+    bool FindPhantomNodeForCoordinate(const FixedPointCoordinate &,
+                                      PhantomNode &,
+                                      const unsigned) final
+    {
+        throw OSRMException("not supported by benchmark facade");
+    }
+    bool IncrementalFindPhantomNodeForCoordinate(const FixedPointCoordinate &,
+                                                 std::vector<PhantomNode> &,
+                                                 const unsigned,
+                                                 const unsigned) final
+    {
+        throw OSRMException("not supported by benchmark facade");
+    }
+    unsigned GetCheckSum() const final { return 0; }
+    unsigned GetNameIndexFromEdgeID(const unsigned) const final { return 0; }
+    void GetName(const unsigned, std::string &result) const final { result.clear(); }
+    std::string GetTimestamp() const final { return ""; }
+    void Prefault(const bool) final {}
+
+  private:
+    QueryGraph &graph;
+};
+
+// one phantom node per location on random nodes of the graph
+PhantomNodeArray GenerateLocations(const QueryGraph &graph, const unsigned num_locations)
+{
+    std::mt19937 generator(RANDOM_SEED);
+    std::uniform_int_distribution<NodeID> node(0, graph.GetNumberOfNodes() - 1);
+    PhantomNodeArray locations(num_locations);
+    for (std::vector<PhantomNode> &location : locations)
+    {
+        PhantomNode phantom_node;
+        phantom_node.forward_node_id = node(generator);
+        phantom_node.reverse_node_id = node(generator);
+        phantom_node.forward_weight = 0;
+        phantom_node.reverse_weight = 0;
+        location.emplace_back(phantom_node);
+    }
+    return locations;
+}
+
+std::shared_ptr<std::vector<EdgeWeight>> Benchmark(GraphFacade &facade,
+                                                   QueryContextPool &query_contexts,
+                                                   const PhantomNodeArray &sources,
+                                                   const PhantomNodeArray &targets,
+                                                   const bool with_lengths)
+{
+    const ManyToManyRouting<GraphFacade> distance_table(&facade, query_contexts);
+    std::vector<EdgeWeight> length_table;
+
+    TIMER_START(table);
+    QueryDeadline deadline;
+    std::shared_ptr<std::vector<EdgeWeight>> result_table =
+        distance_table(sources, targets, deadline, with_lengths ? &length_table : nullptr);
+    TIMER_STOP(table);
+
+    std::cout << (with_lengths ? "durations and lengths" : "durations") << ": "
+              << TIMER_MSEC(table) << " msec for " << sources.size() << "x" << targets.size()
+              << "\n";
+    return result_table;
+}
+
+// Runs a few sources against many targets through the plugin with the limits of the table
+// service. The locations are given as hints, so the graph alone is enough to snap them.
+bool ComputeHTTPSizedTable(GraphFacade &facade,
+                           QueryContextPool &query_contexts,
+                           const PhantomNodeArray &sources,
+                           const PhantomNodeArray &targets)
+{
+    QueryTimeLimit time_limit(0);
+    DistanceTablePlugin<GraphFacade> table_plugin(&facade, query_contexts, time_limit);
+    RouteParameters route_parameters;
+    route_parameters.setChecksum(facade.GetCheckSum());
+    for (const PhantomNodeArray *locations : {&sources, &targets})
+    {
+        for (const std::vector<PhantomNode> &location : *locations)
+        {
+            PhantomNode phantom_node = location.front();
+            phantom_node.location = FixedPointCoordinate(0, 0);
+            phantom_node.name_id = 0;
+            std::string hint;
+            ObjectEncoder::EncodeToBase64(phantom_node, hint);
+            route_parameters.coordinates.emplace_back(phantom_node.location);
+            route_parameters.hints.emplace_back(std::move(hint));
+            route_parameters.is_source.push_back(&sources == locations);
+            route_parameters.is_destination.push_back(&targets == locations);
+        }
+    }
+
+    std::shared_ptr<std::vector<EdgeWeight>> result_table;
+    TIMER_START(table);
+    const http::Reply::status_type status =
+        table_plugin.ComputeTable(route_parameters, result_table);
+    TIMER_STOP(table);
+    if (http::Reply::ok != status)
+    {
+        SimpleLogger().Write(logWARNING) << "table plugin rejected " << sources.size() << "x"
+                                         << targets.size() << " with status " << status;
+        return false;
+    }
+    std::cout << "table plugin: " << TIMER_MSEC(table) << " msec for " << sources.size() << "x"
+              << targets.size() << "\n";
+
+    const std::shared_ptr<std::vector<EdgeWeight>> expected_table =
+        Benchmark(facade, query_contexts, sources, targets, false);
+    return *result_table == *expected_table;
+}
+
+std::vector<FixedPointCoordinate> LoadCoordinates(const boost::filesystem::path &nodes_path)
+{
+    boost::filesystem::ifstream nodes_stream(nodes_path, std::ios::binary);
+    if (!nodes_stream.is_open())
+    {
+        throw OSRMException("could not open " + nodes_path.string());
+    }
+    unsigned number_of_coordinates = 0;
+    nodes_stream.read((char *)&number_of_coordinates, sizeof(unsigned));
+    std::vector<FixedPointCoordinate> coordinates;
+    coordinates.reserve(number_of_coordinates);
+    NodeInfo current_node;
+    for (unsigned i = 0; i < number_of_coordinates; ++i)
+    {
+        nodes_stream.read((char *)&current_node, sizeof(NodeInfo));
+        coordinates.emplace_back(current_node.lat, current_node.lon);
+    }
+    return coordinates;
+}
+
+// total_distance of the route summary in meters, or -1 if no route was found
+int GetRouteDistance(OSRM &routing_machine,
+                     const FixedPointCoordinate &source,
+                     const FixedPointCoordinate &target)
+{
+    RouteParameters route_parameters;
+    route_parameters.service = "viaroute";
+    route_parameters.alternate_route = false;
+    route_parameters.geometry = false;
+    route_parameters.coordinates = {source, target};
+    http::Reply reply;
+    routing_machine.RunQuery(route_parameters, reply);
+
+    const std::string content(reply.content.begin(), reply.content.end());
+    const std::string key = "\"total_distance\":";
+    const std::string::size_type position = content.find(key);
+    if (http::Reply::ok != reply.status || std::string::npos == position)
+    {
+        return -1;
+    }
+    return std::atoi(content.c_str() + position + key.size());
+}
+
+// The lengths of the table are summed up from the segment lengths that osrm-prepare rounded to
+// decimeters, while viaroute measures the unpacked geometry with an approximate distance. Both
+// describe the same paths, so they may only differ by rounding.
+bool CompareLengthsWithRoutes(const boost::filesystem::path &base, const unsigned num_locations)
+{
+    ServerPaths server_paths;
+    server_paths["base"] = base;
+    OSRM routing_machine(server_paths);
+
+    const std::vector<FixedPointCoordinate> coordinates =
+        LoadCoordinates(base.string() + ".nodes");
+    std::mt19937 generator(RANDOM_SEED);
+    std::uniform_int_distribution<std::size_t> coordinate_index(0, coordinates.size() - 1);
+    RouteParameters table_parameters;
+    table_parameters.service = "table";
+    for (unsigned i = 0; i < num_locations; ++i)
+    {
+        table_parameters.coordinates.emplace_back(coordinates[coordinate_index(generator)]);
+    }
+    std::vector<int> durations, lengths;
+    if (http::Reply::ok != routing_machine.Table(table_parameters, durations, lengths))
+    {
+        SimpleLogger().Write(logWARNING) << "table query failed";
+        return false;
+    }
+
+    unsigned compared = 0, mismatches = 0;
+    for (unsigned source = 0; source < num_locations; ++source)
+    {
+        for (unsigned target = 0; target < num_locations; ++target)
+        {
+            const int length = lengths[source * num_locations + target];
+            if (source == target || std::numeric_limits<int>::max() == length)
+            {
+                continue;
+            }
+            const int route_distance = GetRouteDistance(routing_machine,
+                                                        table_parameters.coordinates[source],
+                                                        table_parameters.coordinates[target]);
+            ++compared;
+            // one meter for the rounding of the summary and 0.5% for the distance approximations
+            if (route_distance < 0 || std::abs(length - route_distance) > 1 + route_distance / 200)
+            {
+                ++mismatches;
+                SimpleLogger().Write(logDEBUG) << "length " << length << " m, route "
+                                               << route_distance << " m";
+            }
+        }
+    }
+    std::cout << "lengths: " << compared << " compared with viaroute, " << mismatches
+              << " differ\n";
+    return 0 == mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    LogPolicy::GetInstance().Unmute();
+    if (argc < 2)
+    {
+        SimpleLogger().Write(logWARNING) << "usage: " << argv[0]
+                                         << " file.hsgr [#locations] [#locations for viaroute]";
+        return 1;
+    }
+    const unsigned num_locations = (argc > 2 ? std::atoi(argv[2]) : 500);
+    const unsigned num_route_locations = (argc > 3 ? std::atoi(argv[3]) : 20);
+
+    std::vector<QueryGraph::NodeArrayEntry> node_list;
+    std::vector<QueryGraph::EdgeArrayEntry> edge_list;
+    unsigned check_sum = 0;
+    readHSGRFromStream(boost::filesystem::path(argv[1]), node_list, edge_list, &check_sum);
+    QueryGraph graph(node_list, edge_list);
+    GraphFacade facade(graph);
+    QueryContextPool query_contexts;
+
+    const PhantomNodeArray locations = GenerateLocations(graph, num_locations);
+
+    // tracking the lengths must not change the durations
+    for (unsigned run = 0; run < 2; ++run)
+    {
+        const std::shared_ptr<std::vector<EdgeWeight>> durations =
+            Benchmark(facade, query_contexts, locations, locations, false);
+        const std::shared_ptr<std::vector<EdgeWeight>> durations_with_lengths =
+            Benchmark(facade, query_contexts, locations, locations, true);
+        if (*durations != *durations_with_lengths)
+        {
+            SimpleLogger().Write(logWARNING) << "durations differ";
+            return 1;
+        }
+    }
+
+    // a few sources against all locations must give the first rows of the square table
+    const PhantomNodeArray sources(locations.begin(),
+                                   locations.begin() + std::min(5u, num_locations));
+    const std::shared_ptr<std::vector<EdgeWeight>> square_table =
+        Benchmark(facade, query_contexts, locations, locations, false);
+    const std::shared_ptr<std::vector<EdgeWeight>> rectangular_table =
+        Benchmark(facade, query_contexts, sources, locations, false);
+    if (!std::equal(rectangular_table->begin(), rectangular_table->end(), square_table->begin()))
+    {
+        SimpleLogger().Write(logWARNING) << "rectangular table differs";
+        return 1;
+    }
+
+    // the motivating case of rectangular tables has to pass the limits of the table service
+    const PhantomNodeArray orders = GenerateLocations(graph, 2000);
+    if (!ComputeHTTPSizedTable(facade, query_contexts, sources, orders))
+    {
+        SimpleLogger().Write(logWARNING) << "table plugin differs from the search";
+        return 1;
+    }
+
+    // the lengths can only be compared with routes if the rest of the dataset is available
+    const boost::filesystem::path base = boost::filesystem::path(argv[1]).replace_extension();
+    if (!boost::filesystem::exists(base.string() + ".nodes"))
+    {
+        SimpleLogger().Write() << "no dataset " << base.string()
+                               << ", not comparing lengths with viaroute";
+        return 0;
+    }
+    if (!CompareLengthsWithRoutes(base, num_route_locations))
+    {
+        SimpleLogger().Write(logWARNING) << "lengths differ from viaroute";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,297 @@
+#include "../DataStructures/PhantomNodes.h"
+#include "../DataStructures/QueryContextPool.h"
+#include "../DataStructures/QueryDeadline.h"
+#include "../DataStructures/QueryEdge.h"
+#include "../DataStructures/RawRouteData.h"
+#include "../DataStructures/StaticGraph.h"
+#include "../RoutingAlgorithms/AlternativePathRouting.h"
+#include "../RoutingAlgorithms/ShortestPathRouting.h"
+#include "../Server/DataStructures/BaseDataFacade.h"
+#include "../Util/GraphLoader.h"
+#include "../Util/OSRMException.h"
+#include "../Util/simple_logger.hpp"
+#include "../Util/TimingUtil.h"
+
+#include <boost/filesystem.hpp>
+
+#include <cstdlib>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using EdgeData = QueryEdge::EdgeData;
+using QueryGraph = StaticGraph<EdgeData>;
+
+constexpr unsigned RANDOM_SEED = 42;
+
+// search graph only, unpacked paths carry no names, turns or geometry
+class GraphFacade final : public BaseDataFacade<EdgeData>
+{
+  public:
+    explicit GraphFacade(QueryGraph &graph) : graph(graph) {}
+
+    unsigned GetNumberOfNodes() const final { return graph.GetNumberOfNodes(); }
+    unsigned GetNumberOfEdges() const final { return graph.GetNumberOfEdges(); }
+    unsigned GetOutDegree(const NodeID n) const final { return graph.GetOutDegree(n); }
+    NodeID GetTarget(const EdgeID e) const final { return graph.GetTarget(e); }
+    EdgeData &GetEdgeData(const EdgeID e) const final { return graph.GetEdgeData(e); }
+    EdgeID BeginEdges(const NodeID n) const final { return graph.BeginEdges(n); }
+    EdgeID EndEdges(const NodeID n) const final { return graph.EndEdges(n); }
+    EdgeRange GetAdjacentEdgeRange(const NodeID node) const final
+    {
+        return graph.GetAdjacentEdgeRange(node);
+    }
+    void PrefetchNode(const NodeID n) const final { graph.PrefetchNode(n); }
+    void PrefetchEdges(const NodeID n) const final { graph.PrefetchEdges(n); }
+    EdgeID FindEdge(const NodeID from, const NodeID to) const final
+    {
+        return graph.FindEdge(from, to);
+    }
+    EdgeID FindEdgeInEitherDirection(const NodeID from, const NodeID to) const final
+    {
+        return graph.FindEdgeInEitherDirection(from, to);
+    }
+    EdgeID FindEdgeIndicateIfReverse(const NodeID from, const NodeID to, bool &result) const final
+    {
+        return graph.FindEdgeIndicateIfReverse(from, to, result);
+    }
+
+    FixedPointCoordinate GetCoordinateOfNode(const unsigned) const final { return {}; }
+    bool EdgeIsCompressed(const unsigned) const final { return false; }
+    unsigned GetGeometryIndexForEdgeID(const unsigned) const final { return 0; }
+    void GetUncompressedGeometry(const unsigned, std::vector<unsigned> &) const final {}
+    void GetUncompressedGeometryRanks(const unsigned, std::vector<SimplificationRank> &) const final
+    {
+    }
+    TurnInstruction GetTurnInstructionForEdgeID(const unsigned) const final
+    {
+        return TurnInstruction::NoTurn;
+    }
+    TravelMode GetTravelModeForEdgeID(const unsigned) const final { return TRAVEL_MODE_DEFAULT; }
+    bool LocateClosestEndPointForCoordinate(const FixedPointCoordinate &,
+                                            FixedPointCoordinate &,
+                                            const unsigned) final
+    {
+        throw OSRMException("not supported by benchmark facade");
+    }
+    bool FindPhantomNodeForCoordinate(const FixedPointCoordinate &,
+                                      PhantomNode &,
+                                      const unsigned) final
+    {
+        throw OSRMException("not supported by benchmark facade");
+    }
+    bool IncrementalFindPhantomNodeForCoordinate(const FixedPointCoordinate &,
+                                                 std::vector<PhantomNode> &,
+                                                 const unsigned,
+                                                 const unsigned) final
+    {
+        throw OSRMException("not supported by benchmark facade");
+    }
+    unsigned GetCheckSum() const final { return 0; }
+    unsigned GetNameIndexFromEdgeID(const unsigned) const final { return 0; }
+    void GetName(const unsigned, std::string &result) const final { result.clear(); }
+    std::string GetTimestamp() const final { return ""; }
+    void Prefault(const bool) final {}
+
+  private:
+    QueryGraph &graph;
+};
+
+struct Tour
+{
+    std::vector<PhantomNodes> legs;
+    std::vector<bool> uturns;
+};
+
+// stops on random nodes, u-turns are allowed at every u-th via point
+std::vector<Tour> GenerateTours(const QueryGraph &graph,
+                                const unsigned num_tours,
+                                const unsigned num_stops,
+                                const unsigned uturn_interval)
+{
+    std::mt19937 generator(RANDOM_SEED);
+    std::uniform_int_distribution<NodeID> node(0, graph.GetNumberOfNodes() - 1);
+    std::vector<Tour> tours(num_tours);
+    for (Tour &tour : tours)
+    {
+        std::vector<PhantomNode> stops(num_stops);
+        for (PhantomNode &stop : stops)
+        {
+            stop.forward_node_id = node(generator);
+            stop.reverse_node_id = node(generator);
+            stop.forward_weight = 0;
+            stop.reverse_weight = 0;
+        }
+        for (unsigned stop = 0; stop + 1 < num_stops; ++stop)
+        {
+            PhantomNodes leg;
+            leg.source_phantom = stops[stop];
+            leg.target_phantom = stops[stop + 1];
+            tour.legs.emplace_back(leg);
+        }
+        tour.uturns.resize(num_stops, false);
+        for (unsigned stop = uturn_interval; stop < num_stops; stop += uturn_interval)
+        {
+            tour.uturns[stop - 1] = true;
+        }
+    }
+    return tours;
+}
+
+bool IsSamePath(const std::vector<PathData> &lhs_path, const std::vector<PathData> &rhs_path)
+{
+    if (lhs_path.size() != rhs_path.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs_path.size(); ++i)
+    {
+        if (lhs_path[i].node != rhs_path[i].node ||
+            lhs_path[i].segment_duration != rhs_path[i].segment_duration)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IsSameRoute(const RawRouteData &lhs, const RawRouteData &rhs)
+{
+    if (lhs.shortest_path_length != rhs.shortest_path_length ||
+        lhs.alternative_path_lengths != rhs.alternative_path_lengths ||
+        lhs.source_traversed_in_reverse != rhs.source_traversed_in_reverse ||
+        lhs.target_traversed_in_reverse != rhs.target_traversed_in_reverse ||
+        lhs.unpacked_path_segments.size() != rhs.unpacked_path_segments.size())
+    {
+        return false;
+    }
+    for (std::size_t leg = 0; leg < lhs.unpacked_path_segments.size(); ++leg)
+    {
+        if (!IsSamePath(lhs.unpacked_path_segments[leg], rhs.unpacked_path_segments[leg]))
+        {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < lhs.unpacked_alternatives.size(); ++i)
+    {
+        if (!IsSamePath(lhs.unpacked_alternatives[i], rhs.unpacked_alternatives[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<RawRouteData> Benchmark(GraphFacade &facade,
+                                    QueryContextPool &query_contexts,
+                                    const std::vector<Tour> &tours,
+                                    const bool parallel_legs)
+{
+    const ShortestPathRouting<GraphFacade> shortest_path(&facade, query_contexts, parallel_legs);
+    std::vector<RawRouteData> routes(tours.size());
+
+    TIMER_START(tours);
+    for (std::size_t i = 0; i < tours.size(); ++i)
+    {
+        QueryDeadline deadline;
+        shortest_path(tours[i].legs, tours[i].uturns, routes[i], deadline);
+    }
+    TIMER_STOP(tours);
+
+    std::cout << (parallel_legs ? "parallel" : "sequential")
+              << " legs: " << TIMER_MSEC(tours) / (double)tours.size() << " msec/tour"
+              << "\n";
+    return routes;
+}
+
+// alternatives between the first two stops of each tour
+std::vector<RawRouteData> BenchmarkAlternatives(GraphFacade &facade,
+                                                QueryContextPool &query_contexts,
+                                                const std::vector<Tour> &tours,
+                                                const unsigned number_of_alternatives,
+                                                const bool parallel_candidates)
+{
+    AlternativeRouting<GraphFacade> alternative_path(&facade, query_contexts, parallel_candidates);
+    std::vector<RawRouteData> routes(tours.size());
+
+    TIMER_START(alternatives);
+    std::size_t found_alternatives = 0;
+    for (std::size_t i = 0; i < tours.size(); ++i)
+    {
+        QueryDeadline deadline;
+        alternative_path(tours[i].legs.front(), routes[i], deadline, number_of_alternatives);
+        found_alternatives += routes[i].unpacked_alternatives.size();
+    }
+    TIMER_STOP(alternatives);
+
+    std::cout << (parallel_candidates ? "parallel" : "sequential") << " candidates: "
+              << TIMER_MSEC(alternatives) / (double)tours.size() << " msec/route, "
+              << found_alternatives / (double)tours.size() << " alternatives/route"
+              << "\n";
+    return routes;
+}
+
+int main(int argc, char **argv)
+{
+    LogPolicy::GetInstance().Unmute();
+    if (argc < 2)
+    {
+        SimpleLogger().Write(logWARNING) << "usage: " << argv[0]
+                                         << " file.hsgr [#tours] [#stops] [u-turn interval] [#alternatives]";
+        return 1;
+    }
+    const unsigned num_tours = (argc > 2 ? std::atoi(argv[2]) : 20);
+    const unsigned num_stops = (argc > 3 ? std::atoi(argv[3]) : 100);
+    const unsigned uturn_interval = (argc > 4 ? std::atoi(argv[4]) : 4);
+    const unsigned number_of_alternatives = (argc > 5 ? std::atoi(argv[5]) : 3);
+    if (2 > num_stops || 0 == uturn_interval)
+    {
+        SimpleLogger().Write(logWARNING) << "need at least two stops and a u-turn interval > 0";
+        return 1;
+    }
+
+    std::vector<QueryGraph::NodeArrayEntry> node_list;
+    std::vector<QueryGraph::EdgeArrayEntry> edge_list;
+    unsigned check_sum = 0;
+    readHSGRFromStream(boost::filesystem::path(argv[1]), node_list, edge_list, &check_sum);
+    QueryGraph graph(node_list, edge_list);
+    GraphFacade facade(graph);
+    QueryContextPool query_contexts;
+
+    const std::vector<Tour> tours = GenerateTours(graph, num_tours, num_stops, uturn_interval);
+
+    // the parallel search has to return exactly the route of the sequential one
+    for (unsigned run = 0; run < 2; ++run)
+    {
+        const std::vector<RawRouteData> sequential_routes =
+            Benchmark(facade, query_contexts, tours, false);
+        const std::vector<RawRouteData> parallel_routes =
+            Benchmark(facade, query_contexts, tours, true);
+        for (std::size_t i = 0; i < tours.size(); ++i)
+        {
+            if (!IsSameRoute(sequential_routes[i], parallel_routes[i]))
+            {
+                SimpleLogger().Write(logWARNING) << "routes of tour " << i << " differ";
+                return 1;
+            }
+        }
+
+        const std::vector<RawRouteData> sequential_alternatives = BenchmarkAlternatives(
+            facade, query_contexts, tours, number_of_alternatives, false);
+        const std::vector<RawRouteData> parallel_alternatives = BenchmarkAlternatives(
+            facade, query_contexts, tours, number_of_alternatives, true);
+        for (std::size_t i = 0; i < tours.size(); ++i)
+        {
+            if (!IsSameRoute(sequential_alternatives[i], parallel_alternatives[i]))
+            {
+                SimpleLogger().Write(logWARNING) << "alternatives of tour " << i << " differ";
+                return 1;
+            }
+        }
+    }
+    std::cout << "parallel and sequential routes are identical"
+              << "\n";
+    return 0;
+}
@@ -61,7 +61,7 @@ class Contractor
     {
         ContractorEdgeData()
             : distance(0), id(0), originalEdges(0), shortcut(0), forward(0), backward(0),
-              is_original_via_node_ID(false)
+              is_original_via_node_ID(false), length(0)
         {
         }
         ContractorEdgeData(unsigned distance,
@@ -69,10 +69,11 @@ class Contractor
                            unsigned id,
                            bool shortcut,
                            bool forward,
-                           bool backward)
+                           bool backward,
+                           int length)
             : distance(distance), id(id),
               originalEdges(std::min((unsigned)1 << 28, original_edges)), shortcut(shortcut),
-              forward(forward), backward(backward), is_original_via_node_ID(false)
+              forward(forward), backward(backward), is_original_via_node_ID(false), length(length)
         {
         }
         unsigned distance;
@@ -82,6 +83,7 @@ class Contractor
         bool forward : 1;
         bool backward : 1;
         bool is_original_via_node_ID : 1;
+        int length;
     } data;
 
     struct ContractorHeapData
@@ -177,7 +179,8 @@ class Contractor
                 diter->edge_id,
                 false,
                 diter->forward ? true : false,
-                diter->backward ? true : false);
+                diter->backward ? true : false,
+                diter->length);
 
             edges.emplace_back(diter->target, diter->source,
                 static_cast<unsigned int>(std::max(diter->weight, 1)),
@@ -185,7 +188,8 @@ class Contractor
                 diter->edge_id,
                 false,
                 diter->backward ? true : false,
-                diter->forward ? true : false);
+                diter->forward ? true : false,
+                diter->length);
         }
         // clear input vector
         input_edge_list.clear();
@@ -215,23 +219,24 @@ class Contractor
             forward_edge.data.originalEdges = reverse_edge.data.originalEdges = 1;
             forward_edge.data.distance = reverse_edge.data.distance =
                 std::numeric_limits<int>::max();
-            // remove parallel edges
+            // remove parallel edges, the length follows the shortest one
             while (i < edges.size() && edges[i].source == source && edges[i].target == target)
             {
-                if (edges[i].data.forward)
+                if (edges[i].data.forward && edges[i].data.distance < forward_edge.data.distance)
                 {
-                    forward_edge.data.distance =
-                        std::min(edges[i].data.distance, forward_edge.data.distance);
+                    forward_edge.data.distance = edges[i].data.distance;
+                    forward_edge.data.length = edges[i].data.length;
                 }
-                if (edges[i].data.backward)
+                if (edges[i].data.backward && edges[i].data.distance < reverse_edge.data.distance)
                 {
-                    reverse_edge.data.distance =
-                        std::min(edges[i].data.distance, reverse_edge.data.distance);
+                    reverse_edge.data.distance = edges[i].data.distance;
+                    reverse_edge.data.length = edges[i].data.length;
                 }
                 ++i;
             }
             // merge edges (s,t) and (t,s) into bidirectional edge
-            if (forward_edge.data.distance == reverse_edge.data.distance)
+            if (forward_edge.data.distance == reverse_edge.data.distance &&
+                forward_edge.data.length == reverse_edge.data.length)
             {
                 if ((int)forward_edge.data.distance != std::numeric_limits<int>::max())
                 {
@@ -592,6 +597,7 @@ class Contractor
                                      "edge id invalid");
                     new_edge.data.forward = data.forward;
                     new_edge.data.backward = data.backward;
+                    new_edge.data.length = data.length;
                     edges.push_back(new_edge);
                 }
             }
@@ -764,6 +770,7 @@ class Contractor
                 const int distance = heap.GetKey(target);
                 if (path_distance < distance)
                 {
+                    const int path_length = in_data.length + out_data.length;
                     if (RUNSIMULATION)
                     {
                         BOOST_ASSERT(stats != nullptr);
@@ -778,14 +785,16 @@ class Contractor
                                                     node,
                                                     true,
                                                     true,
-                                                    false);
+                                                    false,
+                                                    path_length);
 
                         inserted_edges.emplace_back(target, source, path_distance,
                                                     out_data.originalEdges + in_data.originalEdges,
                                                     node,
                                                     true,
                                                     false,
-                                                    true);
+                                                    true,
+                                                    path_length);
                     }
                 }
             }
@@ -814,6 +823,10 @@ class Contractor
                     {
                         continue;
                     }
+                    if (inserted_edges[other].data.length != inserted_edges[i].data.length)
+                    {
+                        continue;
+                    }
                     inserted_edges[other].data.forward |= inserted_edges[i].data.forward;
                     inserted_edges[other].data.backward |= inserted_edges[i].data.backward;
                     found = true;
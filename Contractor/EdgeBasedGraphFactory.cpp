@@ -151,7 +151,24 @@ EdgeBasedGraphFactory::InsertEdgeBasedNode(const NodeID node_u, const NodeID nod
             // BOOST_ASSERT(reverse_data.distance >= temp_sum);
         }
 
+        // same prefix sums for the lengths of the individual segments
+        std::vector<int> forward_length_prefix_sum(geometry_size, 0);
+        std::vector<int> reverse_length_prefix_sum(geometry_size, 0);
+        int total_length = 0;
         NodeID current_edge_source_coordinate_id = node_u;
+        for (const auto i : osrm::irange(0u, geometry_size))
+        {
+            forward_length_prefix_sum[i] = total_length;
+            total_length += GetLength(current_edge_source_coordinate_id, forward_geometry[i].first);
+            reverse_length_prefix_sum[i] = total_length;
+            current_edge_source_coordinate_id = forward_geometry[i].first;
+        }
+        for (const auto i : osrm::irange(0u, geometry_size))
+        {
+            reverse_length_prefix_sum[i] = total_length - reverse_length_prefix_sum[i];
+        }
+
+        current_edge_source_coordinate_id = node_u;
 
         if (SPECIAL_NODEID != forward_data.edgeBasedNodeID)
         {
@@ -180,6 +197,8 @@ EdgeBasedGraphFactory::InsertEdgeBasedNode(const NodeID node_u, const NodeID nod
                                                 reverse_geometry[geometry_size - 1 - i].second,
                                                 forward_dist_prefix_sum[i],
                                                 reverse_dist_prefix_sum[i],
+                                                forward_length_prefix_sum[i],
+                                                reverse_length_prefix_sum[i],
                                                 m_geometry_compressor.GetPositionForID(e1),
                                                 i,
                                                 belongs_to_tiny_cc,
@@ -232,6 +251,8 @@ EdgeBasedGraphFactory::InsertEdgeBasedNode(const NodeID node_u, const NodeID nod
                                             reverse_data.distance,
                                             0,
                                             0,
+                                            0,
+                                            0,
                                             SPECIAL_EDGEID,
                                             0,
                                             belongs_to_tiny_cc,
@@ -241,6 +262,30 @@ EdgeBasedGraphFactory::InsertEdgeBasedNode(const NodeID node_u, const NodeID nod
     }
 }
 
+int EdgeBasedGraphFactory::GetLength(const NodeID u, const NodeID v) const
+{
+    return static_cast<int>(10. * FixedPointCoordinate::ApproximateDistance(
+                                      m_node_info_list[u].lat, m_node_info_list[u].lon,
+                                      m_node_info_list[v].lat, m_node_info_list[v].lon) +
+                            .5);
+}
+
+int EdgeBasedGraphFactory::GetEdgeLength(const NodeID u, const EdgeID e) const
+{
+    if (!m_geometry_compressor.HasEntryForID(e))
+    {
+        return GetLength(u, m_node_based_graph->GetTarget(e));
+    }
+    int length = 0;
+    NodeID previous = u;
+    for (const GeometryCompressor::CompressedNode &node : m_geometry_compressor.GetBucketReference(e))
+    {
+        length += GetLength(previous, node.first);
+        previous = node.first;
+    }
+    return length;
+}
+
 void EdgeBasedGraphFactory::FlushVectorToStream(
     std::ofstream &edge_data_file, std::vector<OriginalEdgeData> &original_edge_data_vector) const
 {
@@ -273,7 +318,7 @@ void EdgeBasedGraphFactory::Run(const std::string &original_edge_data_filename,
     GenerateEdgeExpandedEdges(original_edge_data_filename, lua_state);
     TIMER_STOP(generate_edges);
 
-    m_geometry_compressor.SerializeInternalVector(geometry_filename);
+    m_geometry_compressor.SerializeInternalVector(geometry_filename, m_node_info_list);
 
     SimpleLogger().Write() << "Timing statistics for edge-expanded graph:";
     SimpleLogger().Write() << "Geometry compression: " << TIMER_SEC(geometry) << "s";
@@ -398,6 +443,7 @@ void EdgeBasedGraphFactory::CompressGeometry()
             m_geometry_compressor.CompressEdge(
                 forward_e1,
                 forward_e2,
+                node_u,
                 node_v,
                 node_w,
                 forward_weight1 +
@@ -406,6 +452,7 @@ void EdgeBasedGraphFactory::CompressGeometry()
             m_geometry_compressor.CompressEdge(
                 reverse_e1,
                 reverse_e2,
+                node_w,
                 node_v,
                 node_u,
                 reverse_weight1,
@@ -569,6 +616,7 @@ EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(const std::string &original_edg
 
             ++node_based_edge_counter;
             const NodeID v = m_node_based_graph->GetTarget(e1);
+            const int length = GetEdgeLength(u, e1);
             const NodeID to_node_of_only_restriction =
                 m_restriction_map->CheckForEmanatingIsOnlyTurn(u, v);
             const bool is_barrier_node = (m_barrier_nodes.find(v) != m_barrier_nodes.end());
@@ -681,6 +729,7 @@ EdgeBasedGraphFactory::GenerateEdgeExpandedEdges(const std::string &original_edg
                                                                   edge_data2.edgeBasedNodeID,
                                                                   m_edge_based_edge_list.size(),
                                                                   distance,
+                                                                  length,
                                                                   true,
                                                                   false));
             }
@@ -117,6 +117,10 @@ class EdgeBasedGraphFactory
 
     void InsertEdgeBasedNode(const NodeID u, const NodeID v, const bool belongsToTinyComponent);
 
+    // lengths in decimeters, of a straight line resp. of the (compressed) edge e leaving u
+    int GetLength(const NodeID u, const NodeID v) const;
+    int GetEdgeLength(const NodeID u, const EdgeID e) const;
+
     void FlushVectorToStream(std::ofstream &edge_data_file,
                              std::vector<OriginalEdgeData> &original_edge_data_vector) const;
 
@@ -26,8 +26,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "GeometryCompressor.h"
+#include "../Algorithms/DouglasPeucker.h"
+#include "../DataStructures/QueryNode.h"
+#include "../DataStructures/Range.h"
 #include "../Util/simple_logger.hpp"
 
+#include <osrm/Coordinate.h>
+
 #include <boost/assert.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
@@ -47,6 +52,7 @@ GeometryCompressor::GeometryCompressor()
 void GeometryCompressor::IncreaseFreeList()
 {
     m_compressed_geometries.resize(m_compressed_geometries.size() + 100);
+    m_bucket_source_nodes.resize(m_compressed_geometries.size(), SPECIAL_NODEID);
     for (unsigned i = 100; i > 0; --i)
     {
         m_free_list.emplace_back(free_list_maximum);
@@ -68,7 +74,8 @@ unsigned GeometryCompressor::GetPositionForID(const EdgeID edge_id) const
     return map_iterator->second;
 }
 
-void GeometryCompressor::SerializeInternalVector(const std::string &path) const
+void GeometryCompressor::SerializeInternalVector(const std::string &path,
+                                                 const std::vector<NodeInfo> &node_info_list) const
 {
 
     boost::filesystem::fstream geometry_out_stream(path, std::ios::binary | std::ios::out);
@@ -107,12 +114,40 @@ void GeometryCompressor::SerializeInternalVector(const std::string &path) const
         }
     }
     BOOST_ASSERT(control_sum == prefix_sum_of_list_indices);
+
+    // write simplification ranks, the last node of each geometry is an intersection and is
+    // generalized at query time together with the other nodes of the route
+    DouglasPeucker douglas_peucker;
+    std::vector<FixedPointCoordinate> edge_coordinates;
+    std::vector<SimplificationRank> edge_ranks;
+    for (const auto i : osrm::irange<std::size_t>(0, m_compressed_geometries.size()))
+    {
+        const std::vector<CompressedNode> &current_vector = m_compressed_geometries[i];
+        if (current_vector.empty())
+        {
+            continue;
+        }
+        BOOST_ASSERT(SPECIAL_NODEID != m_bucket_source_nodes[i]);
+        edge_coordinates.clear();
+        const NodeInfo &source_node = node_info_list[m_bucket_source_nodes[i]];
+        edge_coordinates.emplace_back(source_node.lat, source_node.lon);
+        for (const CompressedNode &current_node : current_vector)
+        {
+            const NodeInfo &node = node_info_list[current_node.first];
+            edge_coordinates.emplace_back(node.lat, node.lon);
+        }
+        douglas_peucker.ComputeRanks(edge_coordinates, edge_ranks);
+        edge_ranks.back() = INVALID_SIMPLIFICATION_RANK;
+        geometry_out_stream.write((char *)&(edge_ranks[1]),
+                                  current_vector.size() * sizeof(SimplificationRank));
+    }
     // all done, let's close the resource
     geometry_out_stream.close();
 }
 
 void GeometryCompressor::CompressEdge(const EdgeID edge_id_1,
                                       const EdgeID edge_id_2,
+                                      const NodeID source_node_id,
                                       const NodeID via_node_id,
                                       const NodeID target_node_id,
                                       const EdgeWeight weight1,
@@ -159,6 +194,7 @@ void GeometryCompressor::CompressEdge(const EdgeID edge_id_1,
     if (edge_bucket_list1.empty())
     {
         edge_bucket_list1.emplace_back(via_node_id, weight1);
+        m_bucket_source_nodes[edge_bucket_id1] = source_node_id;
     }
 
     BOOST_ASSERT(0 < edge_bucket_list1.size());
@@ -30,6 +30,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../typedefs.h"
 
+struct NodeInfo;
+
 #include <unordered_map>
 
 #include <string>
@@ -43,6 +45,7 @@ class GeometryCompressor
     GeometryCompressor();
     void CompressEdge(const EdgeID surviving_edge_id,
                       const EdgeID removed_edge_id,
+                      const NodeID source_node_id,
                       const NodeID via_node_id,
                       const NodeID target_node,
                       const EdgeWeight weight1,
@@ -50,7 +53,9 @@ class GeometryCompressor
 
     bool HasEntryForID(const EdgeID edge_id) const;
     void PrintStatistics() const;
-    void SerializeInternalVector(const std::string &path) const;
+    // writes the geometries followed by a simplification rank per geometry node
+    void SerializeInternalVector(const std::string &path,
+                                 const std::vector<NodeInfo> &node_info_list) const;
     unsigned GetPositionForID(const EdgeID edge_id) const;
     const std::vector<GeometryCompressor::CompressedNode> &
     GetBucketReference(const EdgeID edge_id) const;
@@ -60,6 +65,8 @@ class GeometryCompressor
   private:
     void IncreaseFreeList();
     std::vector<std::vector<CompressedNode>> m_compressed_geometries;
+    // the geometries do not contain the first node of their edge
+    std::vector<NodeID> m_bucket_source_nodes;
     std::vector<unsigned> m_free_list;
     std::unordered_map<EdgeID, unsigned> m_edge_id_to_list_index_map;
 };
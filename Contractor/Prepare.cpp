@@ -528,7 +528,7 @@ Prepare::BuildEdgeExpandedGraph(lua_State *lua_state,
 
     BOOST_ASSERT(number_of_edge_based_nodes != std::numeric_limits<unsigned>::max());
 #ifndef WIN32
-    static_assert(sizeof(EdgeBasedEdge) == 16,
+    static_assert(sizeof(EdgeBasedEdge) == 20,
                   "changing ImportEdge type has influence on memory consumption!");
 #endif
 
@@ -0,0 +1,102 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef ADMISSION_CONTROL_H
+#define ADMISSION_CONTROL_H
+
+#include <atomic>
+#include <cstdint>
+
+// Token budget for the estimated cost of all admitted queries that are not finished,
+// whether they are running or wait in a queue. A query is admitted if its cost fits into
+// the remaining budget, or if nothing else is admitted, so that a single expensive query
+// can always make progress.
+class AdmissionControl
+{
+  public:
+    // a budget of zero admits everything
+    explicit AdmissionControl(const unsigned max_cost)
+        : max_cost(max_cost), cost_in_flight(0), admitted(0), rejected(0)
+    {
+    }
+
+    bool TryAcquire(const unsigned cost)
+    {
+        unsigned current_cost = cost_in_flight.load();
+        do
+        {
+            if (0 != max_cost && 0 != current_cost && current_cost + cost > max_cost)
+            {
+                ++rejected;
+                return false;
+            }
+        } while (!cost_in_flight.compare_exchange_weak(current_cost, current_cost + cost));
+        ++admitted;
+        return true;
+    }
+
+    void Release(const unsigned cost) { cost_in_flight -= cost; }
+
+    unsigned GetMaxCost() const { return max_cost; }
+    unsigned GetCostInFlight() const { return cost_in_flight.load(); }
+    uint64_t GetAdmittedCount() const { return admitted.load(); }
+    uint64_t GetRejectedCount() const { return rejected.load(); }
+
+  private:
+    const unsigned max_cost;
+    std::atomic<unsigned> cost_in_flight;
+    std::atomic<uint64_t> admitted;
+    std::atomic<uint64_t> rejected;
+};
+
+// Holds the cost of an admitted query until it goes out of scope
+class AdmissionTicket
+{
+  public:
+    AdmissionTicket(AdmissionControl &control, const unsigned cost)
+        : control(control), cost(cost), admitted(control.TryAcquire(cost))
+    {
+    }
+    AdmissionTicket(const AdmissionTicket &) = delete;
+
+    ~AdmissionTicket()
+    {
+        if (admitted)
+        {
+            control.Release(cost);
+        }
+    }
+
+    bool IsAdmitted() const { return admitted; }
+
+  private:
+    AdmissionControl &control;
+    const unsigned cost;
+    const bool admitted;
+};
+
+#endif // ADMISSION_CONTROL_H
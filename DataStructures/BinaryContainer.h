@@ -0,0 +1,145 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef BINARY_CONTAINER_H
+#define BINARY_CONTAINER_H
+
+#include <boost/assert.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Compact alternative to JSON for clients that parse large responses, e.g. distance tables.
+// All integers are little-endian. Every response starts with a 12 byte header:
+//
+//   char[4]  magic "OSRM"
+//   uint16   format version
+//   uint16   payload type
+//   uint32   payload length in bytes, not including the header
+//
+// table:   uint32 rows, uint32 columns, rows * columns int32 row-major times in 1/10 s,
+//          followed by as many int32 lengths in m if they were requested
+// route:   int32 status, uint32 distance in m, uint32 time in s, uint32 via point count,
+//          via points as int32 lat, int32 lon, uint32 alternative count, alternatives as
+//          uint32 distance in m, uint32 time in s
+// nearest: int32 status, uint32 result count, results as int32 lat, int32 lon and a
+//          length-prefixed name (uint32 length, UTF-8 bytes)
+//
+// Coordinates are fixed point, i.e. degrees times COORDINATE_PRECISION.
+namespace Binary
+{
+
+constexpr std::uint16_t FORMAT_VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 12;
+
+enum PayloadType : std::uint16_t
+{
+    TablePayload = 1,
+    RoutePayload = 2,
+    NearestPayload = 3
+};
+
+// appends little-endian values to a reply, the header is patched once the payload is complete
+class Writer
+{
+  public:
+    Writer(std::vector<char> &output, const PayloadType type)
+        : output(output), header_offset(output.size())
+    {
+        output.insert(output.end(), {'O', 'S', 'R', 'M'});
+        AppendUInt16(FORMAT_VERSION);
+        AppendUInt16(type);
+        AppendUInt32(0);
+    }
+
+    void Reserve(const std::size_t payload_size)
+    {
+        output.reserve(header_offset + HEADER_SIZE + payload_size);
+    }
+
+    void AppendUInt16(const std::uint16_t value)
+    {
+        const char bytes[2] = {static_cast<char>(value & 0xff), static_cast<char>(value >> 8)};
+        output.insert(output.end(), bytes, bytes + 2);
+    }
+
+    void AppendUInt32(const std::uint32_t value)
+    {
+        const char bytes[4] = {static_cast<char>(value & 0xff),
+                               static_cast<char>((value >> 8) & 0xff),
+                               static_cast<char>((value >> 16) & 0xff),
+                               static_cast<char>(value >> 24)};
+        output.insert(output.end(), bytes, bytes + 4);
+    }
+
+    void AppendInt32(const std::int32_t value) { AppendUInt32(static_cast<std::uint32_t>(value)); }
+
+    // bulk copy of a whole vector, no per element conversion on little-endian hosts
+    void AppendInt32Array(const std::vector<std::int32_t> &values)
+    {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        const std::size_t offset = output.size();
+        output.resize(offset + values.size() * sizeof(std::int32_t));
+        if (!values.empty())
+        {
+            std::memcpy(&output[offset], values.data(), values.size() * sizeof(std::int32_t));
+        }
+#else
+        for (const std::int32_t value : values)
+        {
+            AppendInt32(value);
+        }
+#endif
+    }
+
+    void AppendString(const std::string &value)
+    {
+        AppendUInt32(static_cast<std::uint32_t>(value.size()));
+        output.insert(output.end(), value.begin(), value.end());
+    }
+
+    // writes the payload length into the header
+    void Finish()
+    {
+        BOOST_ASSERT(output.size() >= header_offset + HEADER_SIZE);
+        const std::uint32_t payload_length =
+            static_cast<std::uint32_t>(output.size() - header_offset - HEADER_SIZE);
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            output[header_offset + 8 + i] = static_cast<char>((payload_length >> (8 * i)) & 0xff);
+        }
+    }
+
+  private:
+    std::vector<char> &output;
+    const std::size_t header_offset;
+};
+}
+
+#endif // BINARY_CONTAINER_H
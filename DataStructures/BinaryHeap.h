@@ -50,6 +50,8 @@ template <typename NodeID, typename Key> class ArrayStorage
 
     Key &operator[](NodeID node) { return positions[node]; }
 
+    Key operator[](NodeID node) const { return positions[node]; }
+
     void Clear() {}
 
   private:
@@ -63,6 +65,13 @@ template <typename NodeID, typename Key> class MapStorage
 
     Key &operator[](NodeID node) { return nodes[node]; }
 
+    // unknown nodes map to the same position as they would after a lookup through operator[]
+    Key operator[](NodeID node) const
+    {
+        auto iter = nodes.find(node);
+        return (iter != nodes.end() ? iter->second : Key());
+    }
+
     void Clear() { nodes.clear(); }
 
   private:
@@ -76,10 +85,11 @@ template <typename NodeID, typename Key> class UnorderedMapStorage
 
     Key &operator[](const NodeID node) { return nodes[node]; }
 
-    Key const &operator[](const NodeID node) const
+    // unknown nodes map to the same position as they would after a lookup through operator[]
+    Key operator[](const NodeID node) const
     {
         auto iter = nodes.find(node);
-        return iter->second;
+        return (iter != nodes.end() ? iter->second : Key());
     }
 
     void Clear() { nodes.clear(); }
@@ -92,9 +102,12 @@ template <typename NodeID,
           typename Key,
           typename Weight,
           typename Data,
-          typename IndexStorage = ArrayStorage<NodeID, NodeID>>
+          typename IndexStorage = ArrayStorage<NodeID, NodeID>,
+          unsigned Arity = 2>
 class BinaryHeap
 {
+    static_assert(Arity >= 2, "heap needs at least two children per element");
+
   private:
     BinaryHeap(const BinaryHeap &right);
     void operator=(const BinaryHeap &right);
@@ -148,6 +161,21 @@ class BinaryHeap
         return inserted_nodes[index].weight;
     }
 
+    Weight const &GetKey(NodeID node) const
+    {
+        const Key index = node_index[node];
+        return inserted_nodes[index].weight;
+    }
+
+    // inserted nodes are numbered densely in the order of their insertion until Clear()
+    std::size_t GetNumberOfInsertedNodes() const { return inserted_nodes.size(); }
+
+    Key GetInsertionIndex(NodeID node) const
+    {
+        BOOST_ASSERT(WasInserted(node));
+        return node_index[node];
+    }
+
     bool WasRemoved(const NodeID node)
     {
         BOOST_ASSERT(WasInserted(node));
@@ -165,6 +193,17 @@ class BinaryHeap
         return inserted_nodes[index].node == node;
     }
 
+    // does not add a position for unknown nodes, several threads may look up the same heap
+    bool WasInserted(const NodeID node) const
+    {
+        const Key index = node_index[node];
+        if (index >= static_cast<Key>(inserted_nodes.size()))
+        {
+            return false;
+        }
+        return inserted_nodes[index].node == node;
+    }
+
     NodeID Min() const
     {
         BOOST_ASSERT(heap.size() > 1);
@@ -231,18 +270,26 @@ class BinaryHeap
     std::vector<HeapElement> heap;
     IndexStorage node_index;
 
+    // the heap is 1-based with a sentinel at 0, for Arity == 2 these are the usual shifts
+    static Key Parent(const Key key) { return static_cast<Key>((key + Arity - 2) / Arity); }
+
+    static Key FirstChild(const Key key) { return static_cast<Key>(Arity * key - Arity + 2); }
+
     void Downheap(Key key)
     {
         const Key droppingIndex = heap[key].index;
         const Weight weight = heap[key].weight;
-        Key nextKey = key << 1;
-        while (nextKey < static_cast<Key>(heap.size()))
+        const Key heap_size = static_cast<Key>(heap.size());
+        Key nextKey = FirstChild(key);
+        while (nextKey < heap_size)
         {
-            const Key nextKeyOther = nextKey + 1;
-            if ((nextKeyOther < static_cast<Key>(heap.size())) &&
-                (heap[nextKey].weight > heap[nextKeyOther].weight))
+            const Key lastKey = std::min(static_cast<Key>(nextKey + Arity), heap_size);
+            for (Key nextKeyOther = nextKey + 1; nextKeyOther < lastKey; ++nextKeyOther)
             {
-                nextKey = nextKeyOther;
+                if (heap[nextKey].weight > heap[nextKeyOther].weight)
+                {
+                    nextKey = nextKeyOther;
+                }
             }
             if (weight <= heap[nextKey].weight)
             {
@@ -251,7 +298,7 @@ class BinaryHeap
             heap[key] = heap[nextKey];
             inserted_nodes[heap[key].index].key = key;
             key = nextKey;
-            nextKey <<= 1;
+            nextKey = FirstChild(key);
         }
         heap[key].index = droppingIndex;
         heap[key].weight = weight;
@@ -262,14 +309,14 @@ class BinaryHeap
     {
         const Key risingIndex = heap[key].index;
         const Weight weight = heap[key].weight;
-        Key nextKey = key >> 1;
+        Key nextKey = Parent(key);
         while (heap[nextKey].weight > weight)
         {
             BOOST_ASSERT(nextKey != 0);
             heap[key] = heap[nextKey];
             inserted_nodes[heap[key].index].key = key;
             key = nextKey;
-            nextKey >>= 1;
+            nextKey = Parent(key);
         }
         heap[key].index = risingIndex;
         heap[key].weight = weight;
@@ -281,7 +328,7 @@ class BinaryHeap
 #ifndef NDEBUG
         for (Key i = 2; i < (Key)heap.size(); ++i)
         {
-            BOOST_ASSERT(heap[i].weight >= heap[i >> 1].weight);
+            BOOST_ASSERT(heap[i].weight >= heap[Parent(i)].weight);
         }
 #endif
     }
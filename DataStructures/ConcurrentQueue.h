@@ -47,8 +47,26 @@ template <typename Data> class ConcurrentQueue
         m_not_empty.notify_one();
     }
 
+    inline bool try_push(const Data &data)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_internal_queue.size() >= m_internal_queue.capacity())
+        {
+            return false;
+        }
+        m_internal_queue.push_back(data);
+        m_not_empty.notify_one();
+        return true;
+    }
+
     inline bool empty() const { return m_internal_queue.empty(); }
 
+    inline size_t size()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_internal_queue.size();
+    }
+
     inline void wait_and_pop(Data &popped_value)
     {
         std::unique_lock<std::mutex> lock(m_mutex);
@@ -23,6 +23,8 @@ struct EdgeBasedNode
         reverse_weight(INVALID_EDGE_WEIGHT >> 1),
         forward_offset(0),
         reverse_offset(0),
+        forward_length_offset(0),
+        reverse_length_offset(0),
         packed_geometry_id(SPECIAL_EDGEID),
         fwd_segment_position( std::numeric_limits<unsigned short>::max() ),
         is_in_tiny_cc(false),
@@ -40,6 +42,8 @@ struct EdgeBasedNode
         int reverse_weight,
         int forward_offset,
         int reverse_offset,
+        int forward_length_offset,
+        int reverse_length_offset,
         unsigned packed_geometry_id,
         unsigned short fwd_segment_position,
         bool belongs_to_tiny_component,
@@ -55,6 +59,8 @@ struct EdgeBasedNode
         reverse_weight(reverse_weight),
         forward_offset(forward_offset),
         reverse_offset(reverse_offset),
+        forward_length_offset(forward_length_offset),
+        reverse_length_offset(reverse_length_offset),
         packed_geometry_id(packed_geometry_id),
         fwd_segment_position(fwd_segment_position),
         is_in_tiny_cc(belongs_to_tiny_component),
@@ -88,6 +94,8 @@ struct EdgeBasedNode
     int reverse_weight; // weight in the other direction (may be different)
     int forward_offset; // prefix sum of the weight up the edge TODO: short must suffice
     int reverse_offset; // prefix sum of the weight from the edge TODO: short must suffice
+    int forward_length_offset; // prefix sum of the length up to the edge in decimeters
+    int reverse_length_offset; // prefix sum of the length from the edge in decimeters
     unsigned packed_geometry_id; // if set, then the edge represents a packed geometry
     unsigned short fwd_segment_position; // segment id in a compressed geometry
     bool is_in_tiny_cc;
@@ -83,13 +83,14 @@ bool EdgeBasedEdge::operator<(const EdgeBasedEdge &other) const
 template <class EdgeT>
 EdgeBasedEdge::EdgeBasedEdge(const EdgeT &other)
     : source(other.source), target(other.target), edge_id(other.data.via),
-      weight(other.data.distance), forward(other.data.forward), backward(other.data.backward)
+      weight(other.data.distance), forward(other.data.forward), backward(other.data.backward),
+      length(other.data.length)
 {
 }
 
-/** Default constructor. target and weight are set to 0.*/
+/** Default constructor. target, weight and length are set to 0.*/
 EdgeBasedEdge::EdgeBasedEdge()
-    : source(0), target(0), edge_id(0), weight(0), forward(false), backward(false)
+    : source(0), target(0), edge_id(0), weight(0), forward(false), backward(false), length(0)
 {
 }
 
@@ -97,9 +98,10 @@ EdgeBasedEdge::EdgeBasedEdge(const NodeID source,
                              const NodeID target,
                              const NodeID edge_id,
                              const EdgeWeight weight,
+                             const EdgeWeight length,
                              const bool forward,
                              const bool backward)
     : source(source), target(target), edge_id(edge_id), weight(weight), forward(forward),
-      backward(backward)
+      backward(backward), length(length)
 {
 }
@@ -76,6 +76,7 @@ struct EdgeBasedEdge
                            const NodeID target,
                            const NodeID edge_id,
                            const EdgeWeight weight,
+                           const EdgeWeight length,
                            const bool forward,
                            const bool backward);
     NodeID source;
@@ -84,6 +85,7 @@ struct EdgeBasedEdge
     EdgeWeight weight : 30;
     bool forward : 1;
     bool backward : 1;
+    EdgeWeight length; // length of the source segment in decimeters
 };
 
 using ImportEdge = NodeBasedEdge;
@@ -49,6 +49,8 @@ struct PhantomNode
         reverse_weight(reverse_weight),
         forward_offset(forward_offset),
         reverse_offset(reverse_offset),
+        forward_length(0),
+        reverse_length(0),
         packed_geometry_id(packed_geometry_id),
         location(location),
         fwd_segment_position(fwd_segment_position),
@@ -64,6 +66,8 @@ struct PhantomNode
         reverse_weight(INVALID_EDGE_WEIGHT),
         forward_offset(0),
         reverse_offset(0),
+        forward_length(0),
+        reverse_length(0),
         packed_geometry_id(SPECIAL_EDGEID),
         fwd_segment_position(0),
         forward_travel_mode(TRAVEL_MODE_INACCESSIBLE),
@@ -77,6 +81,9 @@ struct PhantomNode
     int reverse_weight;
     int forward_offset;
     int reverse_offset;
+    // length in decimeters from the start of the segment up to the phantom, per direction
+    int forward_length;
+    int reverse_length;
     unsigned packed_geometry_id;
     FixedPointCoordinate location;
     unsigned short fwd_segment_position;
@@ -172,6 +179,8 @@ inline std::ostream& operator<<(std::ostream &out, const PhantomNode & pn)
             "rev-w: " << pn.reverse_weight       << ", " <<
             "fwd-o: " << pn.forward_offset       << ", " <<
             "rev-o: " << pn.reverse_offset       << ", " <<
+            "fwd-l: " << pn.forward_length       << ", " <<
+            "rev-l: " << pn.reverse_length       << ", " <<
             "geom: "  << pn.packed_geometry_id   << ", " <<
             "pos: "   << pn.fwd_segment_position << ", " <<
             "loc: "   << pn.location;
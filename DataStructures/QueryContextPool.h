@@ -0,0 +1,118 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef QUERY_CONTEXT_POOL_H
+#define QUERY_CONTEXT_POOL_H
+
+#include "SearchEngineData.h"
+
+#include <boost/assert.hpp>
+
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Hands out the heaps of a query to the request that runs it. Contexts are created on demand
+// and handed back when the handle goes out of scope, so the number of contexts equals the peak
+// number of concurrent queries and not the number of threads.
+class QueryContextPool
+{
+  public:
+    class Handle
+    {
+      public:
+        Handle(QueryContextPool &pool, std::unique_ptr<SearchEngineData> context)
+            : pool(&pool), context(std::move(context))
+        {
+        }
+
+        Handle(Handle &&other) : pool(other.pool), context(std::move(other.context)) {}
+
+        Handle(const Handle &) = delete;
+        Handle &operator=(const Handle &) = delete;
+
+        ~Handle()
+        {
+            if (context)
+            {
+                pool->Release(std::move(context));
+            }
+        }
+
+        SearchEngineData &operator*() const { return *context; }
+
+        SearchEngineData *operator->() const { return context.get(); }
+
+      private:
+        QueryContextPool *pool;
+        std::unique_ptr<SearchEngineData> context;
+    };
+
+    QueryContextPool() : number_of_contexts(0) {}
+
+    QueryContextPool(const QueryContextPool &) = delete;
+    QueryContextPool &operator=(const QueryContextPool &) = delete;
+
+    // all handles have to be returned before the pool is destroyed
+    ~QueryContextPool() { BOOST_ASSERT(idle_contexts.size() == number_of_contexts); }
+
+    Handle Acquire()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!idle_contexts.empty())
+            {
+                std::unique_ptr<SearchEngineData> context = std::move(idle_contexts.back());
+                idle_contexts.pop_back();
+                return Handle(*this, std::move(context));
+            }
+            ++number_of_contexts;
+        }
+        // heaps are allocated lazily by the routing algorithm that uses them
+        return Handle(*this, std::unique_ptr<SearchEngineData>(new SearchEngineData()));
+    }
+
+    std::size_t GetNumberOfContexts() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return number_of_contexts;
+    }
+
+  private:
+    void Release(std::unique_ptr<SearchEngineData> context)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle_contexts.emplace_back(std::move(context));
+    }
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<SearchEngineData>> idle_contexts;
+    std::size_t number_of_contexts;
+};
+
+#endif // QUERY_CONTEXT_POOL_H
@@ -0,0 +1,128 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef QUERY_DEADLINE_H
+#define QUERY_DEADLINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Point in time after which a search gives up. The search loops poll it once per step,
+// but the clock is only read every CHECK_INTERVAL polls to keep it off the hot path. A search
+// is also given up once the optional cancellation flag is raised, e.g. because the client
+// that asked for it has gone away.
+class QueryDeadline
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr unsigned CHECK_INTERVAL = 256;
+
+    // never expires
+    QueryDeadline()
+        : is_unlimited(true), is_expired(false), countdown(CHECK_INTERVAL), cancelled(nullptr)
+    {
+    }
+
+    explicit QueryDeadline(const Clock::time_point deadline,
+                           const std::atomic<bool> *cancelled = nullptr)
+        : deadline(deadline), is_unlimited(false), is_expired(false), countdown(CHECK_INTERVAL),
+          cancelled(cancelled)
+    {
+    }
+
+    // only expires when the flag is raised
+    explicit QueryDeadline(const std::atomic<bool> *cancelled)
+        : is_unlimited(true), is_expired(false), countdown(CHECK_INTERVAL), cancelled(cancelled)
+    {
+    }
+
+    // once expired, a deadline stays expired so that every loop of the search unwinds
+    bool IsExpired()
+    {
+        if ((is_unlimited && nullptr == cancelled) || is_expired || 0 != --countdown)
+        {
+            return is_expired;
+        }
+        countdown = CHECK_INTERVAL;
+        is_expired = WasCancelled() || (!is_unlimited && Clock::now() >= deadline);
+        return is_expired;
+    }
+
+    // true if a search was aborted because of this deadline
+    bool WasExpired() const { return is_expired; }
+
+    // true if the cancellation flag was raised, the search is aborted then as well
+    bool WasCancelled() const
+    {
+        return nullptr != cancelled && cancelled->load(std::memory_order_relaxed);
+    }
+
+  private:
+    Clock::time_point deadline;
+    bool is_unlimited;
+    bool is_expired;
+    unsigned countdown;
+    const std::atomic<bool> *cancelled;
+};
+
+// Hands out the deadlines of the queries and counts the ones that were aborted
+class QueryTimeLimit
+{
+  public:
+    // a limit of zero lets every search run to completion
+    explicit QueryTimeLimit(const unsigned max_milliseconds)
+        : max_milliseconds(max_milliseconds), aborted(0)
+    {
+    }
+
+    // The deadline is measured from start, e.g. the time a request was taken off the queue,
+    // or from now if start is not set.
+    QueryDeadline Start(const QueryDeadline::Clock::time_point start =
+                            QueryDeadline::Clock::time_point(),
+                        const std::atomic<bool> *cancelled = nullptr) const
+    {
+        if (0 == max_milliseconds)
+        {
+            return QueryDeadline(cancelled);
+        }
+        const QueryDeadline::Clock::time_point begin =
+            (QueryDeadline::Clock::time_point() == start) ? QueryDeadline::Clock::now() : start;
+        return QueryDeadline(begin + std::chrono::milliseconds(max_milliseconds), cancelled);
+    }
+
+    void CountAborted() { ++aborted; }
+
+    unsigned GetMaxMilliseconds() const { return max_milliseconds; }
+    uint64_t GetAbortedCount() const { return aborted.load(); }
+
+  private:
+    const unsigned max_milliseconds;
+    std::atomic<uint64_t> aborted;
+};
+
+#endif // QUERY_DEADLINE_H
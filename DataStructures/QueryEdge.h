@@ -36,7 +36,10 @@ struct QueryEdge
     NodeID target;
     struct EdgeData
     {
-        EdgeData() : id(0), shortcut(false), distance(0), forward(false), backward(false) {}
+        EdgeData()
+            : id(0), shortcut(false), distance(0), forward(false), backward(false), length(0)
+        {
+        }
 
         template <class OtherT> EdgeData(const OtherT &other)
         {
@@ -45,12 +48,15 @@ struct QueryEdge
             id = other.id;
             forward = other.forward;
             backward = other.backward;
+            length = other.length;
         }
         NodeID id : 31;
         bool shortcut : 1;
         int distance : 30;
         bool forward : 1;
         bool backward : 1;
+        // length in decimeters, the sum of both halves for shortcuts
+        int length;
     } data;
 
     QueryEdge() : source(SPECIAL_NODEID), target(SPECIAL_NODEID) {}
@@ -74,7 +80,7 @@ struct QueryEdge
         return (source == right.source && target == right.target &&
                 data.distance == right.data.distance && data.shortcut == right.data.shortcut &&
                 data.forward == right.data.forward && data.backward == right.data.backward &&
-                data.id == right.data.id);
+                data.id == right.data.id && data.length == right.data.length);
     }
 };
 
@@ -43,7 +43,8 @@ struct PathData
         : node(SPECIAL_NODEID), name_id(INVALID_EDGE_WEIGHT),
           segment_duration(INVALID_EDGE_WEIGHT),
           turn_instruction(TurnInstruction::NoTurn),
-          travel_mode(TRAVEL_MODE_INACCESSIBLE)
+          travel_mode(TRAVEL_MODE_INACCESSIBLE),
+          simplification_rank(INVALID_SIMPLIFICATION_RANK)
     {
     }
 
@@ -51,9 +52,10 @@ struct PathData
              unsigned name_id,
              TurnInstruction turn_instruction,
              EdgeWeight segment_duration,
-             TravelMode travel_mode)
+             TravelMode travel_mode,
+             SimplificationRank simplification_rank = INVALID_SIMPLIFICATION_RANK)
         : node(node), name_id(name_id), segment_duration(segment_duration), turn_instruction(turn_instruction),
-          travel_mode(travel_mode)
+          travel_mode(travel_mode), simplification_rank(simplification_rank)
     {
     }
     NodeID node;
@@ -61,12 +63,14 @@ struct PathData
     EdgeWeight segment_duration;
     TurnInstruction turn_instruction;
     TravelMode travel_mode : 4;
+    SimplificationRank simplification_rank;
 };
 
 struct RawRouteData
 {
     std::vector<std::vector<PathData>> unpacked_path_segments;
-    std::vector<PathData> unpacked_alternative;
+    // alternatives to a single-leg route, ordered by rank
+    std::vector<std::vector<PathData>> unpacked_alternatives;
     std::vector<PhantomNodes> segment_end_coordinates;
     std::vector<FixedPointCoordinate> raw_via_node_coordinates;
     std::vector<bool> source_traversed_in_reverse;
@@ -75,7 +79,7 @@ struct RawRouteData
     std::vector<bool> alt_target_traversed_in_reverse;
     unsigned check_sum;
     int shortest_path_length;
-    int alternative_path_length;
+    std::vector<int> alternative_path_lengths;
 
     bool is_via_leg(const std::size_t leg) const
     {
@@ -84,8 +88,7 @@ struct RawRouteData
 
     RawRouteData()
         : check_sum(SPECIAL_NODEID),
-          shortest_path_length(INVALID_EDGE_WEIGHT),
-          alternative_path_length(INVALID_EDGE_WEIGHT)
+          shortest_path_length(INVALID_EDGE_WEIGHT)
     {
     }
 };
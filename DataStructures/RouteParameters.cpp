@@ -32,8 +32,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/fusion/include/at_c.hpp>
 
 RouteParameters::RouteParameters()
-    : zoom_level(18), print_instructions(false), alternate_route(true), geometry(true),
-      compression(true), deprecatedAPI(false), uturn_default(false), check_sum(-1), num_results(1)
+    : zoom_level(18), print_instructions(false), alternate_route(true), num_alternatives(1),
+      geometry(true), compression(true), lengths(false), deprecatedAPI(false),
+      uturn_default(false), check_sum(-1), num_results(1), cancelled(nullptr)
 {
 }
 
@@ -55,6 +56,14 @@ void RouteParameters::setNumberOfResults(const short number)
 
 void RouteParameters::setAlternateRouteFlag(const bool flag) { alternate_route = flag; }
 
+void RouteParameters::setNumberOfAlternatives(const short number)
+{
+    if (number > 0 && number <= 10)
+    {
+        num_alternatives = number;
+    }
+}
+
 void RouteParameters::setUTurn(const bool flag)
 {
     uturns.resize(coordinates.size(), uturn_default);
@@ -81,6 +90,8 @@ void RouteParameters::setChecksum(const unsigned sum) { check_sum = sum; }
 
 void RouteParameters::setInstructionFlag(const bool flag) { print_instructions = flag; }
 
+void RouteParameters::setDataset(const std::string &dataset_name) { dataset = dataset_name; }
+
 void RouteParameters::setService(const std::string &service_string) { service = service_string; }
 
 void RouteParameters::setOutputFormat(const std::string &format) { output_format = format; }
@@ -108,10 +119,27 @@ void RouteParameters::setGeometryFlag(const bool flag) { geometry = flag; }
 
 void RouteParameters::setCompressionFlag(const bool flag) { compression = flag; }
 
+void RouteParameters::setLengthsFlag(const bool flag) { lengths = flag; }
+
 void
 RouteParameters::addCoordinate(const boost::fusion::vector<double, double> &transmitted_coordinates)
 {
     coordinates.emplace_back(
         static_cast<int>(COORDINATE_PRECISION * boost::fusion::at_c<0>(transmitted_coordinates)),
         static_cast<int>(COORDINATE_PRECISION * boost::fusion::at_c<1>(transmitted_coordinates)));
+    is_source.push_back(true);
+    is_destination.push_back(true);
+}
+
+void RouteParameters::addSource(const boost::fusion::vector<double, double> &transmitted_coordinates)
+{
+    addCoordinate(transmitted_coordinates);
+    is_destination.back() = false;
+}
+
+void
+RouteParameters::addDestination(const boost::fusion::vector<double, double> &transmitted_coordinates)
+{
+    addCoordinate(transmitted_coordinates);
+    is_source.back() = false;
 }
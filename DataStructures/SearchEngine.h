@@ -28,7 +28,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef SEARCHENGINE_H
 #define SEARCHENGINE_H
 
-#include "SearchEngineData.h"
+#include "QueryContextPool.h"
 #include "../RoutingAlgorithms/AlternativePathRouting.h"
 #include "../RoutingAlgorithms/ManyToManyRouting.h"
 #include "../RoutingAlgorithms/ShortestPathRouting.h"
@@ -39,16 +39,20 @@ template <class DataFacadeT> class SearchEngine
 {
   private:
     DataFacadeT *facade;
-    SearchEngineData engine_working_data;
 
   public:
     ShortestPathRouting<DataFacadeT> shortest_path;
     AlternativeRouting<DataFacadeT> alternative_path;
     ManyToManyRouting<DataFacadeT> distance_table;
 
-    explicit SearchEngine(DataFacadeT *facade)
-        : facade(facade), shortest_path(facade, engine_working_data),
-          alternative_path(facade, engine_working_data), distance_table(facade, engine_working_data)
+    // the pool may be shared by the search engines of several datasets, query heaps are
+    // hash-based and do not depend on the number of nodes of a graph. parallel_search lets
+    // a route search its legs and via node candidates on the TBB pool.
+    SearchEngine(DataFacadeT *facade,
+                 QueryContextPool &query_contexts,
+                 const bool parallel_search = false)
+        : facade(facade), shortest_path(facade, query_contexts, parallel_search),
+          alternative_path(facade, query_contexts, parallel_search), distance_table(facade, query_contexts)
     {
         static_assert(!std::is_pointer<DataFacadeT>::value, "don't instantiate with ptr type");
         static_assert(std::is_object<DataFacadeT>::value, "don't instantiate with void, function, or reference");
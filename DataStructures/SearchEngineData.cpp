@@ -29,7 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "BinaryHeap.h"
 
-void SearchEngineData::InitializeOrClearFirstThreadLocalStorage(const unsigned number_of_nodes)
+void SearchEngineData::InitializeOrClearFirstHeaps(const unsigned number_of_nodes)
 {
     if (forwardHeap.get())
     {
@@ -50,7 +50,7 @@ void SearchEngineData::InitializeOrClearFirstThreadLocalStorage(const unsigned n
     }
 }
 
-void SearchEngineData::InitializeOrClearSecondThreadLocalStorage(const unsigned number_of_nodes)
+void SearchEngineData::InitializeOrClearSecondHeaps(const unsigned number_of_nodes)
 {
     if (forwardHeap2.get())
     {
@@ -71,7 +71,7 @@ void SearchEngineData::InitializeOrClearSecondThreadLocalStorage(const unsigned
     }
 }
 
-void SearchEngineData::InitializeOrClearThirdThreadLocalStorage(const unsigned number_of_nodes)
+void SearchEngineData::InitializeOrClearThirdHeaps(const unsigned number_of_nodes)
 {
     if (forwardHeap3.get())
     {
@@ -28,11 +28,16 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef SEARCH_ENGINE_DATA_H
 #define SEARCH_ENGINE_DATA_H
 
-#include <boost/thread/tss.hpp>
-
 #include "../typedefs.h"
 #include "BinaryHeap.h"
 
+#include <memory>
+
+// children per heap element, wider heaps are shallower but compare more keys per level
+#ifndef OSRM_QUERY_HEAP_ARITY
+#define OSRM_QUERY_HEAP_ARITY 2
+#endif
+
 struct HeapData
 {
     NodeID parent;
@@ -41,21 +46,27 @@ struct HeapData
 
 struct SearchEngineData
 {
-    using QueryHeap = BinaryHeap<NodeID, NodeID, int, HeapData, UnorderedMapStorage<NodeID, int>>;
-    using SearchEngineHeapPtr = boost::thread_specific_ptr<QueryHeap>;
+    using QueryHeap = BinaryHeap<NodeID,
+                                 NodeID,
+                                 int,
+                                 HeapData,
+                                 UnorderedMapStorage<NodeID, int>,
+                                 OSRM_QUERY_HEAP_ARITY>;
+    using SearchEngineHeapPtr = std::unique_ptr<QueryHeap>;
 
-    static SearchEngineHeapPtr forwardHeap;
-    static SearchEngineHeapPtr backwardHeap;
-    static SearchEngineHeapPtr forwardHeap2;
-    static SearchEngineHeapPtr backwardHeap2;
-    static SearchEngineHeapPtr forwardHeap3;
-    static SearchEngineHeapPtr backwardHeap3;
+    // heaps of one query context, checked out from a QueryContextPool
+    SearchEngineHeapPtr forwardHeap;
+    SearchEngineHeapPtr backwardHeap;
+    SearchEngineHeapPtr forwardHeap2;
+    SearchEngineHeapPtr backwardHeap2;
+    SearchEngineHeapPtr forwardHeap3;
+    SearchEngineHeapPtr backwardHeap3;
 
-    void InitializeOrClearFirstThreadLocalStorage(const unsigned number_of_nodes);
+    void InitializeOrClearFirstHeaps(const unsigned number_of_nodes);
 
-    void InitializeOrClearSecondThreadLocalStorage(const unsigned number_of_nodes);
+    void InitializeOrClearSecondHeaps(const unsigned number_of_nodes);
 
-    void InitializeOrClearThirdThreadLocalStorage(const unsigned number_of_nodes);
+    void InitializeOrClearThirdHeaps(const unsigned number_of_nodes);
 };
 
 #endif // SEARCH_ENGINE_DATA_H
@@ -47,6 +47,7 @@ struct SegmentInformation
     TravelMode travel_mode;
     bool necessary;
     bool is_via_location;
+    SimplificationRank simplification_rank;
 
     explicit SegmentInformation(const FixedPointCoordinate &location,
                                 const NodeID name_id,
@@ -58,7 +59,7 @@ struct SegmentInformation
                                 const TravelMode travel_mode)
         : location(location), name_id(name_id), duration(duration), length(length), bearing(0),
           turn_instruction(turn_instruction), travel_mode(travel_mode), necessary(necessary),
-          is_via_location(is_via_location)
+          is_via_location(is_via_location), simplification_rank(INVALID_SIMPLIFICATION_RANK)
     {
     }
 
@@ -70,7 +71,8 @@ struct SegmentInformation
                                 const TravelMode travel_mode)
         : location(location), name_id(name_id), duration(duration), length(length), bearing(0),
           turn_instruction(turn_instruction), travel_mode(travel_mode),
-          necessary(turn_instruction != TurnInstruction::NoTurn), is_via_location(false)
+          necessary(turn_instruction != TurnInstruction::NoTurn), is_via_location(false),
+          simplification_rank(INVALID_SIMPLIFICATION_RANK)
     {
     }
 };
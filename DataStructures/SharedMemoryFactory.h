@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define SHARED_MEMORY_FACTORY_H
 
 #include "../Util/OSRMException.h"
+#include "../Util/Prefault.h"
 #include "../Util/simple_logger.hpp"
 
 #include <boost/filesystem.hpp>
@@ -97,6 +98,11 @@ class SharedMemory
   public:
     void *Ptr() const { return region.get_address(); }
 
+    uint64_t Size() const { return region.get_size(); }
+
+    // faults in all pages of the mapping and optionally locks them to RAM
+    void Prefault(const bool lock_to_ram) const { PrefaultMemory(Ptr(), Size(), lock_to_ram); }
+
     SharedMemory() = delete;
     SharedMemory(const SharedMemory &) = delete;
 
@@ -232,6 +238,11 @@ class SharedMemory
   public:
     void *Ptr() const { return region.get_address(); }
 
+    uint64_t Size() const { return region.get_size(); }
+
+    // faults in all pages of the mapping and optionally locks them to RAM
+    void Prefault(const bool lock_to_ram) const { PrefaultMemory(Ptr(), Size(), lock_to_ram); }
+
     SharedMemory(const boost::filesystem::path &lock_file,
                  const int id,
                  const uint64_t size = 0,
@@ -154,6 +154,19 @@ template <typename EdgeDataT, bool UseSharedMemory = false> class StaticGraph
         return EdgeIterator(node_array.at(n + 1).first_edge);
     }
 
+    // cache hints for the query loops: the node entry is fetched when a node enters a heap,
+    // its first edges once it is the next one to be settled
+    void PrefetchNode(const NodeIterator n) const { PrefetchForRead(&node_array[n]); }
+
+    void PrefetchEdges(const NodeIterator n) const
+    {
+        const EdgeIterator first_edge = node_array[n].first_edge;
+        if (first_edge < number_of_edges)
+        {
+            PrefetchForRead(&edge_array[first_edge]);
+        }
+    }
+
     // searches for a specific edge
     EdgeIterator FindEdge(const NodeIterator from, const NodeIterator to) const
     {
@@ -194,6 +207,15 @@ template <typename EdgeDataT, bool UseSharedMemory = false> class StaticGraph
     }
 
   private:
+    static void PrefetchForRead(const void *address)
+    {
+#if defined(__GNUC__)
+        __builtin_prefetch(address, 0, 3);
+#else
+        static_cast<void>(address);
+#endif
+    }
+
     NodeIterator number_of_nodes;
     EdgeIterator number_of_edges;
 
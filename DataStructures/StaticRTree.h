@@ -50,15 +50,24 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/filesystem/fstream.hpp>
 #include <boost/thread.hpp>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_sort.h>
 
 #include <algorithm>
 #include <array>
+#include <cerrno>
+#include <functional>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
 // Implements a static, i.e. packed, R-tree
@@ -205,6 +214,30 @@ class StaticRTree
             return min_dist;
         }
 
+        // Lower bound of the approximate distance to every point of the rectangle. Unlike
+        // GetMinDist it also holds when the rectangle spans many degrees of latitude, where the
+        // cosine of the mean latitude shrinks away from the closest corner, and it leaves room for
+        // the single precision radians of ApproximateEuclideanDistance (up to ~1.7m at 180 deg).
+        inline float GetMinDistLowerBound(const FixedPointCoordinate &location) const
+        {
+            const double APPROXIMATION_ERROR = 2.;
+            const double RAD = 0.017453292519943295769236907684886;
+            const double earth_radius = 6372797.560856;
+            const int64_t lat_delta = std::max<int64_t>(
+                0, std::max(int64_t(min_lat) - location.lat, int64_t(location.lat) - max_lat));
+            const int64_t lon_delta = std::max<int64_t>(
+                0, std::max(int64_t(min_lon) - location.lon, int64_t(location.lon) - max_lon));
+            const double max_mean_lat = std::max(std::abs(int64_t(location.lat) + min_lat),
+                                                 std::abs(int64_t(location.lat) + max_lat)) /
+                                        (2. * COORDINATE_PRECISION);
+            const double x_value = (lon_delta / COORDINATE_PRECISION) * RAD *
+                                   std::cos(std::min(90., max_mean_lat) * RAD);
+            const double y_value = (lat_delta / COORDINATE_PRECISION) * RAD;
+            return static_cast<float>(std::max(
+                0., std::sqrt(x_value * x_value + y_value * y_value) * earth_radius -
+                        APPROXIMATION_ERROR));
+        }
+
         inline float GetMinMaxDist(const FixedPointCoordinate &location) const
         {
             float min_max_dist = std::numeric_limits<float>::max();
@@ -280,15 +313,215 @@ class StaticRTree
 
         inline bool operator<(const WrappedInputElement &other) const
         {
-            return m_hilbert_value < other.m_hilbert_value;
+            // ties are broken by index to make in-memory and external sorting agree
+            return m_hilbert_value < other.m_hilbert_value ||
+                   (m_hilbert_value == other.m_hilbert_value &&
+                    m_array_index < other.m_array_index);
         }
     };
 
+    // Writes blocks of the leaf file at known offsets, possibly from several threads at once
+    class LeafFileWriter
+    {
+      public:
+        LeafFileWriter(const std::string &filename, const uint64_t file_size)
+        {
+#ifndef WIN32
+            file_descriptor = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (-1 == file_descriptor)
+            {
+                throw OSRMException("could not open leaf file " + filename);
+            }
+            if (0 != ::ftruncate(file_descriptor, file_size))
+            {
+                ::close(file_descriptor);
+                throw OSRMException("could not resize leaf file " + filename);
+            }
+#else
+            file_stream.open(filename, std::ios::binary | std::ios::out | std::ios::trunc);
+            if (0 < file_size)
+            {
+                file_stream.seekp(file_size - 1);
+                file_stream.put(0);
+            }
+            if (!file_stream.good())
+            {
+                throw OSRMException("could not open leaf file " + filename);
+            }
+#endif
+        }
+
+        LeafFileWriter(const LeafFileWriter &) = delete;
+        LeafFileWriter &operator=(const LeafFileWriter &) = delete;
+
+        ~LeafFileWriter()
+        {
+#ifndef WIN32
+            ::close(file_descriptor);
+#endif
+        }
+
+        void WriteAt(uint64_t offset, const void *data, std::size_t size)
+        {
+            const char *buffer = static_cast<const char *>(data);
+#ifndef WIN32
+            while (0 < size)
+            {
+                const ssize_t written = ::pwrite(file_descriptor, buffer, size, offset);
+                if (-1 == written)
+                {
+                    if (EINTR == errno)
+                    {
+                        continue;
+                    }
+                    throw OSRMException("writing to leaf file failed");
+                }
+                buffer += written;
+                size -= written;
+                offset += written;
+            }
+#else
+            std::lock_guard<std::mutex> lock(file_mutex);
+            file_stream.seekp(offset);
+            file_stream.write(buffer, size);
+            if (!file_stream.good())
+            {
+                throw OSRMException("writing to leaf file failed");
+            }
+#endif
+        }
+
+      private:
+#ifndef WIN32
+        int file_descriptor;
+#else
+        boost::filesystem::fstream file_stream;
+        std::mutex file_mutex;
+#endif
+    };
+
+    // Reads blocks of the leaf file at known offsets, the reads of concurrent queries do not
+    // share a file position
+    class LeafFileReader
+    {
+      public:
+        LeafFileReader()
+#ifndef WIN32
+            : file_descriptor(-1)
+#endif
+        {
+        }
+
+        LeafFileReader(const LeafFileReader &) = delete;
+        LeafFileReader &operator=(const LeafFileReader &) = delete;
+
+        ~LeafFileReader()
+        {
+#ifndef WIN32
+            if (-1 != file_descriptor)
+            {
+                ::close(file_descriptor);
+            }
+#endif
+        }
+
+        void Open(const std::string &filename)
+        {
+#ifndef WIN32
+            file_descriptor = ::open(filename.c_str(), O_RDONLY);
+            if (-1 == file_descriptor)
+            {
+                throw OSRMException("could not open leaf file " + filename);
+            }
+#else
+            file_stream.open(filename, std::ios::binary | std::ios::in);
+            if (!file_stream.good())
+            {
+                throw OSRMException("could not open leaf file " + filename);
+            }
+#endif
+        }
+
+        void ReadAt(uint64_t offset, void *data, std::size_t size)
+        {
+            char *buffer = static_cast<char *>(data);
+#ifndef WIN32
+            while (0 < size)
+            {
+                const ssize_t bytes_read = ::pread(file_descriptor, buffer, size, offset);
+                if (-1 == bytes_read && EINTR == errno)
+                {
+                    continue;
+                }
+                if (0 >= bytes_read)
+                {
+                    throw OSRMException("reading from leaf file failed");
+                }
+                buffer += bytes_read;
+                size -= bytes_read;
+                offset += bytes_read;
+            }
+#else
+            std::lock_guard<std::mutex> lock(file_mutex);
+            file_stream.seekg(offset);
+            file_stream.read(buffer, size);
+            if (!file_stream.good())
+            {
+                file_stream.clear();
+                throw OSRMException("reading from leaf file failed");
+            }
+#endif
+        }
+
+      private:
+#ifndef WIN32
+        int file_descriptor;
+#else
+        boost::filesystem::ifstream file_stream;
+        std::mutex file_mutex;
+#endif
+    };
+
+    // Leaves only store the end points of their segments, quantized relative to the lower left
+    // corner of the leaf's bounding box. The full records follow all leaves in the leaf file and
+    // are read for those segments only whose quantized bounds cannot be pruned.
+    struct QuantizedSegment
+    {
+        uint16_t u_lat;
+        uint16_t u_lon;
+        uint16_t v_lat;
+        uint16_t v_lon;
+    };
+
     struct LeafNode
     {
-        LeafNode() : object_count(0), objects() {}
+        LeafNode()
+            : object_count(0), shift(0), base_lat(0), base_lon(0), tiny_cc_flags(), segments()
+        {
+        }
         uint32_t object_count;
-        std::array<EdgeDataT, LEAF_NODE_SIZE> objects;
+        // quantization step is 2^shift in fixed point units
+        uint32_t shift;
+        int32_t base_lat;
+        int32_t base_lon;
+        std::array<uint32_t, (LEAF_NODE_SIZE + 31) / 32> tiny_cc_flags;
+        std::array<QuantizedSegment, LEAF_NODE_SIZE> segments;
+
+        inline bool IsInTinyComponent(const uint32_t index) const
+        {
+            return 0 != (tiny_cc_flags[index / 32] & (1u << (index % 32)));
+        }
+    };
+
+    // a leaf segment that is queued by the lower bound of its quantized end points
+    struct LeafSegmentReference
+    {
+        LeafSegmentReference(const uint32_t leaf_id, const uint32_t index)
+            : leaf_id(leaf_id), index(index)
+        {
+        }
+        uint32_t leaf_id;
+        uint32_t index;
     };
 
     struct QueryCandidate
@@ -307,7 +540,8 @@ class StaticRTree
         }
     };
 
-    using IncrementalQueryNodeType = mapbox::util::variant<TreeNode, EdgeDataT>;
+    using IncrementalQueryNodeType =
+        mapbox::util::variant<TreeNode, LeafSegmentReference, EdgeDataT>;
     struct IncrementalQueryCandidate
     {
         explicit IncrementalQueryCandidate(const float dist, const IncrementalQueryNodeType &node)
@@ -327,21 +561,28 @@ class StaticRTree
         IncrementalQueryNodeType node;
     };
 
+    // bytes of sort keys that are sorted in memory, i.e. 64M elements
+    static constexpr uint64_t DEFAULT_SORT_MEMORY_LIMIT = 1024 * 1024 * 1024;
+
     typename ShM<TreeNode, UseSharedMemory>::vector m_search_tree;
     uint64_t m_element_count;
     const std::string m_leaf_node_filename;
     std::shared_ptr<CoordinateListT> m_coordinate_list;
-    boost::filesystem::ifstream leaves_stream;
+    // opened by the read-only constructors, shared by all threads that query the tree
+    LeafFileReader leaves_file;
 
   public:
     StaticRTree() = delete;
     StaticRTree(const StaticRTree &) = delete;
 
-    // Construct a packed Hilbert-R-Tree with Kamel-Faloutsos algorithm [1]
+    // Construct a packed Hilbert-R-Tree with Kamel-Faloutsos algorithm [1]. Leaves are packed
+    // and written in parallel. Inputs whose sort keys exceed sort_memory_limit bytes are sorted
+    // externally in runs next to the leaf file.
     explicit StaticRTree(std::vector<EdgeDataT> &input_data_vector,
                          const std::string tree_node_filename,
                          const std::string leaf_node_filename,
-                         const std::vector<NodeInfo> &coordinate_list)
+                         const std::vector<NodeInfo> &coordinate_list,
+                         const uint64_t sort_memory_limit = DEFAULT_SORT_MEMORY_LIMIT)
         : m_element_count(input_data_vector.size()), m_leaf_node_filename(leaf_node_filename)
     {
         SimpleLogger().Write() << "constructing r-tree of " << m_element_count
@@ -349,82 +590,42 @@ class StaticRTree
                                << " coordinates";
 
         TIMER_START(construction);
-        std::vector<WrappedInputElement> input_wrapper_vector(m_element_count);
-
-        HilbertCode get_hilbert_number;
-
-        // generate auxiliary vector of hilbert-values
-        tbb::parallel_for(
-            tbb::blocked_range<uint64_t>(0, m_element_count),
-            [&input_data_vector, &input_wrapper_vector, &get_hilbert_number, &coordinate_list](
-                const tbb::blocked_range<uint64_t> &range)
-            {
-                for (uint64_t element_counter = range.begin(); element_counter != range.end();
-                     ++element_counter)
-                {
-                    WrappedInputElement &current_wrapper = input_wrapper_vector[element_counter];
-                    current_wrapper.m_array_index = element_counter;
-
-                    EdgeDataT const &current_element = input_data_vector[element_counter];
-
-                    // Get Hilbert-Value for centroid in mercartor projection
-                    FixedPointCoordinate current_centroid = EdgeDataT::Centroid(
-                        FixedPointCoordinate(coordinate_list.at(current_element.u).lat,
-                                             coordinate_list.at(current_element.u).lon),
-                        FixedPointCoordinate(coordinate_list.at(current_element.v).lat,
-                                             coordinate_list.at(current_element.v).lon));
-                    current_centroid.lat =
-                        COORDINATE_PRECISION * lat2y(current_centroid.lat / COORDINATE_PRECISION);
-
-                    current_wrapper.m_hilbert_value = get_hilbert_number(current_centroid);
-                }
-            });
-
-        // open leaf file
-        boost::filesystem::ofstream leaf_node_file(leaf_node_filename, std::ios::binary);
-        leaf_node_file.write((char *)&m_element_count, sizeof(uint64_t));
-
-        // sort the hilbert-value representatives
-        tbb::parallel_sort(input_wrapper_vector.begin(), input_wrapper_vector.end());
-        std::vector<TreeNode> tree_nodes_in_level;
-
-        // pack M elements into leaf node and write to leaf file
-        uint64_t processed_objects_count = 0;
-        while (processed_objects_count < m_element_count)
+        TIMER_START(packing);
+        // open leaf file, its size is known up front so that leaves can be written in any order
+        LeafFileWriter leaf_node_file(leaf_node_filename, GetLeafFileSize());
+        leaf_node_file.WriteAt(0, &m_element_count, sizeof(uint64_t));
+
+        std::vector<TreeNode> tree_nodes_in_level(GetNumberOfLeaves());
+        const uint64_t max_elements_in_memory = std::max(
+            uint64_t(LEAF_NODE_SIZE),
+            sort_memory_limit / sizeof(WrappedInputElement) / LEAF_NODE_SIZE * LEAF_NODE_SIZE);
+        if (m_element_count <= max_elements_in_memory)
         {
-
-            LeafNode current_leaf;
-            TreeNode current_node;
-            // SimpleLogger().Write() << "reading " << tree_size << " tree nodes in " <<
-            // (sizeof(TreeNode)*tree_size) << " bytes";
-            for (uint32_t current_element_index = 0; LEAF_NODE_SIZE > current_element_index;
-                 ++current_element_index)
-            {
-                if (m_element_count > (processed_objects_count + current_element_index))
-                {
-                    uint32_t index_of_next_object =
-                        input_wrapper_vector[processed_objects_count + current_element_index]
-                            .m_array_index;
-                    current_leaf.objects[current_element_index] =
-                        input_data_vector[index_of_next_object];
-                    ++current_leaf.object_count;
-                }
-            }
-
-            // generate tree node that resemble the objects in leaf and store it for next level
-            current_node.minimum_bounding_rectangle.InitializeMBRectangle(
-                current_leaf.objects, current_leaf.object_count, coordinate_list);
-            current_node.child_is_on_disk = true;
-            current_node.children[0] = tree_nodes_in_level.size();
-            tree_nodes_in_level.emplace_back(current_node);
-
-            // write leaf_node to leaf node file
-            leaf_node_file.write((char *)&current_leaf, sizeof(current_leaf));
-            processed_objects_count += current_leaf.object_count;
+            std::vector<WrappedInputElement> input_wrapper_vector(m_element_count);
+            ComputeHilbertValues(input_data_vector, coordinate_list, 0, input_wrapper_vector);
+
+            // sort the hilbert-value representatives
+            tbb::parallel_sort(input_wrapper_vector.begin(), input_wrapper_vector.end());
+            PackLeaves(input_wrapper_vector,
+                       0,
+                       input_data_vector,
+                       coordinate_list,
+                       leaf_node_file,
+                       tree_nodes_in_level);
         }
-
-        // close leaf file
-        leaf_node_file.close();
+        else
+        {
+            SimpleLogger().Write() << "sorting r-tree elements externally in runs of "
+                                   << max_elements_in_memory << " elements";
+            ExternalSortAndPackLeaves(input_data_vector,
+                                      coordinate_list,
+                                      max_elements_in_memory,
+                                      leaf_node_file,
+                                      tree_nodes_in_level);
+        }
+        TIMER_STOP(packing);
+        SimpleLogger().Write() << "packed " << tree_nodes_in_level.size() << " leaves in "
+                               << TIMER_SEC(packing) << " seconds";
 
         uint32_t processing_level = 0;
         while (1 < tree_nodes_in_level.size())
@@ -525,7 +726,7 @@ class StaticRTree
             tree_node_file.read((char *)&m_search_tree[0], sizeof(TreeNode) * tree_size);
         }
         tree_node_file.close();
-        // open leaf node file and store thread specific pointer
+        // open leaf node file
         if (!boost::filesystem::exists(leaf_file))
         {
             throw OSRMException("mem index file does not exist");
@@ -535,8 +736,12 @@ class StaticRTree
             throw OSRMException("mem index file is empty");
         }
 
-        leaves_stream.open(leaf_file, std::ios::binary);
-        leaves_stream.read((char *)&m_element_count, sizeof(uint64_t));
+        leaves_file.Open(leaf_file.string());
+        leaves_file.ReadAt(0, &m_element_count, sizeof(uint64_t));
+        if (boost::filesystem::file_size(leaf_file) != GetLeafFileSize())
+        {
+            throw OSRMException("mem index file has unexpected size, rerun osrm-prepare");
+        }
 
         // SimpleLogger().Write() << tree_size << " nodes in search tree";
         // SimpleLogger().Write() << m_element_count << " elements in leafs";
@@ -549,7 +754,7 @@ class StaticRTree
         : m_search_tree(tree_node_ptr, number_of_nodes), m_leaf_node_filename(leaf_file.string()),
           m_coordinate_list(coordinate_list)
     {
-        // open leaf node file and store thread specific pointer
+        // open leaf node file
         if (!boost::filesystem::exists(leaf_file))
         {
             throw OSRMException("mem index file does not exist");
@@ -559,8 +764,12 @@ class StaticRTree
             throw OSRMException("mem index file is empty");
         }
 
-        leaves_stream.open(leaf_file, std::ios::binary);
-        leaves_stream.read((char *)&m_element_count, sizeof(uint64_t));
+        leaves_file.Open(leaf_file.string());
+        leaves_file.ReadAt(0, &m_element_count, sizeof(uint64_t));
+        if (boost::filesystem::file_size(leaf_file) != GetLeafFileSize())
+        {
+            throw OSRMException("mem index file has unexpected size, rerun osrm-prepare");
+        }
 
         // SimpleLogger().Write() << tree_size << " nodes in search tree";
         // SimpleLogger().Write() << m_element_count << " elements in leafs";
@@ -579,6 +788,7 @@ class StaticRTree
         // initialize queue with root element
         std::priority_queue<QueryCandidate> traversal_queue;
         traversal_queue.emplace(0.f, 0);
+        std::vector<QueryCandidate> leaf_candidates;
 
         while (!traversal_queue.empty())
         {
@@ -592,15 +802,22 @@ class StaticRTree
                 TreeNode &current_tree_node = m_search_tree[current_query_node.node_id];
                 if (current_tree_node.child_is_on_disk)
                 {
+                    const uint32_t leaf_id = current_tree_node.children[0];
                     LeafNode current_leaf_node;
-                    LoadLeafFromDisk(current_tree_node.children[0], current_leaf_node);
-                    for (uint32_t i = 0; i < current_leaf_node.object_count; ++i)
+                    LoadLeafFromDisk(leaf_id, current_leaf_node);
+                    GetLeafCandidates(current_leaf_node,
+                                      input_coordinate,
+                                      ignore_tiny_components,
+                                      min_dist,
+                                      leaf_candidates);
+                    for (const QueryCandidate &candidate : leaf_candidates)
                     {
-                        EdgeDataT const &current_edge = current_leaf_node.objects[i];
-                        if (ignore_tiny_components && current_edge.is_in_tiny_cc)
+                        if (candidate.min_dist >= min_dist)
                         {
-                            continue;
+                            break;
                         }
+                        EdgeDataT current_edge;
+                        LoadObjectFromDisk(leaf_id, candidate.node_id, current_edge);
 
                         float current_minimum_distance =
                             FixedPointCoordinate::ApproximateEuclideanDistance(
@@ -697,23 +914,20 @@ class StaticRTree
                     //     current_tree_node.minimum_bounding_rectangle.max_lat/COORDINATE_PRECISION << "-" <<
                     //     current_tree_node.minimum_bounding_rectangle.max_lon/COORDINATE_PRECISION << "]";
 
+                    const uint32_t leaf_id = current_tree_node.children[0];
                     LeafNode current_leaf_node;
-                    LoadLeafFromDisk(current_tree_node.children[0], current_leaf_node);
-                    // Add all objects from leaf into queue
+                    LoadLeafFromDisk(leaf_id, current_leaf_node);
+                    // Add all objects from leaf into queue, ranked by their quantized bounds
                     for (uint32_t i = 0; i < current_leaf_node.object_count; ++i)
                     {
-                        const auto &current_edge = current_leaf_node.objects[i];
-                        const float current_perpendicular_distance =
-                            FixedPointCoordinate::ComputePerpendicularDistance(
-                                m_coordinate_list->at(current_edge.u),
-                                m_coordinate_list->at(current_edge.v),
-                                input_coordinate);
-                        // distance must be non-negative
-                        BOOST_ASSERT(0. <= current_perpendicular_distance);
+                        const float lower_bound_to_segment =
+                            GetSegmentBounds(current_leaf_node, i)
+                                .GetMinDistLowerBound(input_coordinate);
 
-                        if (current_perpendicular_distance < current_min_dist)
+                        if (lower_bound_to_segment < current_min_dist)
                         {
-                            traversal_queue.emplace(current_perpendicular_distance, current_edge);
+                            traversal_queue.emplace(lower_bound_to_segment,
+                                                    LeafSegmentReference(leaf_id, i));
                         }
                         else
                         {
@@ -756,6 +970,30 @@ class StaticRTree
                     // SimpleLogger().Write(logDEBUG) << "added " << current_tree_node.child_count << " mbrs into queue of " << traversal_queue.size();
                 }
             }
+            else if (current_query_node.node.template is<LeafSegmentReference>())
+            {
+                // requeue the segment with its exact distance
+                const LeafSegmentReference &reference =
+                    current_query_node.node.template get<LeafSegmentReference>();
+                EdgeDataT current_edge;
+                LoadObjectFromDisk(reference.leaf_id, reference.index, current_edge);
+                const float current_perpendicular_distance =
+                    FixedPointCoordinate::ComputePerpendicularDistance(
+                        m_coordinate_list->at(current_edge.u),
+                        m_coordinate_list->at(current_edge.v),
+                        input_coordinate);
+                // distance must be non-negative
+                BOOST_ASSERT(0. <= current_perpendicular_distance);
+
+                if (current_perpendicular_distance < current_min_dist)
+                {
+                    traversal_queue.emplace(current_perpendicular_distance, current_edge);
+                }
+                else
+                {
+                    ++ignored_segments;
+                }
+            }
             else
             {
                 ++inspected_segments;
@@ -888,28 +1126,25 @@ class StaticRTree
                 continue;
             }
 
-            if (current_query_node.RepresentsTreeNode())
+            if (current_query_node.node.template is<TreeNode>())
             {
                 const TreeNode & current_tree_node = current_query_node.node.template get<TreeNode>();
                 if (current_tree_node.child_is_on_disk)
                 {
+                    const uint32_t leaf_id = current_tree_node.children[0];
                     LeafNode current_leaf_node;
-                    LoadLeafFromDisk(current_tree_node.children[0], current_leaf_node);
-                    // Add all objects from leaf into queue
+                    LoadLeafFromDisk(leaf_id, current_leaf_node);
+                    // Add all objects from leaf into queue, ranked by their quantized bounds
                     for (uint32_t i = 0; i < current_leaf_node.object_count; ++i)
                     {
-                        const auto &current_edge = current_leaf_node.objects[i];
-                        const float current_perpendicular_distance =
-                            FixedPointCoordinate::ComputePerpendicularDistance(
-                                m_coordinate_list->at(current_edge.u),
-                                m_coordinate_list->at(current_edge.v),
-                                input_coordinate);
-                        // distance must be non-negative
-                        BOOST_ASSERT(0. <= current_perpendicular_distance);
+                        const float lower_bound_to_segment =
+                            GetSegmentBounds(current_leaf_node, i)
+                                .GetMinDistLowerBound(input_coordinate);
 
-                        if (current_perpendicular_distance < current_min_dist)
+                        if (lower_bound_to_segment < current_min_dist)
                         {
-                            traversal_queue.emplace(current_perpendicular_distance, current_edge);
+                            traversal_queue.emplace(lower_bound_to_segment,
+                                                    LeafSegmentReference(leaf_id, i));
                         }
                     }
                 }
@@ -935,6 +1170,26 @@ class StaticRTree
                     // SimpleLogger().Write(logDEBUG) << "added " << current_tree_node.child_count << " mbrs into queue of " << traversal_queue.size();
                 }
             }
+            else if (current_query_node.node.template is<LeafSegmentReference>())
+            {
+                // requeue the segment with its exact distance
+                const LeafSegmentReference &reference =
+                    current_query_node.node.template get<LeafSegmentReference>();
+                EdgeDataT current_edge;
+                LoadObjectFromDisk(reference.leaf_id, reference.index, current_edge);
+                const float current_perpendicular_distance =
+                    FixedPointCoordinate::ComputePerpendicularDistance(
+                        m_coordinate_list->at(current_edge.u),
+                        m_coordinate_list->at(current_edge.v),
+                        input_coordinate);
+                // distance must be non-negative
+                BOOST_ASSERT(0. <= current_perpendicular_distance);
+
+                if (current_perpendicular_distance < current_min_dist)
+                {
+                    traversal_queue.emplace(current_perpendicular_distance, current_edge);
+                }
+            }
             else
             {
                 ++inspected_segments;
@@ -969,26 +1224,28 @@ class StaticRTree
                 if ((current_perpendicular_distance < current_min_dist) &&
                     !osrm::epsilon_compare(current_perpendicular_distance, current_min_dist))
                 {
-                    // store phantom node in result vector
+                    // store phantom node and its distance in result vector
                     result_phantom_node_vector.emplace_back(
-                        current_segment.forward_edge_based_node_id,
-                        current_segment.reverse_edge_based_node_id,
-                        current_segment.name_id,
-                        current_segment.forward_weight,
-                        current_segment.reverse_weight,
-                        current_segment.forward_offset,
-                        current_segment.reverse_offset,
-                        current_segment.packed_geometry_id,
-                        foot_point_coordinate_on_segment,
-                        current_segment.fwd_segment_position,
+                        PhantomNode(current_segment.forward_edge_based_node_id,
+                                    current_segment.reverse_edge_based_node_id,
+                                    current_segment.name_id,
+                                    current_segment.forward_weight,
+                                    current_segment.reverse_weight,
+                                    current_segment.forward_offset,
+                                    current_segment.reverse_offset,
+                                    current_segment.packed_geometry_id,
+                                    foot_point_coordinate_on_segment,
+                                    current_segment.fwd_segment_position,
+                                    current_segment.forward_travel_mode,
+                                    current_segment.backward_travel_mode),
                         current_perpendicular_distance);
 
                     // Hack to fix rounding errors and wandering via nodes.
-                    FixUpRoundingIssue(input_coordinate, result_phantom_node_vector.back());
+                    FixUpRoundingIssue(input_coordinate, result_phantom_node_vector.back().first);
 
                     // set forward and reverse weights on the phantom node
                     SetForwardAndReverseWeightsOnPhantomNode(current_segment,
-                                                             result_phantom_node_vector.back());
+                                                             result_phantom_node_vector.back().first);
 
                     // do we have results only in a small scc
                     if (current_segment.is_in_tiny_cc)
@@ -1031,6 +1288,7 @@ class StaticRTree
 
         std::priority_queue<QueryCandidate> traversal_queue;
         traversal_queue.emplace(0.f, 0);
+        std::vector<QueryCandidate> leaf_candidates;
 
         while (!traversal_queue.empty())
         {
@@ -1044,15 +1302,22 @@ class StaticRTree
                 const TreeNode &current_tree_node = m_search_tree[current_query_node.node_id];
                 if (current_tree_node.child_is_on_disk)
                 {
+                    const uint32_t leaf_id = current_tree_node.children[0];
                     LeafNode current_leaf_node;
-                    LoadLeafFromDisk(current_tree_node.children[0], current_leaf_node);
-                    for (uint32_t i = 0; i < current_leaf_node.object_count; ++i)
+                    LoadLeafFromDisk(leaf_id, current_leaf_node);
+                    GetLeafCandidates(current_leaf_node,
+                                      input_coordinate,
+                                      ignore_tiny_components,
+                                      min_dist,
+                                      leaf_candidates);
+                    for (const QueryCandidate &candidate : leaf_candidates)
                     {
-                        const EdgeDataT &current_edge = current_leaf_node.objects[i];
-                        if (ignore_tiny_components && current_edge.is_in_tiny_cc)
+                        if (candidate.min_dist >= min_dist)
                         {
-                            continue;
+                            break;
                         }
+                        EdgeDataT current_edge;
+                        LoadObjectFromDisk(leaf_id, candidate.node_id, current_edge);
 
                         float current_ratio = 0.;
                         FixedPointCoordinate nearest;
@@ -1127,6 +1392,20 @@ class StaticRTree
         {
             result_phantom_node.reverse_weight *= (1.f - ratio);
         }
+
+        // lengths are measured like the geometry of the segment, in decimeters
+        result_phantom_node.forward_length =
+            nearest_edge.forward_length_offset +
+            static_cast<int>(10. * FixedPointCoordinate::ApproximateDistance(
+                                       m_coordinate_list->at(nearest_edge.u),
+                                       result_phantom_node.location) +
+                             .5);
+        result_phantom_node.reverse_length =
+            nearest_edge.reverse_length_offset +
+            static_cast<int>(10. * FixedPointCoordinate::ApproximateDistance(
+                                       result_phantom_node.location,
+                                       m_coordinate_list->at(nearest_edge.v)) +
+                             .5);
     }
 
     // fixup locations if too close to inputs
@@ -1175,21 +1454,292 @@ class StaticRTree
 
     inline void LoadLeafFromDisk(const uint32_t leaf_id, LeafNode &result_node)
     {
-        if (!leaves_stream.is_open())
+        const uint64_t seek_pos = sizeof(uint64_t) + uint64_t(leaf_id) * sizeof(LeafNode);
+        leaves_file.ReadAt(seek_pos, &result_node, sizeof(LeafNode));
+    }
+
+    inline void LoadObjectFromDisk(const uint32_t leaf_id, const uint32_t index, EdgeDataT &result)
+    {
+        const uint64_t seek_pos =
+            GetObjectsOffset() + (uint64_t(leaf_id) * LEAF_NODE_SIZE + index) * sizeof(EdgeDataT);
+        leaves_file.ReadAt(seek_pos, &result, sizeof(EdgeDataT));
+    }
+
+    inline uint64_t GetNumberOfLeaves() const
+    {
+        return (m_element_count + LEAF_NODE_SIZE - 1) / LEAF_NODE_SIZE;
+    }
+
+    inline uint64_t GetObjectsOffset() const
+    {
+        return sizeof(uint64_t) + GetNumberOfLeaves() * sizeof(LeafNode);
+    }
+
+    inline uint64_t GetLeafFileSize() const
+    {
+        return GetObjectsOffset() + m_element_count * sizeof(EdgeDataT);
+    }
+
+    // Hilbert values of the elements [first_element, first_element + output.size())
+    static void ComputeHilbertValues(const std::vector<EdgeDataT> &input_data_vector,
+                                     const std::vector<NodeInfo> &coordinate_list,
+                                     const uint64_t first_element,
+                                     std::vector<WrappedInputElement> &input_wrapper_vector)
+    {
+        HilbertCode get_hilbert_number;
+
+        // generate auxiliary vector of hilbert-values
+        tbb::parallel_for(
+            tbb::blocked_range<uint64_t>(0, input_wrapper_vector.size()),
+            [&input_data_vector,
+             &input_wrapper_vector,
+             &get_hilbert_number,
+             &coordinate_list,
+             first_element](const tbb::blocked_range<uint64_t> &range)
+            {
+                for (uint64_t element_counter = range.begin(); element_counter != range.end();
+                     ++element_counter)
+                {
+                    WrappedInputElement &current_wrapper = input_wrapper_vector[element_counter];
+                    current_wrapper.m_array_index = first_element + element_counter;
+
+                    EdgeDataT const &current_element =
+                        input_data_vector[current_wrapper.m_array_index];
+
+                    // Get Hilbert-Value for centroid in mercartor projection
+                    FixedPointCoordinate current_centroid = EdgeDataT::Centroid(
+                        FixedPointCoordinate(coordinate_list.at(current_element.u).lat,
+                                             coordinate_list.at(current_element.u).lon),
+                        FixedPointCoordinate(coordinate_list.at(current_element.v).lat,
+                                             coordinate_list.at(current_element.v).lon));
+                    current_centroid.lat =
+                        COORDINATE_PRECISION * lat2y(current_centroid.lat / COORDINATE_PRECISION);
+
+                    current_wrapper.m_hilbert_value = get_hilbert_number(current_centroid);
+                }
+            });
+    }
+
+    // Packs a sorted batch of elements that starts at the leaf aligned position first_element
+    // into leaves, writes them together with their full records and stores the leaf MBRs.
+    void PackLeaves(const std::vector<WrappedInputElement> &sorted_batch,
+                    const uint64_t first_element,
+                    const std::vector<EdgeDataT> &input_data_vector,
+                    const std::vector<NodeInfo> &coordinate_list,
+                    LeafFileWriter &leaf_node_file,
+                    std::vector<TreeNode> &tree_nodes_in_level) const
+    {
+        BOOST_ASSERT(0 == first_element % LEAF_NODE_SIZE);
+        const uint64_t number_of_leaves = (sorted_batch.size() + LEAF_NODE_SIZE - 1) / LEAF_NODE_SIZE;
+        const uint64_t objects_offset = GetObjectsOffset();
+        tbb::parallel_for(
+            tbb::blocked_range<uint64_t>(0, number_of_leaves),
+            [&](const tbb::blocked_range<uint64_t> &range)
+            {
+                std::array<EdgeDataT, LEAF_NODE_SIZE> objects;
+                for (uint64_t i = range.begin(); i != range.end(); ++i)
+                {
+                    const uint64_t first_in_leaf = i * LEAF_NODE_SIZE;
+                    const uint32_t object_count = static_cast<uint32_t>(
+                        std::min(uint64_t(LEAF_NODE_SIZE), sorted_batch.size() - first_in_leaf));
+                    for (uint32_t j = 0; j < object_count; ++j)
+                    {
+                        objects[j] =
+                            input_data_vector[sorted_batch[first_in_leaf + j].m_array_index];
+                    }
+
+                    // generate tree node that resemble the objects in leaf
+                    const uint64_t leaf_id = first_element / LEAF_NODE_SIZE + i;
+                    TreeNode &current_node = tree_nodes_in_level[leaf_id];
+                    current_node.minimum_bounding_rectangle.InitializeMBRectangle(
+                        objects, object_count, coordinate_list);
+                    current_node.child_is_on_disk = true;
+                    current_node.children[0] = static_cast<uint32_t>(leaf_id);
+
+                    // write quantized leaf_node to leaf node file
+                    LeafNode current_leaf;
+                    EncodeLeaf(objects,
+                               object_count,
+                               current_node.minimum_bounding_rectangle,
+                               coordinate_list,
+                               current_leaf);
+                    leaf_node_file.WriteAt(sizeof(uint64_t) + leaf_id * sizeof(LeafNode),
+                                           &current_leaf,
+                                           sizeof(LeafNode));
+
+                    // full records in leaf order, i.e. the j-th object of leaf i is at
+                    // i*LEAF_NODE_SIZE+j
+                    leaf_node_file.WriteAt(objects_offset +
+                                               leaf_id * LEAF_NODE_SIZE * sizeof(EdgeDataT),
+                                           objects.data(),
+                                           object_count * sizeof(EdgeDataT));
+                }
+            });
+    }
+
+    // Sorts runs of run_size elements in memory, spills them next to the leaf file and packs
+    // leaves from a k-way merge of the runs. run_size must be a multiple of LEAF_NODE_SIZE.
+    void ExternalSortAndPackLeaves(const std::vector<EdgeDataT> &input_data_vector,
+                                   const std::vector<NodeInfo> &coordinate_list,
+                                   const uint64_t run_size,
+                                   LeafFileWriter &leaf_node_file,
+                                   std::vector<TreeNode> &tree_nodes_in_level) const
+    {
+        BOOST_ASSERT(0 == run_size % LEAF_NODE_SIZE);
+        std::vector<boost::filesystem::path> run_paths;
+        std::vector<WrappedInputElement> batch;
+        for (uint64_t first_element = 0; first_element < m_element_count;
+             first_element += run_size)
+        {
+            batch.resize(std::min(run_size, m_element_count - first_element));
+            ComputeHilbertValues(input_data_vector, coordinate_list, first_element, batch);
+            tbb::parallel_sort(batch.begin(), batch.end());
+
+            run_paths.emplace_back(m_leaf_node_filename + ".run" +
+                                   std::to_string(run_paths.size()));
+            boost::filesystem::ofstream run_file(run_paths.back(), std::ios::binary);
+            run_file.write((char *)&batch[0], batch.size() * sizeof(WrappedInputElement));
+            if (!run_file.good())
+            {
+                throw OSRMException("could not write sort run " + run_paths.back().string());
+            }
+        }
+
+        // merge queue holds the smallest unmerged element of each run
+        using MergeEntry = std::pair<WrappedInputElement, uint32_t>;
+        std::priority_queue<MergeEntry, std::vector<MergeEntry>, std::greater<MergeEntry>>
+            merge_queue;
+        std::vector<std::unique_ptr<boost::filesystem::ifstream>> run_files;
+        const auto read_next = [&run_files, &merge_queue](const uint32_t run_id)
+        {
+            WrappedInputElement element;
+            if (run_files[run_id]->read((char *)&element, sizeof(WrappedInputElement)))
+            {
+                merge_queue.emplace(element, run_id);
+            }
+        };
+        for (uint32_t run_id = 0; run_id < run_paths.size(); ++run_id)
+        {
+            run_files.emplace_back(new boost::filesystem::ifstream(run_paths[run_id],
+                                                                   std::ios::binary));
+            read_next(run_id);
+        }
+
+        uint64_t first_element = 0;
+        batch.clear();
+        while (!merge_queue.empty())
+        {
+            const MergeEntry entry = merge_queue.top();
+            merge_queue.pop();
+            batch.emplace_back(entry.first);
+            read_next(entry.second);
+            if (run_size == batch.size() || merge_queue.empty())
+            {
+                PackLeaves(batch,
+                           first_element,
+                           input_data_vector,
+                           coordinate_list,
+                           leaf_node_file,
+                           tree_nodes_in_level);
+                first_element += batch.size();
+                batch.clear();
+            }
+        }
+        BOOST_ASSERT(m_element_count == first_element);
+        if (m_element_count != first_element)
+        {
+            throw OSRMException("reading sort runs failed");
+        }
+
+        run_files.clear();
+        for (const boost::filesystem::path &run_path : run_paths)
+        {
+            boost::filesystem::remove(run_path);
+        }
+    }
+
+    static void EncodeLeaf(const std::array<EdgeDataT, LEAF_NODE_SIZE> &objects,
+                           const uint32_t object_count,
+                           const RectangleT &bounding_box,
+                           const std::vector<NodeInfo> &coordinate_list,
+                           LeafNode &leaf)
+    {
+        const uint32_t span =
+            std::max(static_cast<uint32_t>(int64_t(bounding_box.max_lat) - bounding_box.min_lat),
+                     static_cast<uint32_t>(int64_t(bounding_box.max_lon) - bounding_box.min_lon));
+        leaf.object_count = object_count;
+        leaf.shift = 0;
+        while ((span >> leaf.shift) > std::numeric_limits<uint16_t>::max())
         {
-            leaves_stream.open(m_leaf_node_filename, std::ios::in | std::ios::binary);
+            ++leaf.shift;
         }
-        if (!leaves_stream.good())
+        leaf.base_lat = bounding_box.min_lat;
+        leaf.base_lon = bounding_box.min_lon;
+
+        const auto quantize = [&leaf](const int32_t value, const int32_t base)
         {
-            leaves_stream.clear(std::ios::goodbit);
-            SimpleLogger().Write(logDEBUG) << "Resetting stale filestream";
+            return static_cast<uint16_t>((int64_t(value) - base) >> leaf.shift);
+        };
+        for (uint32_t i = 0; i < object_count; ++i)
+        {
+            const NodeInfo &u = coordinate_list.at(objects[i].u);
+            const NodeInfo &v = coordinate_list.at(objects[i].v);
+            leaf.segments[i].u_lat = quantize(u.lat, leaf.base_lat);
+            leaf.segments[i].u_lon = quantize(u.lon, leaf.base_lon);
+            leaf.segments[i].v_lat = quantize(v.lat, leaf.base_lat);
+            leaf.segments[i].v_lon = quantize(v.lon, leaf.base_lon);
+            if (objects[i].is_in_tiny_cc)
+            {
+                leaf.tiny_cc_flags[i / 32] |= (1u << (i % 32));
+            }
         }
-        const uint64_t seek_pos = sizeof(uint64_t) + leaf_id * sizeof(LeafNode);
-        leaves_stream.seekg(seek_pos);
-        BOOST_ASSERT_MSG(leaves_stream.good(),
-                         "Seeking to position in leaf file failed.");
-        leaves_stream.read((char *)&result_node, sizeof(LeafNode));
-        BOOST_ASSERT_MSG(leaves_stream.good(), "Reading from leaf file failed.");
+    }
+
+    // Rectangle that contains the exact segment: quantization truncates towards the base, and
+    // a foot point on the segment may be truncated by one more unit.
+    static RectangleT GetSegmentBounds(const LeafNode &leaf, const uint32_t index)
+    {
+        const QuantizedSegment &segment = leaf.segments[index];
+        const int64_t step = int64_t(1) << leaf.shift;
+        RectangleT bounds;
+        bounds.min_lat = static_cast<int32_t>(
+            leaf.base_lat + std::min(segment.u_lat, segment.v_lat) * step - 1);
+        bounds.max_lat = static_cast<int32_t>(
+            leaf.base_lat + (std::max(segment.u_lat, segment.v_lat) + 1) * step);
+        bounds.min_lon = static_cast<int32_t>(
+            leaf.base_lon + std::min(segment.u_lon, segment.v_lon) * step - 1);
+        bounds.max_lon = static_cast<int32_t>(
+            leaf.base_lon + (std::max(segment.u_lon, segment.v_lon) + 1) * step);
+        return bounds;
+    }
+
+    // segments of a leaf that may be closer than max_dist, sorted by their lower bounds
+    static void GetLeafCandidates(const LeafNode &leaf,
+                                  const FixedPointCoordinate &input_coordinate,
+                                  const bool ignore_tiny_components,
+                                  const float max_dist,
+                                  std::vector<QueryCandidate> &candidates)
+    {
+        candidates.clear();
+        for (uint32_t i = 0; i < leaf.object_count; ++i)
+        {
+            if (ignore_tiny_components && leaf.IsInTinyComponent(i))
+            {
+                continue;
+            }
+            const float lower_bound =
+                GetSegmentBounds(leaf, i).GetMinDistLowerBound(input_coordinate);
+            if (lower_bound < max_dist)
+            {
+                candidates.emplace_back(lower_bound, i);
+            }
+        }
+        std::sort(candidates.begin(),
+                  candidates.end(),
+                  [](const QueryCandidate &lhs, const QueryCandidate &rhs)
+                  {
+            return lhs.min_dist < rhs.min_dist;
+        });
     }
 
     inline bool EdgesAreEquivalent(const FixedPointCoordinate &a,
@@ -0,0 +1,128 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef BINARY_DESCRIPTOR_H
+#define BINARY_DESCRIPTOR_H
+
+#include "BaseDescriptor.h"
+#include "../DataStructures/BinaryContainer.h"
+#include "../DataStructures/Range.h"
+
+#include <osrm/Coordinate.h>
+
+#include <cmath>
+
+// Route summary in the binary layout of BinaryContainer.h. It skips the description
+// factory as neither geometry nor instructions are rendered.
+template <class DataFacadeT> class BinaryDescriptor final : public BaseDescriptor<DataFacadeT>
+{
+  private:
+    DataFacadeT *facade;
+    DescriptorConfig config;
+
+  public:
+    explicit BinaryDescriptor(DataFacadeT *facade) : facade(facade) {}
+
+    void SetConfig(const DescriptorConfig &c) final { config = c; }
+
+    void Run(const RawRouteData &raw_route, http::Reply &reply) final
+    {
+        Binary::Writer writer(reply.content, Binary::RoutePayload);
+        if (INVALID_EDGE_WEIGHT == raw_route.shortest_path_length)
+        {
+            writer.AppendInt32(207);
+            writer.Finish();
+            return;
+        }
+        BOOST_ASSERT(!raw_route.segment_end_coordinates.empty());
+
+        const std::size_t number_of_via_points = raw_route.segment_end_coordinates.size() + 1;
+        writer.Reserve(6 * sizeof(std::uint32_t) + 2 * sizeof(std::int32_t) * number_of_via_points);
+        writer.AppendInt32(0);
+
+        double route_length = 0.;
+        for (const auto i : osrm::irange<std::size_t>(0, raw_route.unpacked_path_segments.size()))
+        {
+            route_length += ComputeLegLength(raw_route.unpacked_path_segments[i],
+                                             raw_route.segment_end_coordinates[i]);
+        }
+        AppendSummary(writer, route_length, raw_route.shortest_path_length);
+
+        writer.AppendUInt32(static_cast<std::uint32_t>(number_of_via_points));
+        writer.AppendInt32(raw_route.segment_end_coordinates.front().source_phantom.location.lat);
+        writer.AppendInt32(raw_route.segment_end_coordinates.front().source_phantom.location.lon);
+        for (const PhantomNodes &nodes : raw_route.segment_end_coordinates)
+        {
+            writer.AppendInt32(nodes.target_phantom.location.lat);
+            writer.AppendInt32(nodes.target_phantom.location.lon);
+        }
+
+        // alternatives are single-leg routes between the first and the last via point
+        PhantomNodes alternative_end_points;
+        alternative_end_points.source_phantom =
+            raw_route.segment_end_coordinates.front().source_phantom;
+        alternative_end_points.target_phantom =
+            raw_route.segment_end_coordinates.back().target_phantom;
+        writer.AppendUInt32(static_cast<std::uint32_t>(raw_route.unpacked_alternatives.size()));
+        for (const auto i : osrm::irange<std::size_t>(0, raw_route.unpacked_alternatives.size()))
+        {
+            AppendSummary(writer,
+                          ComputeLegLength(raw_route.unpacked_alternatives[i],
+                                           alternative_end_points),
+                          raw_route.alternative_path_lengths[i]);
+        }
+        writer.Finish();
+    }
+
+  private:
+    // same approximation as the description factory uses for total_distance
+    double ComputeLegLength(const std::vector<PathData> &route_leg,
+                            const PhantomNodes &leg_phantoms) const
+    {
+        double length = 0.;
+        FixedPointCoordinate previous_coordinate = leg_phantoms.source_phantom.location;
+        for (const PathData &path_data : route_leg)
+        {
+            const FixedPointCoordinate current_coordinate =
+                facade->GetCoordinateOfNode(path_data.node);
+            length += FixedPointCoordinate::ApproximateEuclideanDistance(previous_coordinate,
+                                                                         current_coordinate);
+            previous_coordinate = current_coordinate;
+        }
+        length += FixedPointCoordinate::ApproximateEuclideanDistance(
+            previous_coordinate, leg_phantoms.target_phantom.location);
+        return length;
+    }
+
+    static void AppendSummary(Binary::Writer &writer, const double length, const int duration)
+    {
+        writer.AppendUInt32(static_cast<std::uint32_t>(std::round(length)));
+        writer.AppendUInt32(static_cast<std::uint32_t>(std::round(duration / 10.)));
+    }
+};
+
+#endif // BINARY_DESCRIPTOR_H
@@ -107,6 +107,7 @@ void DescriptionFactory::AppendSegment(const FixedPointCoordinate &coordinate,
                                   0.f,
                                   turn,
                                   path_point.travel_mode);
+    path_description.back().simplification_rank = path_point.simplification_rank;
 }
 
 JSON::Value DescriptionFactory::AppendGeometryString(const bool return_encoded)
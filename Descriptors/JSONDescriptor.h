@@ -47,7 +47,7 @@ template <class DataFacadeT> class JSONDescriptor final : public BaseDescriptor<
   private:
     DataFacadeT *facade;
     DescriptorConfig config;
-    DescriptionFactory description_factory, alternate_description_factory;
+    DescriptionFactory description_factory;
     FixedPointCoordinate current;
     unsigned entered_restricted_area_count;
     struct RoundAbout
@@ -66,7 +66,7 @@ template <class DataFacadeT> class JSONDescriptor final : public BaseDescriptor<
         int length;
         unsigned position;
     };
-    std::vector<Segment> shortest_path_segments, alternative_path_segments;
+    std::vector<Segment> shortest_path_segments;
     ExtractRouteNames<DataFacadeT, Segment> GenerateRouteNames;
 
   public:
@@ -191,68 +191,90 @@ template <class DataFacadeT> class JSONDescriptor final : public BaseDescriptor<
                                              shortest_leg_end_indices.end());
         json_result.values["via_indices"] = json_via_indices_array;
 
-        // only one alternative route is computed at this time, so this is hardcoded
-        if (INVALID_EDGE_WEIGHT != raw_route.alternative_path_length)
+        // alternatives are single-leg routes between the first and the last via point
+        std::vector<std::vector<Segment>> alternative_path_segments(
+            raw_route.unpacked_alternatives.size());
+        if (!raw_route.unpacked_alternatives.empty())
         {
             json_result.values["found_alternative"] = JSON::True();
-            BOOST_ASSERT(!raw_route.alt_source_traversed_in_reverse.empty());
-            alternate_description_factory.SetStartSegment(
-                raw_route.segment_end_coordinates.front().source_phantom,
-                raw_route.alt_source_traversed_in_reverse.front());
-            // Get all the coordinates for the computed route
-            for (const PathData &path_data : raw_route.unpacked_alternative)
+            BOOST_ASSERT(raw_route.alt_source_traversed_in_reverse.size() ==
+                         raw_route.unpacked_alternatives.size());
+            BOOST_ASSERT(raw_route.alt_target_traversed_in_reverse.size() ==
+                         raw_route.unpacked_alternatives.size());
+            JSON::Array json_alternate_geometries_array;
+            JSON::Array json_alt_instructions;
+            JSON::Array json_alternate_route_summary_array;
+            for (const auto i : osrm::irange<std::size_t>(0, raw_route.unpacked_alternatives.size()))
             {
-                current = facade->GetCoordinateOfNode(path_data.node);
-                alternate_description_factory.AppendSegment(current, path_data);
-            }
-            alternate_description_factory.SetEndSegment(
-                raw_route.segment_end_coordinates.back().target_phantom,
-                raw_route.alt_source_traversed_in_reverse.back());
-            alternate_description_factory.Run(facade, config.zoom_level);
+                DescriptionFactory alternate_description_factory;
+                alternate_description_factory.SetStartSegment(
+                    raw_route.segment_end_coordinates.front().source_phantom,
+                    raw_route.alt_source_traversed_in_reverse[i]);
+                // Get all the coordinates for the computed route
+                for (const PathData &path_data : raw_route.unpacked_alternatives[i])
+                {
+                    current = facade->GetCoordinateOfNode(path_data.node);
+                    alternate_description_factory.AppendSegment(current, path_data);
+                }
+                alternate_description_factory.SetEndSegment(
+                    raw_route.segment_end_coordinates.back().target_phantom,
+                    raw_route.alt_target_traversed_in_reverse[i]);
+                alternate_description_factory.Run(facade, config.zoom_level);
 
+                if (config.geometry)
+                {
+                    JSON::Value alternate_geometry_string =
+                        alternate_description_factory.AppendGeometryString(config.encode_geometry);
+                    json_alternate_geometries_array.values.push_back(alternate_geometry_string);
+                }
+                if (config.instructions)
+                {
+                    JSON::Array json_current_alt_instructions;
+                    BuildTextualDescription(alternate_description_factory,
+                                            json_current_alt_instructions,
+                                            raw_route.alternative_path_lengths[i],
+                                            alternative_path_segments[i]);
+                    json_alt_instructions.values.push_back(json_current_alt_instructions);
+                }
+                alternate_description_factory.BuildRouteSummary(
+                    alternate_description_factory.entireLength,
+                    raw_route.alternative_path_lengths[i]);
+
+                JSON::Object json_alternate_route_summary;
+                json_alternate_route_summary.values["total_distance"] =
+                    alternate_description_factory.summary.distance;
+                json_alternate_route_summary.values["total_time"] =
+                    alternate_description_factory.summary.duration;
+                json_alternate_route_summary.values["start_point"] =
+                    facade->GetEscapedNameForNameID(
+                        alternate_description_factory.summary.source_name_id);
+                json_alternate_route_summary.values["end_point"] = facade->GetEscapedNameForNameID(
+                    alternate_description_factory.summary.target_name_id);
+                json_alternate_route_summary_array.values.push_back(json_alternate_route_summary);
+
+                // all alternatives start and end at the same via points, so the indices of
+                // the first one are rendered as before
+                if (0 == i)
+                {
+                    std::vector<unsigned> const &alternate_leg_end_indices =
+                        alternate_description_factory.GetViaIndices();
+                    JSON::Array json_altenative_indices_array;
+                    json_altenative_indices_array.values.insert(
+                        json_altenative_indices_array.values.end(),
+                        alternate_leg_end_indices.begin(),
+                        alternate_leg_end_indices.end());
+                    json_result.values["alternative_indices"] = json_altenative_indices_array;
+                }
+            }
             if (config.geometry)
             {
-                JSON::Value alternate_geometry_string =
-                    alternate_description_factory.AppendGeometryString(config.encode_geometry);
-                JSON::Array json_alternate_geometries_array;
-                json_alternate_geometries_array.values.push_back(alternate_geometry_string);
                 json_result.values["alternative_geometries"] = json_alternate_geometries_array;
             }
-            // Generate instructions for each alternative (simulated here)
-            JSON::Array json_alt_instructions;
-            JSON::Array json_current_alt_instructions;
             if (config.instructions)
             {
-                BuildTextualDescription(alternate_description_factory,
-                                        json_current_alt_instructions,
-                                        raw_route.alternative_path_length,
-                                        alternative_path_segments);
-                json_alt_instructions.values.push_back(json_current_alt_instructions);
                 json_result.values["alternative_instructions"] = json_alt_instructions;
             }
-            alternate_description_factory.BuildRouteSummary(
-                alternate_description_factory.entireLength, raw_route.alternative_path_length);
-
-            JSON::Object json_alternate_route_summary;
-            JSON::Array json_alternate_route_summary_array;
-            json_alternate_route_summary.values["total_distance"] =
-                alternate_description_factory.summary.distance;
-            json_alternate_route_summary.values["total_time"] =
-                alternate_description_factory.summary.duration;
-            json_alternate_route_summary.values["start_point"] = facade->GetEscapedNameForNameID(
-                alternate_description_factory.summary.source_name_id);
-            json_alternate_route_summary.values["end_point"] = facade->GetEscapedNameForNameID(
-                alternate_description_factory.summary.target_name_id);
-            json_alternate_route_summary_array.values.push_back(json_alternate_route_summary);
             json_result.values["alternative_summaries"] = json_alternate_route_summary_array;
-
-            std::vector<unsigned> const &alternate_leg_end_indices =
-                alternate_description_factory.GetViaIndices();
-            JSON::Array json_altenative_indices_array;
-            json_altenative_indices_array.values.insert(json_altenative_indices_array.values.end(),
-                                                        alternate_leg_end_indices.begin(),
-                                                        alternate_leg_end_indices.end());
-            json_result.values["alternative_indices"] = json_altenative_indices_array;
         }
         else
         {
@@ -260,20 +282,32 @@ template <class DataFacadeT> class JSONDescriptor final : public BaseDescriptor<
         }
 
         // Get Names for both routes
-        RouteNames route_names =
-            GenerateRouteNames(shortest_path_segments, alternative_path_segments, facade);
+        std::vector<Segment> no_alternative_segments;
+        RouteNames route_names = GenerateRouteNames(shortest_path_segments,
+                                                    alternative_path_segments.empty()
+                                                        ? no_alternative_segments
+                                                        : alternative_path_segments.front(),
+                                                    facade);
         JSON::Array json_route_names;
         json_route_names.values.push_back(route_names.shortest_path_name_1);
         json_route_names.values.push_back(route_names.shortest_path_name_2);
         json_result.values["route_name"] = json_route_names;
 
-        if (INVALID_EDGE_WEIGHT != raw_route.alternative_path_length)
+        if (!raw_route.unpacked_alternatives.empty())
         {
             JSON::Array json_alternate_names_array;
-            JSON::Array json_alternate_names;
-            json_alternate_names.values.push_back(route_names.alternative_path_name_1);
-            json_alternate_names.values.push_back(route_names.alternative_path_name_2);
-            json_alternate_names_array.values.push_back(json_alternate_names);
+            for (const auto i : osrm::irange<std::size_t>(0, alternative_path_segments.size()))
+            {
+                if (0 != i)
+                {
+                    route_names = GenerateRouteNames(
+                        shortest_path_segments, alternative_path_segments[i], facade);
+                }
+                JSON::Array json_alternate_names;
+                json_alternate_names.values.push_back(route_names.alternative_path_name_1);
+                json_alternate_names.values.push_back(route_names.alternative_path_name_2);
+                json_alternate_names_array.values.push_back(json_alternate_names);
+            }
             json_result.values["alternative_names"] = json_alternate_names_array;
         }
 
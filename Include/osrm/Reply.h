@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/asio.hpp>
 
+#include <array>
 #include <vector>
 
 namespace http
@@ -41,11 +42,12 @@ const char okHTML[] = "";
 const char badRequestHTML[] = "{\"status\": 400,\"status_message\":\"Bad Request\"}";
 const char internalServerErrorHTML[] =
     "{\"status\": 500,\"status_message\":\"Internal Server Error\"}";
-const char seperators[] = {':', ' '};
-const char crlf[] = {'\r', '\n'};
+const char serviceUnavailableHTML[] =
+    "{\"status\": 503,\"status_message\":\"Service Unavailable\"}";
 const std::string okString = "HTTP/1.0 200 OK\r\n";
 const std::string badRequestString = "HTTP/1.0 400 Bad Request\r\n";
 const std::string internalServerErrorString = "HTTP/1.0 500 Internal Server Error\r\n";
+const std::string serviceUnavailableString = "HTTP/1.0 503 Service Unavailable\r\n";
 
 class Reply
 {
@@ -53,21 +55,36 @@ class Reply
     enum status_type
     { ok = 200,
       badRequest = 400,
-      internalServerError = 500 } status;
-
+      internalServerError = 500,
+      serviceUnavailable = 503 } status;
+
+    // selects one of the preformatted blocks of Content-Type and related headers
+    enum format_type
+    { htmlFormat,
+      jsonFormat,
+      jsonpFormat,
+      gpxFormat,
+      binaryFormat } format;
+
+    // additional headers, e.g. Retry-After, written after the preformatted ones
     std::vector<Header> headers;
-    std::vector<boost::asio::const_buffer> ToBuffers();
-    std::vector<boost::asio::const_buffer> HeaderstoBuffers();
     std::vector<char> content;
+
+    // frames the uncompressed content: status line and headers, followed by the content
+    std::array<boost::asio::const_buffer, 2> ToBuffers();
+    // formats status line and headers for a body of content_length bytes, the optional
+    // content_encoding is sent as Content-Encoding
+    boost::asio::const_buffer HeaderstoBuffer(const std::size_t content_length,
+                                              const char *content_encoding = nullptr);
     static Reply StockReply(status_type status);
-    void SetSize(const unsigned size);
-    void SetUncompressedSize();
 
     Reply();
 
   private:
     std::string ToString(Reply::status_type status);
-    boost::asio::const_buffer ToBuffer(Reply::status_type status);
+
+    // status line and headers are formatted into this fixed buffer without allocations
+    std::array<char, 1024> header_data;
 };
 }
 
@@ -32,6 +32,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/fusion/container/vector/vector_fwd.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -45,6 +47,8 @@ struct RouteParameters
 
     void setAlternateRouteFlag(const bool flag);
 
+    void setNumberOfAlternatives(const short number);
+
     void setUTurn(const bool flag);
 
     void setAllUTurns(const bool flag);
@@ -55,6 +59,8 @@ struct RouteParameters
 
     void setInstructionFlag(const bool flag);
 
+    void setDataset(const std::string &dataset);
+
     void setService(const std::string &service);
 
     void setOutputFormat(const std::string &format);
@@ -69,17 +75,28 @@ struct RouteParameters
 
     void setCompressionFlag(const bool flag);
 
+    void setLengthsFlag(const bool flag);
+
     void addCoordinate(const boost::fusion::vector<double, double> &coordinates);
 
+    void addSource(const boost::fusion::vector<double, double> &coordinates);
+
+    void addDestination(const boost::fusion::vector<double, double> &coordinates);
+
     short zoom_level;
     bool print_instructions;
     bool alternate_route;
+    short num_alternatives;
     bool geometry;
     bool compression;
+    // table service: also return the lengths of the fastest paths
+    bool lengths;
     bool deprecatedAPI;
     bool uturn_default;
     unsigned check_sum;
     short num_results;
+    // name of the dataset given as path prefix, empty for the default dataset
+    std::string dataset;
     std::string service;
     std::string output_format;
     std::string jsonp_parameter;
@@ -87,6 +104,13 @@ struct RouteParameters
     std::vector<std::string> hints;
     std::vector<bool> uturns;
     std::vector<FixedPointCoordinate> coordinates;
+    // table service: whether a coordinate is a row resp. a column of the table
+    std::vector<bool> is_source;
+    std::vector<bool> is_destination;
+    // the query time limit counts from query_start if set, e.g. when the server dequeued the
+    // request, and searches give up once *cancelled is raised, e.g. when the client went away
+    std::chrono::steady_clock::time_point query_start;
+    const std::atomic<bool> *cancelled;
 };
 
 #endif // ROUTE_PARAMETERS_H
@@ -35,4 +35,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 typedef std::unordered_map<std::string, boost::filesystem::path> ServerPaths;
 
+// additional datasets served next to the default one, keyed by the name of the dataset
+typedef std::unordered_map<std::string, ServerPaths> NamedServerPaths;
+
 #endif // SERVER_PATH_H
@@ -28,27 +28,78 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef OSRM_H
 #define OSRM_H
 
+#include <osrm/Reply.h>
 #include <osrm/ServerPaths.h>
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
+class AdmissionTicket;
 class OSRM_impl;
+struct PhantomNode;
+struct RawRouteData;
 struct RouteParameters;
 
-namespace http
-{
-class Reply;
-}
-
 class OSRM
 {
   private:
     std::unique_ptr<OSRM_impl> OSRM_pimpl_;
 
   public:
-    explicit OSRM(ServerPaths paths, const bool use_shared_memory = false);
+    // a max_query_cost of zero disables admission control, a max_query_time of zero
+    // milliseconds lets searches run to completion. Queries select one of the
+    // named_paths by RouteParameters::dataset and use the dataset of paths otherwise.
+    // With parallel_search, independent parts of a route are searched on the threads of
+    // the TBB pool, which are not bounded by the threads that call RunQuery.
+    explicit OSRM(ServerPaths paths,
+                  const bool use_shared_memory = false,
+                  const unsigned max_query_cost = 0,
+                  const unsigned max_query_time = 0,
+                  NamedServerPaths named_paths = NamedServerPaths(),
+                  const bool parallel_search = false);
     ~OSRM();
     void RunQuery(RouteParameters &route_parameters, http::Reply &reply);
+    // Reserves the estimated cost of a query in the admission budget until the ticket is
+    // destroyed, or returns nullptr if it does not fit. A server takes the ticket before it
+    // queues the query, so that the budget counts waiting queries as well as running ones,
+    // and runs the query with it, which does not charge the query again.
+    std::shared_ptr<const AdmissionTicket> Admit(const RouteParameters &route_parameters);
+    void RunQuery(RouteParameters &route_parameters,
+                  http::Reply &reply,
+                  const AdmissionTicket &ticket);
+    // faults in the dataset so that the first queries do not hit cold pages
+    void Prefault(const bool lock_to_ram = false);
+    // loads the datasets again from their files and swaps them in, queries that are running
+    // finish on the old data. Returns false if a dataset could not be loaded and was kept.
+    bool Reload();
+    // adds a counter of the embedding application, e.g. the queue depth of a server, to the
+    // output of the status service. Counters have to be added before queries are run.
+    void AddStatusCounter(const std::string &name, std::function<uint64_t()> counter);
+
+    // Typed queries for in-process clients. Results are returned as plain structs
+    // without rendering a reply. The status is ok, badRequest for invalid parameters,
+    // or serviceUnavailable if the query was not admitted or ran out of time.
+    http::Reply::status_type Route(const RouteParameters &route_parameters,
+                                   RawRouteData &raw_route);
+    // row-major matrix of travel times in tenths of a second with a row per source and a
+    // column per destination, see RouteParameters::is_source and is_destination. Unlike
+    // the table service, neither the number of entries nor the number of locations is
+    // limited, and a table of plain coordinates is square over all of them.
+    http::Reply::status_type Table(const RouteParameters &route_parameters,
+                                   std::vector<int> &distance_table);
+    // as above, plus the lengths of the same paths in meters
+    http::Reply::status_type Table(const RouteParameters &route_parameters,
+                                   std::vector<int> &distance_table,
+                                   std::vector<int> &length_table);
+    http::Reply::status_type Nearest(const RouteParameters &route_parameters,
+                                     std::vector<PhantomNode> &phantom_nodes);
+    // checksum of the graph the queries on route_parameters.dataset run on, changes when the
+    // dataset is prepared again
+    http::Reply::status_type CheckSum(const RouteParameters &route_parameters,
+                                      unsigned &check_sum);
 };
 
 #endif // OSRM_H
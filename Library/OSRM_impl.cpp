@@ -39,6 +39,7 @@ namespace boost { namespace interprocess { class named_mutex; } }
 #include "../Plugins/HelloWorldPlugin.h"
 #include "../Plugins/LocatePlugin.h"
 #include "../Plugins/NearestPlugin.h"
+#include "../Plugins/StatusPlugin.h"
 #include "../Plugins/TimestampPlugin.h"
 #include "../Plugins/ViaRoutePlugin.h"
 #include "../Server/DataStructures/BaseDataFacade.h"
@@ -48,6 +49,7 @@ namespace boost { namespace interprocess { class named_mutex; } }
 #include "../Util/make_unique.hpp"
 #include "../Util/ProgramOptions.h"
 #include "../Util/simple_logger.hpp"
+#include "../Util/TimingUtil.h"
 
 #include <boost/assert.hpp>
 #include <boost/interprocess/sync/named_condition.hpp>
@@ -55,58 +57,20 @@ namespace boost { namespace interprocess { class named_mutex; } }
 
 #include <algorithm>
 #include <fstream>
+#include <functional>
+#include <limits>
 #include <utility>
 #include <vector>
 
-OSRM_impl::OSRM_impl(ServerPaths server_paths, const bool use_shared_memory)
+namespace
 {
-    if (use_shared_memory)
-    {
-        barrier = osrm::make_unique<SharedBarriers>();
-        query_data_facade = new SharedDataFacade<QueryEdge::EdgeData>();
-    }
-    else
-    {
-        // populate base path
-        populate_base_path(server_paths);
-        query_data_facade = new InternalDataFacade<QueryEdge::EdgeData>(server_paths);
-    }
-
-    // The following plugins handle all requests.
-    RegisterPlugin(new DistanceTablePlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
-    RegisterPlugin(new HelloWorldPlugin());
-    RegisterPlugin(new LocatePlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
-    RegisterPlugin(new NearestPlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
-    RegisterPlugin(new TimestampPlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
-    RegisterPlugin(new ViaRoutePlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
-}
-
-OSRM_impl::~OSRM_impl()
-{
-    delete query_data_facade;
-    for (PluginMap::value_type &plugin_pointer : plugin_map)
-    {
-        delete plugin_pointer.second;
-    }
-}
-
-void OSRM_impl::RegisterPlugin(BasePlugin *plugin)
+// registers a running query with the barriers that guard updates of shared memory data
+class SharedQueryGuard
 {
-    SimpleLogger().Write() << "loaded plugin: " << plugin->GetDescriptor();
-    if (plugin_map.find(plugin->GetDescriptor()) != plugin_map.end())
+  public:
+    SharedQueryGuard(SharedBarriers *barrier, BaseDataFacade<QueryEdge::EdgeData> *facade)
+        : barrier(barrier)
     {
-        delete plugin_map.find(plugin->GetDescriptor())->second;
-    }
-    plugin_map.emplace(plugin->GetDescriptor(), plugin);
-}
-
-void OSRM_impl::RunQuery(RouteParameters &route_parameters, http::Reply &reply)
-{
-    const PluginMap::const_iterator &iter = plugin_map.find(route_parameters.service);
-
-    if (plugin_map.end() != iter)
-    {
-        reply.status = http::Reply::ok;
         if (barrier)
         {
             // lock update pending
@@ -123,11 +87,14 @@ void OSRM_impl::RunQuery(RouteParameters &route_parameters, http::Reply &reply)
             // increment query count
             ++(barrier->number_of_queries);
 
-            (static_cast<SharedDataFacade<QueryEdge::EdgeData> *>(query_data_facade))
+            (static_cast<SharedDataFacade<QueryEdge::EdgeData> *>(facade))
                 ->CheckAndReloadFacade();
         }
+    }
+    SharedQueryGuard(const SharedQueryGuard &) = delete;
 
-        iter->second->HandleRequest(route_parameters, reply);
+    ~SharedQueryGuard()
+    {
         if (barrier)
         {
             // lock query
@@ -145,16 +112,372 @@ void OSRM_impl::RunQuery(RouteParameters &route_parameters, http::Reply &reply)
             }
         }
     }
+
+  private:
+    SharedBarriers *barrier;
+};
+}
+
+struct OSRM_impl::Dataset
+{
+    explicit Dataset(const std::string &name)
+        : name(name), facade(nullptr), nearest_plugin(nullptr), via_route_plugin(nullptr)
+    {
+    }
+    Dataset(const Dataset &) = delete;
+
+    ~Dataset()
+    {
+        for (PluginMap::value_type &plugin_pointer : plugin_map)
+        {
+            delete plugin_pointer.second;
+        }
+        delete facade;
+    }
+
+    const std::string name;
+    // files the facade was loaded from, empty for data in shared memory
+    ServerPaths paths;
+    BaseDataFacade<QueryEdge::EdgeData> *facade;
+    PluginMap plugin_map;
+    // typed access for the in-process API, the plugins are owned by plugin_map
+    BasePlugin *nearest_plugin;
+    BasePlugin *via_route_plugin;
+    std::function<http::Reply::status_type(const RouteParameters &,
+                                           std::shared_ptr<std::vector<int>> &,
+                                           std::vector<int> *)> compute_table;
+    std::function<unsigned(const RouteParameters &)> estimate_table_cost;
+    std::function<bool(const RouteParameters &, std::vector<PhantomNode> &)> compute_nearest;
+    std::function<http::Reply::status_type(const RouteParameters &, RawRouteData &)>
+        compute_route;
+};
+
+OSRM_impl::OSRM_impl(ServerPaths server_paths,
+                     const bool use_shared_memory,
+                     const unsigned max_query_cost,
+                     const unsigned max_query_time,
+                     NamedServerPaths named_paths,
+                     const bool parallel_search)
+    : admission_control(max_query_cost), time_limit(max_query_time),
+      parallel_search(parallel_search), prefault_on_reload(false), lock_to_ram_on_reload(false),
+      query_data_facade(nullptr)
+{
+    if (use_shared_memory)
+    {
+        barrier = osrm::make_unique<SharedBarriers>();
+        auto shared_data_facade = new SharedDataFacade<QueryEdge::EdgeData>();
+        query_data_facade = shared_data_facade;
+        datasets[std::string()] = RegisterPlugins(std::string(), shared_data_facade);
+    }
+    else
+    {
+        // populate base path
+        populate_base_path(server_paths);
+        auto internal_data_facade = new InternalDataFacade<QueryEdge::EdgeData>(server_paths);
+        datasets[std::string()] = RegisterPlugins(std::string(), internal_data_facade);
+        datasets[std::string()]->paths = server_paths;
+    }
+
+    // shared memory holds a single dataset, additional ones are always loaded into the process
+    for (NamedServerPaths::value_type &named_path : named_paths)
+    {
+        BOOST_ASSERT_MSG(!named_path.first.empty(), "the default dataset has no name");
+        SimpleLogger().Write() << "loading dataset: " << named_path.first;
+        populate_base_path(named_path.second);
+        datasets[named_path.first] = RegisterPlugins(
+            named_path.first, new InternalDataFacade<QueryEdge::EdgeData>(named_path.second));
+        datasets[named_path.first]->paths = named_path.second;
+    }
+}
+
+template <class DataFacadeT>
+std::shared_ptr<OSRM_impl::Dataset> OSRM_impl::RegisterPlugins(const std::string &name,
+                                                               DataFacadeT *facade)
+{
+    auto dataset_ptr = std::make_shared<Dataset>(name);
+    Dataset &dataset = *dataset_ptr;
+    dataset.facade = facade;
+
+    auto table = new DistanceTablePlugin<DataFacadeT>(facade, query_contexts, time_limit);
+    auto nearest = new NearestPlugin<DataFacadeT>(facade);
+    auto via_route =
+        new ViaRoutePlugin<DataFacadeT>(facade, query_contexts, time_limit, parallel_search);
+
+    dataset.nearest_plugin = nearest;
+    dataset.via_route_plugin = via_route;
+    // in-process clients bound the size of their tables themselves
+    dataset.compute_table = [table](const RouteParameters &route_parameters,
+                                    std::shared_ptr<std::vector<int>> &result_table,
+                                    std::vector<int> *length_table)
+    {
+        return table->ComputeTable(route_parameters,
+                                   result_table,
+                                   length_table,
+                                   std::numeric_limits<std::size_t>::max(),
+                                   std::numeric_limits<std::size_t>::max());
+    };
+    dataset.estimate_table_cost = [](const RouteParameters &route_parameters)
+    {
+        return DistanceTablePlugin<DataFacadeT>::EstimateTableCost(
+            route_parameters, std::numeric_limits<std::size_t>::max() / 2);
+    };
+    dataset.compute_nearest =
+        [nearest](const RouteParameters &route_parameters, std::vector<PhantomNode> &phantom_nodes)
+    { return nearest->ComputeNearest(route_parameters, phantom_nodes); };
+    dataset.compute_route =
+        [via_route](const RouteParameters &route_parameters, RawRouteData &raw_route)
+    { return via_route->ComputeRoute(route_parameters, raw_route); };
+
+    // The following plugins handle all requests.
+    RegisterPlugin(dataset, table);
+    RegisterPlugin(dataset, new HelloWorldPlugin());
+    RegisterPlugin(dataset, new LocatePlugin<DataFacadeT>(facade));
+    RegisterPlugin(dataset, nearest);
+    RegisterPlugin(dataset, new StatusPlugin(admission_control, time_limit, status_counters));
+    RegisterPlugin(dataset, new TimestampPlugin<DataFacadeT>(facade));
+    RegisterPlugin(dataset, via_route);
+    return dataset_ptr;
+}
+
+OSRM_impl::~OSRM_impl() {}
+
+void OSRM_impl::RegisterPlugin(Dataset &dataset, BasePlugin *plugin)
+{
+    SimpleLogger().Write() << "loaded plugin: "
+                           << (dataset.name.empty() ? "" : dataset.name + "/")
+                           << plugin->GetDescriptor();
+    PluginMap &plugin_map = dataset.plugin_map;
+    if (plugin_map.find(plugin->GetDescriptor()) != plugin_map.end())
+    {
+        delete plugin_map.find(plugin->GetDescriptor())->second;
+    }
+    plugin_map.emplace(plugin->GetDescriptor(), plugin);
+}
+
+std::shared_ptr<const OSRM_impl::Dataset>
+OSRM_impl::GetDataset(const RouteParameters &route_parameters) const
+{
+    const DatasetMap::const_iterator iter = datasets.find(route_parameters.dataset);
+    if (datasets.end() == iter)
+    {
+        return nullptr;
+    }
+    return std::atomic_load(&iter->second);
+}
+
+unsigned OSRM_impl::EstimateCost(const RouteParameters &route_parameters) const
+{
+    const std::shared_ptr<const Dataset> dataset = GetDataset(route_parameters);
+    if (nullptr == dataset)
+    {
+        return 0;
+    }
+    const PluginMap::const_iterator iter = dataset->plugin_map.find(route_parameters.service);
+    // unknown services are rejected without any work
+    return (dataset->plugin_map.end() == iter) ? 0 : iter->second->EstimateCost(route_parameters);
+}
+
+std::shared_ptr<const AdmissionTicket> OSRM_impl::Admit(const RouteParameters &route_parameters)
+{
+    auto ticket =
+        std::make_shared<const AdmissionTicket>(admission_control, EstimateCost(route_parameters));
+    return ticket->IsAdmitted() ? ticket : nullptr;
+}
+
+void OSRM_impl::RunQuery(RouteParameters &route_parameters, http::Reply &reply)
+{
+    // shed load early instead of slowing down every query that is already running
+    const std::shared_ptr<const AdmissionTicket> ticket = Admit(route_parameters);
+    if (nullptr == ticket)
+    {
+        reply = http::Reply::StockReply(http::Reply::serviceUnavailable);
+        reply.headers.emplace_back("Retry-After", "1");
+        return;
+    }
+    RunQuery(route_parameters, reply, *ticket);
+}
+
+void OSRM_impl::RunQuery(RouteParameters &route_parameters,
+                         http::Reply &reply,
+                         const AdmissionTicket &)
+{
+    const std::shared_ptr<const Dataset> dataset = GetDataset(route_parameters);
+    if (nullptr == dataset)
+    {
+        reply = http::Reply::StockReply(http::Reply::badRequest);
+        return;
+    }
+
+    const PluginMap::const_iterator &iter = dataset->plugin_map.find(route_parameters.service);
+
+    if (dataset->plugin_map.end() != iter)
+    {
+        reply.status = http::Reply::ok;
+        const SharedQueryGuard query_guard(barrier.get(), query_data_facade);
+        iter->second->HandleRequest(route_parameters, reply);
+    }
     else
     {
         reply = http::Reply::StockReply(http::Reply::badRequest);
     }
 }
 
+void OSRM_impl::Prefault(const bool lock_to_ram)
+{
+    TIMER_START(prefault);
+    {
+        std::lock_guard<std::mutex> reload_lock(reload_mutex);
+        prefault_on_reload = true;
+        lock_to_ram_on_reload = lock_to_ram;
+    }
+    const SharedQueryGuard query_guard(barrier.get(), query_data_facade);
+    for (const DatasetMap::value_type &dataset : datasets)
+    {
+        std::atomic_load(&dataset.second)->facade->Prefault(lock_to_ram);
+    }
+    TIMER_STOP(prefault);
+    SimpleLogger().Write() << "prefaulted " << datasets.size() << " dataset(s) in "
+                           << TIMER_SEC(prefault) << " seconds";
+}
+
+bool OSRM_impl::Reload()
+{
+    std::lock_guard<std::mutex> reload_lock(reload_mutex);
+    bool reloaded_all = true;
+    for (DatasetMap::value_type &dataset : datasets)
+    {
+        // shared memory is updated by osrm-datastore and picked up by the facade itself
+        const ServerPaths paths = std::atomic_load(&dataset.second)->paths;
+        if (paths.empty())
+        {
+            continue;
+        }
+
+        TIMER_START(reload);
+        std::shared_ptr<Dataset> reloaded_dataset;
+        try
+        {
+            reloaded_dataset = RegisterPlugins(
+                dataset.first, new InternalDataFacade<QueryEdge::EdgeData>(paths));
+            reloaded_dataset->paths = paths;
+            if (prefault_on_reload)
+            {
+                reloaded_dataset->facade->Prefault(lock_to_ram_on_reload);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            SimpleLogger().Write(logWARNING) << "keeping the loaded data, reload failed: "
+                                             << e.what();
+            reloaded_all = false;
+            continue;
+        }
+
+        // queries in flight hold a reference to the replaced dataset, the last one frees it
+        std::atomic_store(&dataset.second, reloaded_dataset);
+        TIMER_STOP(reload);
+        SimpleLogger().Write() << "reloaded dataset "
+                               << (dataset.first.empty() ? "(default)" : dataset.first) << " in "
+                               << TIMER_SEC(reload) << " seconds";
+    }
+    return reloaded_all;
+}
+
+void OSRM_impl::AddStatusCounter(const std::string &name, std::function<uint64_t()> counter)
+{
+    status_counters.emplace_back(name, std::move(counter));
+}
+
+http::Reply::status_type OSRM_impl::Route(const RouteParameters &route_parameters,
+                                          RawRouteData &raw_route)
+{
+    const std::shared_ptr<const Dataset> dataset = GetDataset(route_parameters);
+    if (nullptr == dataset)
+    {
+        return http::Reply::badRequest;
+    }
+    const AdmissionTicket ticket(admission_control,
+                                 dataset->via_route_plugin->EstimateCost(route_parameters));
+    if (!ticket.IsAdmitted())
+    {
+        return http::Reply::serviceUnavailable;
+    }
+    const SharedQueryGuard query_guard(barrier.get(), query_data_facade);
+    return dataset->compute_route(route_parameters, raw_route);
+}
+
+http::Reply::status_type OSRM_impl::Table(const RouteParameters &route_parameters,
+                                          std::vector<int> &distance_table,
+                                          std::vector<int> *length_table)
+{
+    const std::shared_ptr<const Dataset> dataset = GetDataset(route_parameters);
+    if (nullptr == dataset)
+    {
+        return http::Reply::badRequest;
+    }
+    const AdmissionTicket ticket(admission_control, dataset->estimate_table_cost(route_parameters));
+    if (!ticket.IsAdmitted())
+    {
+        return http::Reply::serviceUnavailable;
+    }
+    const SharedQueryGuard query_guard(barrier.get(), query_data_facade);
+    std::shared_ptr<std::vector<EdgeWeight>> result_table;
+    const http::Reply::status_type status =
+        dataset->compute_table(route_parameters, result_table, length_table);
+    if (http::Reply::ok != status)
+    {
+        return status;
+    }
+    distance_table.swap(*result_table);
+    return http::Reply::ok;
+}
+
+http::Reply::status_type OSRM_impl::CheckSum(const RouteParameters &route_parameters,
+                                             unsigned &check_sum)
+{
+    const std::shared_ptr<const Dataset> dataset = GetDataset(route_parameters);
+    if (nullptr == dataset)
+    {
+        return http::Reply::badRequest;
+    }
+    const SharedQueryGuard query_guard(barrier.get(), query_data_facade);
+    check_sum = dataset->facade->GetCheckSum();
+    return http::Reply::ok;
+}
+
+http::Reply::status_type OSRM_impl::Nearest(const RouteParameters &route_parameters,
+                                            std::vector<PhantomNode> &phantom_nodes)
+{
+    const std::shared_ptr<const Dataset> dataset = GetDataset(route_parameters);
+    if (nullptr == dataset)
+    {
+        return http::Reply::badRequest;
+    }
+    const AdmissionTicket ticket(admission_control,
+                                 dataset->nearest_plugin->EstimateCost(route_parameters));
+    if (!ticket.IsAdmitted())
+    {
+        return http::Reply::serviceUnavailable;
+    }
+    const SharedQueryGuard query_guard(barrier.get(), query_data_facade);
+    return dataset->compute_nearest(route_parameters, phantom_nodes) ? http::Reply::ok
+                                                                     : http::Reply::badRequest;
+}
+
 // proxy code for compilation firewall
 
-OSRM::OSRM(ServerPaths paths, const bool use_shared_memory)
-    : OSRM_pimpl_(osrm::make_unique<OSRM_impl>(paths, use_shared_memory))
+OSRM::OSRM(ServerPaths paths,
+           const bool use_shared_memory,
+           const unsigned max_query_cost,
+           const unsigned max_query_time,
+           NamedServerPaths named_paths,
+           const bool parallel_search)
+    : OSRM_pimpl_(osrm::make_unique<OSRM_impl>(paths,
+                                               use_shared_memory,
+                                               max_query_cost,
+                                               max_query_time,
+                                               std::move(named_paths),
+                                               parallel_search))
 {
 }
 
@@ -164,3 +487,55 @@ void OSRM::RunQuery(RouteParameters &route_parameters, http::Reply &reply)
 {
     OSRM_pimpl_->RunQuery(route_parameters, reply);
 }
+
+std::shared_ptr<const AdmissionTicket> OSRM::Admit(const RouteParameters &route_parameters)
+{
+    return OSRM_pimpl_->Admit(route_parameters);
+}
+
+void OSRM::RunQuery(RouteParameters &route_parameters,
+                    http::Reply &reply,
+                    const AdmissionTicket &ticket)
+{
+    OSRM_pimpl_->RunQuery(route_parameters, reply, ticket);
+}
+
+void OSRM::Prefault(const bool lock_to_ram) { OSRM_pimpl_->Prefault(lock_to_ram); }
+
+bool OSRM::Reload() { return OSRM_pimpl_->Reload(); }
+
+void OSRM::AddStatusCounter(const std::string &name, std::function<uint64_t()> counter)
+{
+    OSRM_pimpl_->AddStatusCounter(name, std::move(counter));
+}
+
+http::Reply::status_type OSRM::Route(const RouteParameters &route_parameters,
+                                     RawRouteData &raw_route)
+{
+    return OSRM_pimpl_->Route(route_parameters, raw_route);
+}
+
+http::Reply::status_type OSRM::Table(const RouteParameters &route_parameters,
+                                     std::vector<int> &distance_table)
+{
+    return OSRM_pimpl_->Table(route_parameters, distance_table, nullptr);
+}
+
+http::Reply::status_type OSRM::Table(const RouteParameters &route_parameters,
+                                     std::vector<int> &distance_table,
+                                     std::vector<int> &length_table)
+{
+    return OSRM_pimpl_->Table(route_parameters, distance_table, &length_table);
+}
+
+http::Reply::status_type OSRM::CheckSum(const RouteParameters &route_parameters,
+                                        unsigned &check_sum)
+{
+    return OSRM_pimpl_->CheckSum(route_parameters, check_sum);
+}
+
+http::Reply::status_type OSRM::Nearest(const RouteParameters &route_parameters,
+                                       std::vector<PhantomNode> &phantom_nodes)
+{
+    return OSRM_pimpl_->Nearest(route_parameters, phantom_nodes);
+}
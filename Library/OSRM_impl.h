@@ -29,16 +29,26 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define OSRM_IMPL_H
 
 class BasePlugin;
-namespace http { class Reply; }
+struct PhantomNode;
+struct RawRouteData;
 struct RouteParameters;
 
+#include <osrm/Reply.h>
 #include <osrm/ServerPaths.h>
 
+#include "../DataStructures/AdmissionControl.h"
+#include "../DataStructures/QueryContextPool.h"
+#include "../DataStructures/QueryDeadline.h"
 #include "../DataStructures/QueryEdge.h"
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <string>
+#include <utility>
+#include <vector>
 
 struct SharedBarriers;
 template <class EdgeDataT> class BaseDataFacade;
@@ -47,19 +57,70 @@ class OSRM_impl
 {
   private:
     using PluginMap = std::unordered_map<std::string, BasePlugin *>;
+    // a graph with its facade and the plugins that answer queries on it
+    struct Dataset;
+    // the keys are fixed after construction, the values are swapped atomically on reload
+    using DatasetMap = std::unordered_map<std::string, std::shared_ptr<Dataset>>;
 
   public:
-    OSRM_impl(ServerPaths paths, const bool use_shared_memory);
+    OSRM_impl(ServerPaths paths,
+              const bool use_shared_memory,
+              const unsigned max_query_cost,
+              const unsigned max_query_time,
+              NamedServerPaths named_paths,
+              const bool parallel_search);
     OSRM_impl(const OSRM_impl &) = delete;
     virtual ~OSRM_impl();
     void RunQuery(RouteParameters &route_parameters, http::Reply &reply);
+    std::shared_ptr<const AdmissionTicket> Admit(const RouteParameters &route_parameters);
+    void RunQuery(RouteParameters &route_parameters,
+                  http::Reply &reply,
+                  const AdmissionTicket &ticket);
+    void Prefault(const bool lock_to_ram);
+    bool Reload();
+    void AddStatusCounter(const std::string &name, std::function<uint64_t()> counter);
+
+    http::Reply::status_type Route(const RouteParameters &route_parameters,
+                                   RawRouteData &raw_route);
+    http::Reply::status_type Table(const RouteParameters &route_parameters,
+                                   std::vector<int> &distance_table,
+                                   std::vector<int> *length_table);
+    http::Reply::status_type Nearest(const RouteParameters &route_parameters,
+                                     std::vector<PhantomNode> &phantom_nodes);
+    http::Reply::status_type CheckSum(const RouteParameters &route_parameters,
+                                      unsigned &check_sum);
 
   private:
-    void RegisterPlugin(BasePlugin *plugin);
-    PluginMap plugin_map;
+    // instantiates the plugins with the concrete facade type, so that the routing
+    // algorithms call the facade without virtual dispatch
+    template <class DataFacadeT>
+    std::shared_ptr<Dataset> RegisterPlugins(const std::string &name, DataFacadeT *facade);
+    void RegisterPlugin(Dataset &dataset, BasePlugin *plugin);
+    // returns nullptr if no dataset of the requested name is loaded. The returned
+    // reference keeps the dataset alive while a reload swaps in a new one.
+    std::shared_ptr<const Dataset> GetDataset(const RouteParameters &route_parameters) const;
+    // cost of the plugin that answers the query, zero if there is none
+    unsigned EstimateCost(const RouteParameters &route_parameters) const;
+    // heaps are shared by the queries on all datasets
+    QueryContextPool query_contexts;
+    // bounds the estimated cost of all admitted queries, queued or running
+    AdmissionControl admission_control;
+    // bounds the run time of every search and counts the aborted ones
+    QueryTimeLimit time_limit;
+    // lets the via route plugins of all datasets search on the TBB pool
+    const bool parallel_search;
+    // reported by the status plugins of all datasets
+    std::vector<std::pair<std::string, std::function<uint64_t()>>> status_counters;
     // will only be initialized if shared memory is used
     std::unique_ptr<SharedBarriers> barrier;
-    // base class pointer to the objects
+    // the default dataset has an empty name
+    DatasetMap datasets;
+    // serializes reloads, queries never take it
+    std::mutex reload_mutex;
+    // reloaded datasets are warmed up like the initial ones before they are swapped in
+    bool prefault_on_reload;
+    bool lock_to_ram_on_reload;
+    // facade in shared memory, nullptr if the default dataset is loaded into the process
     BaseDataFacade<QueryEdge::EdgeData> *query_data_facade;
 };
 
@@ -45,6 +45,8 @@ class BasePlugin
     virtual ~BasePlugin() {}
     virtual const std::string GetDescriptor() const = 0;
     virtual void HandleRequest(const RouteParameters &routeParameters, http::Reply &reply) = 0;
+    // rough cost of a request in units of a single point-to-point search, used for admission
+    virtual unsigned EstimateCost(const RouteParameters &) const { return 1; }
 };
 
 #endif /* BASEPLUGIN_H_ */
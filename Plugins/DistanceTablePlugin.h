@@ -31,17 +31,22 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "BasePlugin.h"
 
 #include "../Algorithms/ObjectToBase64.h"
+#include "../DataStructures/BinaryContainer.h"
 #include "../DataStructures/JSONContainer.h"
+#include "../DataStructures/QueryDeadline.h"
 #include "../DataStructures/QueryEdge.h"
 #include "../DataStructures/SearchEngine.h"
 #include "../Descriptors/BaseDescriptor.h"
 #include "../Util/make_unique.hpp"
+#include "../Util/simple_logger.hpp"
 #include "../Util/StringUtil.h"
 #include "../Util/TimingUtil.h"
 
+#include <cmath>
 #include <cstdlib>
 
 #include <algorithm>
+#include <limits>
 #include <memory>
 #include <unordered_map>
 #include <string>
@@ -53,22 +58,150 @@ template <class DataFacadeT> class DistanceTablePlugin final : public BasePlugin
     std::unique_ptr<SearchEngine<DataFacadeT>> search_engine_ptr;
 
   public:
-    explicit DistanceTablePlugin(DataFacadeT *facade) : descriptor_string("table"), facade(facade)
+    DistanceTablePlugin(DataFacadeT *facade,
+                        QueryContextPool &query_contexts,
+                        QueryTimeLimit &time_limit)
+        : descriptor_string("table"), facade(facade), time_limit(time_limit)
     {
-        search_engine_ptr = osrm::make_unique<SearchEngine<DataFacadeT>>(facade);
+        search_engine_ptr = osrm::make_unique<SearchEngine<DataFacadeT>>(facade, query_contexts);
     }
 
     virtual ~DistanceTablePlugin() {}
 
     const std::string GetDescriptor() const final { return descriptor_string; }
 
+    unsigned EstimateCost(const RouteParameters &route_parameters) const final
+    {
+        return EstimateTableCost(route_parameters, MAX_LOCATIONS);
+    }
+
+    // as EstimateCost, for a table that is square over at most max_square_locations
+    static unsigned EstimateTableCost(const RouteParameters &route_parameters,
+                                      const std::size_t max_square_locations)
+    {
+        std::vector<unsigned> sources, targets;
+        GetSourcesAndTargets(route_parameters, sources, targets, max_square_locations);
+        // a search per source and per target, and a bucket scan per entry of the table
+        return std::max(1u,
+                        static_cast<unsigned>(sources.size() + targets.size() +
+                                              sources.size() * targets.size()));
+    }
+
     void HandleRequest(const RouteParameters &route_parameters, http::Reply &reply) final
+    {
+        std::shared_ptr<std::vector<EdgeWeight>> result_table;
+        std::vector<EdgeWeight> length_table;
+        const http::Reply::status_type status = ComputeTable(
+            route_parameters, result_table, route_parameters.lengths ? &length_table : nullptr);
+        if (http::Reply::ok != status)
+        {
+            reply = http::Reply::StockReply(status);
+            return;
+        }
+        std::vector<unsigned> sources, targets;
+        GetSourcesAndTargets(route_parameters, sources, targets);
+        const unsigned number_of_targets = static_cast<unsigned>(targets.size());
+        if ("binary" == route_parameters.output_format)
+        { // written straight from the result vectors
+            Binary::Writer writer(reply.content, Binary::TablePayload);
+            writer.Reserve(2 * sizeof(std::uint32_t) +
+                           (result_table->size() + length_table.size()) * sizeof(EdgeWeight));
+            writer.AppendUInt32(static_cast<std::uint32_t>(sources.size()));
+            writer.AppendUInt32(number_of_targets);
+            writer.AppendInt32Array(*result_table);
+            if (route_parameters.lengths)
+            {
+                writer.AppendInt32Array(length_table);
+            }
+            writer.Finish();
+            return;
+        }
+        JSON::Object json_object;
+        json_object.values["distance_table"] = RenderMatrix(*result_table, number_of_targets);
+        if (route_parameters.lengths)
+        {
+            json_object.values["length_table"] = RenderMatrix(length_table, number_of_targets);
+        }
+        JSON::render(reply.content, json_object);
+    }
+
+    static JSON::Array RenderMatrix(const std::vector<EdgeWeight> &table,
+                                    const unsigned number_of_columns)
+    {
+        JSON::Array json_array;
+        const unsigned number_of_rows = static_cast<unsigned>(table.size()) / number_of_columns;
+        for (unsigned row = 0; row < number_of_rows; ++row)
+        {
+            JSON::Array json_row;
+            auto row_begin_iterator = table.begin() + (row * number_of_columns);
+            auto row_end_iterator = table.begin() + ((row + 1) * number_of_columns);
+            json_row.values.insert(json_row.values.end(), row_begin_iterator, row_end_iterator);
+            json_array.values.push_back(json_row);
+        }
+        return json_array;
+    }
+
+    // a table has at most MAX_LOCATIONS^2 entries, as every entry is a scan of the buckets, and
+    // at most MAX_SOURCES_AND_TARGETS sources and targets together, as every one of them is a
+    // search whose space is kept in memory. A few sources against many targets stay cheap.
+    static constexpr unsigned MAX_LOCATIONS = 100;
+    static constexpr unsigned MAX_SOURCES_AND_TARGETS = 4000;
+
+    // indices of the locations that are the rows resp. the columns of the table. Locations given
+    // as loc= are both, src= only a row and dst= only a column. A table of loc= locations only
+    // is square over the first max_square_locations of them.
+    static void GetSourcesAndTargets(const RouteParameters &route_parameters,
+                                     std::vector<unsigned> &sources,
+                                     std::vector<unsigned> &targets,
+                                     const std::size_t max_square_locations = MAX_LOCATIONS)
+    {
+        const unsigned number_of_coordinates =
+            static_cast<unsigned>(route_parameters.coordinates.size());
+        for (unsigned i = 0; i < number_of_coordinates; ++i)
+        {
+            if (i >= route_parameters.is_source.size() || route_parameters.is_source[i])
+            {
+                sources.push_back(i);
+            }
+            if (i >= route_parameters.is_destination.size() || route_parameters.is_destination[i])
+            {
+                targets.push_back(i);
+            }
+        }
+        if (sources.size() == number_of_coordinates && targets.size() == number_of_coordinates)
+        {
+            sources.resize(std::min<std::size_t>(max_square_locations, number_of_coordinates));
+            targets = sources;
+        }
+    }
+
+    // computes the row-major table with a row per source and a column per target without
+    // rendering it. If length_table is given, it receives the lengths of the same paths in
+    // meters. Returns badRequest if the parameters are invalid or the table would have more
+    // than max_table_size entries or more than max_locations sources and targets together,
+    // and serviceUnavailable if the search ran out of time. A table of loc= locations only is
+    // square over as many of them as fit into max_table_size.
+    http::Reply::status_type
+    ComputeTable(const RouteParameters &route_parameters,
+                 std::shared_ptr<std::vector<EdgeWeight>> &result_table,
+                 std::vector<EdgeWeight> *length_table = nullptr,
+                 const std::size_t max_table_size = MAX_LOCATIONS * MAX_LOCATIONS,
+                 const std::size_t max_locations = MAX_SOURCES_AND_TARGETS)
     {
         // check number of parameters
         if (2 > route_parameters.coordinates.size())
         {
-            reply = http::Reply::StockReply(http::Reply::badRequest);
-            return;
+            return http::Reply::badRequest;
+        }
+        const std::size_t max_square_locations =
+            static_cast<std::size_t>(std::sqrt(static_cast<double>(max_table_size)));
+        std::vector<unsigned> sources, targets;
+        GetSourcesAndTargets(route_parameters, sources, targets, max_square_locations);
+        if (sources.empty() || targets.empty() ||
+            sources.size() * targets.size() > max_table_size ||
+            sources.size() + targets.size() > max_locations)
+        {
+            return http::Reply::badRequest;
         }
 
         RawRouteData raw_route;
@@ -81,8 +214,7 @@ template <class DataFacadeT> class DistanceTablePlugin final : public BasePlugin
                 return !coordinate.isValid();
             }))
         {
-            reply = http::Reply::StockReply(http::Reply::badRequest);
-            return;
+            return http::Reply::badRequest;
         }
 
         for (const FixedPointCoordinate &coordinate : route_parameters.coordinates)
@@ -90,12 +222,25 @@ template <class DataFacadeT> class DistanceTablePlugin final : public BasePlugin
             raw_route.raw_via_node_coordinates.emplace_back(std::move(coordinate));
         }
 
+        // only the locations in the table are snapped to the graph
+        std::vector<bool> is_used(route_parameters.coordinates.size(), false);
+        for (const unsigned i : sources)
+        {
+            is_used[i] = true;
+        }
+        for (const unsigned i : targets)
+        {
+            is_used[i] = true;
+        }
+
         const bool checksum_OK = (route_parameters.check_sum == raw_route.check_sum);
-        unsigned max_locations =
-            std::min(100u, static_cast<unsigned>(raw_route.raw_via_node_coordinates.size()));
-        PhantomNodeArray phantom_node_vector(max_locations);
-        for (unsigned i = 0; i < max_locations; ++i)
+        PhantomNodeArray phantom_node_vector(route_parameters.coordinates.size());
+        for (unsigned i = 0; i < phantom_node_vector.size(); ++i)
         {
+            if (!is_used[i])
+            {
+                continue;
+            }
             if (checksum_OK && i < route_parameters.hints.size() &&
                 !route_parameters.hints[i].empty())
             {
@@ -115,34 +260,52 @@ template <class DataFacadeT> class DistanceTablePlugin final : public BasePlugin
             BOOST_ASSERT(phantom_node_vector[i].front().isValid(facade->GetNumberOfNodes()));
         }
 
-        // TIMER_START(distance_table);
-        std::shared_ptr<std::vector<EdgeWeight>> result_table =
-            search_engine_ptr->distance_table(phantom_node_vector);
-        // TIMER_STOP(distance_table);
-
-        if (!result_table)
+        PhantomNodeArray source_phantom_nodes, target_phantom_nodes;
+        for (const unsigned i : sources)
         {
-            reply = http::Reply::StockReply(http::Reply::badRequest);
-            return;
+            source_phantom_nodes.push_back(phantom_node_vector[i]);
         }
-        JSON::Object json_object;
-        JSON::Array json_array;
-        const unsigned number_of_locations = static_cast<unsigned>(phantom_node_vector.size());
-        for (unsigned row = 0; row < number_of_locations; ++row)
+        for (const unsigned i : targets)
         {
-            JSON::Array json_row;
-            auto row_begin_iterator = result_table->begin() + (row * number_of_locations);
-            auto row_end_iterator = result_table->begin() + ((row + 1) * number_of_locations);
-            json_row.values.insert(json_row.values.end(), row_begin_iterator, row_end_iterator);
-            json_array.values.push_back(json_row);
+            target_phantom_nodes.push_back(phantom_node_vector[i]);
         }
-        json_object.values["distance_table"] = json_array;
-        JSON::render(reply.content, json_object);
+
+        QueryDeadline deadline =
+            time_limit.Start(route_parameters.query_start, route_parameters.cancelled);
+        result_table = search_engine_ptr->distance_table(
+            source_phantom_nodes, target_phantom_nodes, deadline, length_table);
+        if (deadline.WasExpired())
+        {
+            if (deadline.WasCancelled())
+            {
+                SimpleLogger().Write(logDEBUG)
+                    << "table search cancelled, the client has gone away";
+            }
+            else
+            {
+                time_limit.CountAborted();
+                SimpleLogger().Write(logDEBUG) << "table search aborted after "
+                                               << time_limit.GetMaxMilliseconds() << " ms";
+            }
+            return http::Reply::serviceUnavailable;
+        }
+        if (nullptr != length_table)
+        { // decimeters to meters, unreachable entries stay at the maximum
+            for (EdgeWeight &length : *length_table)
+            {
+                if (std::numeric_limits<EdgeWeight>::max() != length)
+                {
+                    length = (length + 5) / 10;
+                }
+            }
+        }
+        return http::Reply::ok;
     }
 
   private:
     std::string descriptor_string;
     DataFacadeT *facade;
+    QueryTimeLimit &time_limit;
 };
 
 #endif // DISTANCE_TABLE_PLUGIN_H
@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define NEAREST_PLUGIN_H
 
 #include "BasePlugin.h"
+#include "../DataStructures/BinaryContainer.h"
 #include "../DataStructures/JSONContainer.h"
 #include "../DataStructures/PhantomNodes.h"
 #include "../DataStructures/Range.h"
@@ -48,18 +49,18 @@ template <class DataFacadeT> class NearestPlugin final : public BasePlugin
 
     void HandleRequest(const RouteParameters &route_parameters, http::Reply &reply) final
     {
-        // check number of parameters
-        if (route_parameters.coordinates.empty() || !route_parameters.coordinates.front().isValid())
+        std::vector<PhantomNode> phantom_node_vector;
+        if (!ComputeNearest(route_parameters, phantom_node_vector))
         {
             reply = http::Reply::StockReply(http::Reply::badRequest);
             return;
         }
         auto number_of_results = static_cast<std::size_t>(route_parameters.num_results);
-        std::vector<PhantomNode> phantom_node_vector;
-        facade->IncrementalFindPhantomNodeForCoordinate(route_parameters.coordinates.front(),
-                                                        phantom_node_vector,
-                                                        route_parameters.zoom_level,
-                                                        static_cast<int>(number_of_results));
+        if ("binary" == route_parameters.output_format)
+        {
+            RenderBinary(phantom_node_vector, number_of_results, reply);
+            return;
+        }
 
         JSON::Object json_result;
         if (phantom_node_vector.empty() || !phantom_node_vector.front().isValid())
@@ -108,7 +109,49 @@ template <class DataFacadeT> class NearestPlugin final : public BasePlugin
         JSON::render(reply.content, json_result);
     }
 
+    // finds the nearest phantom nodes without rendering them, false if the parameters are invalid
+    bool ComputeNearest(const RouteParameters &route_parameters,
+                        std::vector<PhantomNode> &phantom_node_vector)
+    {
+        // check number of parameters
+        if (route_parameters.coordinates.empty() || !route_parameters.coordinates.front().isValid())
+        {
+            return false;
+        }
+        facade->IncrementalFindPhantomNodeForCoordinate(route_parameters.coordinates.front(),
+                                                        phantom_node_vector,
+                                                        route_parameters.zoom_level,
+                                                        route_parameters.num_results);
+        return true;
+    }
+
   private:
+    void RenderBinary(const std::vector<PhantomNode> &phantom_node_vector,
+                      const std::size_t number_of_results,
+                      http::Reply &reply) const
+    {
+        Binary::Writer writer(reply.content, Binary::NearestPayload);
+        if (phantom_node_vector.empty() || !phantom_node_vector.front().isValid())
+        {
+            writer.AppendInt32(207);
+            writer.Finish();
+            return;
+        }
+        const std::size_t result_count =
+            std::min(std::max<std::size_t>(1, number_of_results), phantom_node_vector.size());
+        writer.AppendInt32(0);
+        writer.AppendUInt32(static_cast<std::uint32_t>(result_count));
+        std::string name;
+        for (const auto i : osrm::irange<std::size_t>(0, result_count))
+        {
+            writer.AppendInt32(phantom_node_vector[i].location.lat);
+            writer.AppendInt32(phantom_node_vector[i].location.lon);
+            facade->GetName(phantom_node_vector[i].name_id, name);
+            writer.AppendString(name);
+        }
+        writer.Finish();
+    }
+
     DataFacadeT *facade;
     std::string descriptor_string;
 };
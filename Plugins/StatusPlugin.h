@@ -0,0 +1,87 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef STATUS_PLUGIN_H
+#define STATUS_PLUGIN_H
+
+#include "BasePlugin.h"
+#include "../DataStructures/AdmissionControl.h"
+#include "../DataStructures/JSONContainer.h"
+#include "../DataStructures/QueryDeadline.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// reports the counters of the admission control and of aborted searches, followed by the
+// counters that the embedding application added, e.g. the queues of the server
+class StatusPlugin final : public BasePlugin
+{
+  public:
+    using CounterList = std::vector<std::pair<std::string, std::function<uint64_t()>>>;
+
+    StatusPlugin(const AdmissionControl &admission_control,
+                 const QueryTimeLimit &time_limit,
+                 const CounterList &counters)
+        : admission_control(admission_control), time_limit(time_limit), counters(counters),
+          descriptor_string("status")
+    {
+    }
+    virtual ~StatusPlugin() {}
+    const std::string GetDescriptor() const final { return descriptor_string; }
+
+    // never rejected, as it is needed most when the server is overloaded
+    unsigned EstimateCost(const RouteParameters &) const final { return 0; }
+
+    void HandleRequest(const RouteParameters &, http::Reply &reply) final
+    {
+        reply.status = http::Reply::ok;
+        JSON::Object json_result;
+        json_result.values["status"] = 0;
+        json_result.values["max_cost"] = admission_control.GetMaxCost();
+        json_result.values["cost_in_flight"] = admission_control.GetCostInFlight();
+        json_result.values["admitted"] = admission_control.GetAdmittedCount();
+        json_result.values["rejected"] = admission_control.GetRejectedCount();
+        json_result.values["max_query_time_ms"] = time_limit.GetMaxMilliseconds();
+        json_result.values["aborted"] = time_limit.GetAbortedCount();
+        for (const auto &counter : counters)
+        {
+            json_result.values[counter.first] = counter.second();
+        }
+        JSON::render(reply.content, json_result);
+    }
+
+  private:
+    const AdmissionControl &admission_control;
+    const QueryTimeLimit &time_limit;
+    const CounterList &counters;
+    std::string descriptor_string;
+};
+
+#endif // STATUS_PLUGIN_H
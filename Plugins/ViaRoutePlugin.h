@@ -31,9 +31,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "BasePlugin.h"
 
 #include "../Algorithms/ObjectToBase64.h"
+#include "../DataStructures/QueryDeadline.h"
 #include "../DataStructures/QueryEdge.h"
 #include "../DataStructures/SearchEngine.h"
 #include "../Descriptors/BaseDescriptor.h"
+#include "../Descriptors/BinaryDescriptor.h"
 #include "../Descriptors/GPXDescriptor.h"
 #include "../Descriptors/JSONDescriptor.h"
 #include "../Util/make_unique.hpp"
@@ -56,20 +58,90 @@ template <class DataFacadeT> class ViaRoutePlugin final : public BasePlugin
     std::unique_ptr<SearchEngine<DataFacadeT>> search_engine_ptr;
 
   public:
-    explicit ViaRoutePlugin(DataFacadeT *facade) : descriptor_string("viaroute"), facade(facade)
+    ViaRoutePlugin(DataFacadeT *facade,
+                   QueryContextPool &query_contexts,
+                   QueryTimeLimit &time_limit,
+                   const bool parallel_search = false)
+        : descriptor_string("viaroute"), facade(facade), time_limit(time_limit)
     {
-        search_engine_ptr = osrm::make_unique<SearchEngine<DataFacadeT>>(facade);
+        search_engine_ptr = osrm::make_unique<SearchEngine<DataFacadeT>>(
+            facade, query_contexts, parallel_search);
 
         descriptor_table.emplace("json", 0);
         descriptor_table.emplace("gpx", 1);
-        // descriptor_table.emplace("geojson", 2);
+        descriptor_table.emplace("binary", 2);
+        // descriptor_table.emplace("geojson", 3);
     }
 
     virtual ~ViaRoutePlugin() {}
 
     const std::string GetDescriptor() const final { return descriptor_string; }
 
+    unsigned EstimateCost(const RouteParameters &route_parameters) const final
+    {
+        // fewer than two locations are rejected without a search
+        if (2 > route_parameters.coordinates.size())
+        {
+            return 1;
+        }
+        const unsigned number_of_legs =
+            static_cast<unsigned>(route_parameters.coordinates.size()) - 1;
+        // alternatives are only computed for a single leg, each one is about another search
+        const bool is_alternate_search = route_parameters.alternate_route && 1 == number_of_legs;
+        const unsigned number_of_alternatives =
+            static_cast<unsigned>(std::max<short>(1, route_parameters.num_alternatives));
+        return is_alternate_search ? 1 + number_of_alternatives : number_of_legs;
+    }
+
     void HandleRequest(const RouteParameters &route_parameters, http::Reply &reply) final
+    {
+        RawRouteData raw_route;
+        const http::Reply::status_type status = ComputeRoute(route_parameters, raw_route);
+        if (http::Reply::ok != status)
+        {
+            reply = http::Reply::StockReply(status);
+            return;
+        }
+        reply.status = http::Reply::ok;
+
+        DescriptorConfig descriptor_config;
+
+        auto iter = descriptor_table.find(route_parameters.output_format);
+        unsigned descriptor_type = (iter != descriptor_table.end() ? iter->second : 0);
+
+        descriptor_config.zoom_level = route_parameters.zoom_level;
+        descriptor_config.instructions = route_parameters.print_instructions;
+        descriptor_config.geometry = route_parameters.geometry;
+        descriptor_config.encode_geometry = route_parameters.compression;
+
+        std::shared_ptr<BaseDescriptor<DataFacadeT>> descriptor;
+        switch (descriptor_type)
+        {
+        // case 0:
+        //     descriptor = std::make_shared<JSONDescriptor<DataFacadeT>>();
+        //     break;
+        case 1:
+            descriptor = std::make_shared<GPXDescriptor<DataFacadeT>>(facade);
+            break;
+        case 2:
+            descriptor = std::make_shared<BinaryDescriptor<DataFacadeT>>(facade);
+            break;
+        // case 3:
+        //      descriptor = std::make_shared<GEOJSONDescriptor<DataFacadeT>>();
+        //      break;
+        default:
+            descriptor = std::make_shared<JSONDescriptor<DataFacadeT>>(facade);
+            break;
+        }
+
+        descriptor->SetConfig(descriptor_config);
+        descriptor->Run(raw_route, reply);
+    }
+
+    // computes the route without rendering it. Returns badRequest if the parameters are
+    // invalid and serviceUnavailable if the search ran out of time.
+    http::Reply::status_type ComputeRoute(const RouteParameters &route_parameters,
+                                          RawRouteData &raw_route)
     {
         // check number of parameters
         if (2 > route_parameters.coordinates.size() ||
@@ -80,11 +152,9 @@ template <class DataFacadeT> class ViaRoutePlugin final : public BasePlugin
                 return !coordinate.isValid();
             }))
         {
-            reply = http::Reply::StockReply(http::Reply::badRequest);
-            return;
+            return http::Reply::badRequest;
         }
 
-        RawRouteData raw_route;
         raw_route.check_sum = facade->GetCheckSum();
         for (const FixedPointCoordinate &coordinate : route_parameters.coordinates)
         {
@@ -118,59 +188,50 @@ template <class DataFacadeT> class ViaRoutePlugin final : public BasePlugin
             raw_route.segment_end_coordinates.emplace_back(current_phantom_node_pair);
         }
 
+        QueryDeadline deadline =
+            time_limit.Start(route_parameters.query_start, route_parameters.cancelled);
         const bool is_alternate_requested = route_parameters.alternate_route;
         const bool is_only_one_segment = (1 == raw_route.segment_end_coordinates.size());
         if (is_alternate_requested && is_only_one_segment)
         {
             search_engine_ptr->alternative_path(raw_route.segment_end_coordinates.front(),
-                                                raw_route);
+                                                raw_route,
+                                                deadline,
+                                                route_parameters.num_alternatives);
         }
         else
         {
             search_engine_ptr->shortest_path(
-                raw_route.segment_end_coordinates, route_parameters.uturns, raw_route);
+                raw_route.segment_end_coordinates, route_parameters.uturns, raw_route, deadline);
         }
 
-        if (INVALID_EDGE_WEIGHT == raw_route.shortest_path_length)
+        if (deadline.WasExpired())
         {
-            SimpleLogger().Write(logDEBUG) << "Error occurred, single path not found";
+            if (deadline.WasCancelled())
+            {
+                SimpleLogger().Write(logDEBUG)
+                    << "route search cancelled, the client has gone away";
+            }
+            else
+            {
+                time_limit.CountAborted();
+                SimpleLogger().Write(logDEBUG) << "route search aborted after "
+                                               << time_limit.GetMaxMilliseconds() << " ms";
+            }
+            return http::Reply::serviceUnavailable;
         }
-        reply.status = http::Reply::ok;
-
-        DescriptorConfig descriptor_config;
-
-        auto iter = descriptor_table.find(route_parameters.output_format);
-        unsigned descriptor_type = (iter != descriptor_table.end() ? iter->second : 0);
-
-        descriptor_config.zoom_level = route_parameters.zoom_level;
-        descriptor_config.instructions = route_parameters.print_instructions;
-        descriptor_config.geometry = route_parameters.geometry;
-        descriptor_config.encode_geometry = route_parameters.compression;
 
-        std::shared_ptr<BaseDescriptor<DataFacadeT>> descriptor;
-        switch (descriptor_type)
+        if (INVALID_EDGE_WEIGHT == raw_route.shortest_path_length)
         {
-        // case 0:
-        //     descriptor = std::make_shared<JSONDescriptor<DataFacadeT>>();
-        //     break;
-        case 1:
-            descriptor = std::make_shared<GPXDescriptor<DataFacadeT>>(facade);
-            break;
-        // case 2:
-        //      descriptor = std::make_shared<GEOJSONDescriptor<DataFacadeT>>();
-        //      break;
-        default:
-            descriptor = std::make_shared<JSONDescriptor<DataFacadeT>>(facade);
-            break;
+            SimpleLogger().Write(logDEBUG) << "Error occurred, single path not found";
         }
-
-        descriptor->SetConfig(descriptor_config);
-        descriptor->Run(raw_route, reply);
+        return http::Reply::ok;
     }
 
   private:
     std::string descriptor_string;
     DataFacadeT *facade;
+    QueryTimeLimit &time_limit;
 };
 
 #endif // VIA_ROUTE_PLUGIN_H
@@ -30,14 +30,18 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "BasicRoutingInterface.h"
 #include "../DataStructures/Range.h"
+#include "../DataStructures/QueryContextPool.h"
+#include "../DataStructures/QueryDeadline.h"
 #include "../DataStructures/SearchEngineData.h"
 #include "../Util/container.hpp"
 
 #include <boost/assert.hpp>
 
-#include <unordered_map>
-#include <unordered_set>
+#include <tbb/parallel_for.h>
 
+#include <algorithm>
+#include <thread>
+#include <utility>
 #include <vector>
 
 const double VIAPATH_ALPHA = 0.10;
@@ -67,36 +71,56 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
             return (2 * length + sharing) < (2 * other.length + other.sharing);
         }
     };
+
+    // path through a via node that passed the T-test
+    struct ViaPath
+    {
+        ViaPath() : length(INVALID_EDGE_WEIGHT) {}
+
+        int length;
+        std::vector<NodeID> packed_path;
+        // only needed to tell several alternatives apart
+        std::vector<SearchSpaceEdge> unpacked_edges;
+    };
+
     DataFacadeT *facade;
-    SearchEngineData &engine_working_data;
+    QueryContextPool &query_contexts;
+    const bool parallel_candidates;
 
   public:
-    AlternativeRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
-        : super(facade), facade(facade), engine_working_data(engine_working_data)
+    // via node candidates are inspected in parallel on the global TBB pool if
+    // parallel_candidates is set, the compute lanes of the server do not bound it
+    AlternativeRouting(DataFacadeT *facade,
+                       QueryContextPool &query_contexts,
+                       const bool parallel_candidates = false)
+        : super(facade), facade(facade), query_contexts(query_contexts),
+          parallel_candidates(parallel_candidates)
     {
     }
 
     virtual ~AlternativeRouting() {}
 
-    void operator()(const PhantomNodes &phantom_node_pair, RawRouteData &raw_route_data)
+    // Up to number_of_alternatives alternatives that differ enough from the shortest path and
+    // from each other are returned. No route is returned if the deadline expires during the
+    // search.
+    void operator()(const PhantomNodes &phantom_node_pair,
+                    RawRouteData &raw_route_data,
+                    QueryDeadline &deadline,
+                    const unsigned number_of_alternatives = 1)
     {
-        std::vector<NodeID> alternative_path;
         std::vector<NodeID> via_node_candidate_list;
         std::vector<SearchSpaceEdge> forward_search_space;
         std::vector<SearchSpaceEdge> reverse_search_space;
 
-        // Init queues, semi-expensive because access to TSS invokes a sys-call
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-        engine_working_data.InitializeOrClearSecondThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
-        engine_working_data.InitializeOrClearThirdThreadLocalStorage(
+        // heaps of this query, handed back to the pool when it returns
+        const QueryContextPool::Handle query_context = query_contexts.Acquire();
+        SearchEngineData &engine_working_data = *query_context;
+        // the other heaps are set up by the candidate inspections that use them
+        engine_working_data.InitializeOrClearFirstHeaps(
             super::facade->GetNumberOfNodes());
 
         QueryHeap &forward_heap1 = *(engine_working_data.forwardHeap);
         QueryHeap &reverse_heap1 = *(engine_working_data.backwardHeap);
-        QueryHeap &forward_heap2 = *(engine_working_data.forwardHeap2);
-        QueryHeap &reverse_heap2 = *(engine_working_data.backwardHeap2);
 
         int upper_bound_to_shortest_path_distance = INVALID_EDGE_WEIGHT;
         NodeID middle_node = SPECIAL_NODEID;
@@ -144,7 +168,7 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
         }
 
         // search from s and t till new_min/(1+epsilon) > length_of_shortest_path
-        while (0 < (forward_heap1.Size() + reverse_heap1.Size()))
+        while (0 < (forward_heap1.Size() + reverse_heap1.Size()) && !deadline.IsExpired())
         {
             if (0 < forward_heap1.Size())
             {
@@ -168,7 +192,7 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
             }
         }
 
-        if (INVALID_EDGE_WEIGHT == upper_bound_to_shortest_path_distance)
+        if (deadline.WasExpired() || INVALID_EDGE_WEIGHT == upper_bound_to_shortest_path_distance)
         {
             return;
         }
@@ -181,77 +205,26 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
         super::RetrievePackedPathFromSingleHeap(forward_heap1, middle_node, packed_forward_path);
         super::RetrievePackedPathFromSingleHeap(reverse_heap1, middle_node, packed_reverse_path);
 
-        // this set is is used as an indicator if a node is on the shortest path
-        std::unordered_set<NodeID> nodes_in_path(packed_forward_path.size() +
-                                                 packed_reverse_path.size());
-        nodes_in_path.insert(packed_forward_path.begin(), packed_forward_path.end());
-        nodes_in_path.insert(middle_node);
-        nodes_in_path.insert(packed_reverse_path.begin(), packed_reverse_path.end());
-
-        std::unordered_map<NodeID, int> approximated_forward_sharing;
-        std::unordered_map<NodeID, int> approximated_reverse_sharing;
-
-        // sweep over search space, compute forward sharing for each current edge (u,v)
-        for (const SearchSpaceEdge &current_edge : forward_search_space)
-        {
-            const NodeID u = current_edge.first;
-            const NodeID v = current_edge.second;
-
-            if (nodes_in_path.find(v) != nodes_in_path.end())
-            {
-                // current_edge is on shortest path => sharing(v):=queue.GetKey(v);
-                approximated_forward_sharing.emplace(v, forward_heap1.GetKey(v));
-            }
-            else
-            {
-                // current edge is not on shortest path. Check if we know a value for the other
-                // endpoint
-                const auto sharing_of_u_iterator = approximated_forward_sharing.find(u);
-                if (sharing_of_u_iterator != approximated_forward_sharing.end())
-                {
-                    approximated_forward_sharing.emplace(v, sharing_of_u_iterator->second);
-                }
-            }
-        }
-
-        // sweep over search space, compute backward sharing
-        for (const SearchSpaceEdge &current_edge : reverse_search_space)
-        {
-            const NodeID u = current_edge.first;
-            const NodeID v = current_edge.second;
-            if (nodes_in_path.find(v) != nodes_in_path.end())
-            {
-                // current_edge is on shortest path => sharing(u):=queue.GetKey(u);
-                approximated_reverse_sharing.emplace(v, reverse_heap1.GetKey(v));
-            }
-            else
-            {
-                // current edge is not on shortest path. Check if we know a value for the other
-                // endpoint
-                const auto sharing_of_u_iterator = approximated_reverse_sharing.find(u);
-                if (sharing_of_u_iterator != approximated_reverse_sharing.end())
-                {
-                    approximated_reverse_sharing.emplace(v, sharing_of_u_iterator->second);
-                }
-            }
-        }
+        std::vector<NodeID> &packed_shortest_path = packed_forward_path;
+        std::reverse(packed_shortest_path.begin(), packed_shortest_path.end());
+        packed_shortest_path.emplace_back(middle_node);
+        packed_shortest_path.insert(
+            packed_shortest_path.end(), packed_reverse_path.begin(), packed_reverse_path.end());
 
-        // SimpleLogger().Write(logDEBUG) << "fwd_search_space size: " <<
-        // forward_search_space.size() << ", marked " << approximated_forward_sharing.size() << "
-        // nodes";
-        // SimpleLogger().Write(logDEBUG) << "rev_search_space size: " <<
-        // reverse_search_space.size() << ", marked " << approximated_reverse_sharing.size() << "
-        // nodes";
+        // sharing with the shortest path, indexed by the position of a node in the search heaps
+        const std::vector<int> approximated_forward_sharing =
+            ApproximateSharing(forward_heap1, forward_search_space, packed_shortest_path);
+        const std::vector<int> approximated_reverse_sharing =
+            ApproximateSharing(reverse_heap1, reverse_search_space, packed_shortest_path);
 
         std::vector<NodeID> preselected_node_list;
         for (const NodeID node : via_node_candidate_list)
         {
-            const auto fwd_iterator = approximated_forward_sharing.find(node);
+            // candidates were reached by both searches
             const int fwd_sharing =
-                (fwd_iterator != approximated_forward_sharing.end()) ? fwd_iterator->second : 0;
-            const auto rev_iterator = approximated_reverse_sharing.find(node);
+                approximated_forward_sharing[forward_heap1.GetInsertionIndex(node)];
             const int rev_sharing =
-                (rev_iterator != approximated_reverse_sharing.end()) ? rev_iterator->second : 0;
+                approximated_reverse_sharing[reverse_heap1.GetInsertionIndex(node)];
 
             const int approximated_sharing = fwd_sharing + rev_sharing;
             const int approximated_length = forward_heap1.GetKey(node) + reverse_heap1.GetKey(node);
@@ -271,55 +244,140 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
             }
         }
 
-        std::vector<NodeID> &packed_shortest_path = packed_forward_path;
-        std::reverse(packed_shortest_path.begin(), packed_shortest_path.end());
-        packed_shortest_path.emplace_back(middle_node);
-        packed_shortest_path.insert(
-            packed_shortest_path.end(), packed_reverse_path.begin(), packed_reverse_path.end());
-        std::vector<RankedCandidateNode> ranked_candidates_list;
-
         // prioritizing via nodes for deep inspection
-        for (const NodeID node : preselected_node_list)
-        {
-            int length_of_via_path = 0, sharing_of_via_path = 0;
-            ComputeLengthAndSharingOfViaPath(node,
-                                             &length_of_via_path,
-                                             &sharing_of_via_path,
+        std::vector<RankedCandidateNode> inspected_candidates(
+            preselected_node_list.size(), RankedCandidateNode(SPECIAL_NODEID, 0, 0));
+        EvaluateCandidates(0,
+                           preselected_node_list.size(),
+                           engine_working_data,
+                           deadline,
+                           [&](const std::size_t index,
+                               SearchEngineData &candidate_working_data,
+                               QueryDeadline &candidate_deadline)
+                           {
+            RankedCandidateNode &candidate = inspected_candidates[index];
+            candidate.node = preselected_node_list[index];
+            ComputeLengthAndSharingOfViaPath(forward_heap1,
+                                             reverse_heap1,
+                                             candidate_working_data,
+                                             candidate.node,
+                                             &candidate.length,
+                                             &candidate.sharing,
                                              packed_shortest_path,
-                                             min_edge_offset);
-            const int maximum_allowed_sharing =
-                static_cast<int>(upper_bound_to_shortest_path_distance * VIAPATH_GAMMA);
-            if (sharing_of_via_path <= maximum_allowed_sharing &&
-                length_of_via_path <= upper_bound_to_shortest_path_distance * (1 + VIAPATH_EPSILON))
+                                             min_edge_offset,
+                                             candidate_deadline);
+        });
+        if (deadline.WasExpired())
+        {
+            return;
+        }
+
+        std::vector<RankedCandidateNode> ranked_candidates_list;
+        const int maximum_allowed_sharing =
+            static_cast<int>(upper_bound_to_shortest_path_distance * VIAPATH_GAMMA);
+        for (const RankedCandidateNode &candidate : inspected_candidates)
+        {
+            if (candidate.sharing <= maximum_allowed_sharing &&
+                candidate.length <= upper_bound_to_shortest_path_distance * (1 + VIAPATH_EPSILON))
             {
-                ranked_candidates_list.emplace_back(node, length_of_via_path, sharing_of_via_path);
+                ranked_candidates_list.emplace_back(candidate);
             }
         }
         std::sort(ranked_candidates_list.begin(), ranked_candidates_list.end());
 
-        NodeID selected_via_node = SPECIAL_NODEID;
-        int length_of_via_path = INVALID_EDGE_WEIGHT;
-        NodeID s_v_middle = SPECIAL_NODEID, v_t_middle = SPECIAL_NODEID;
-        for (const RankedCandidateNode &candidate : ranked_candidates_list)
-        {
-            if (ViaNodeCandidatePassesTTest(forward_heap1,
-                                            reverse_heap1,
-                                            forward_heap2,
-                                            reverse_heap2,
-                                            candidate,
-                                            upper_bound_to_shortest_path_distance,
-                                            &length_of_via_path,
-                                            &s_v_middle,
-                                            &v_t_middle,
-                                            min_edge_offset))
-            {
-                // select first admissable
-                selected_via_node = candidate.node;
-                break;
+        // The T-tests of a batch of candidates run concurrently, admissible candidates are then
+        // selected in rank order. With one alternative this picks the first admissible one, just
+        // as a scan of one candidate after another would. The first batch only holds as many
+        // candidates as there are alternatives, later ones double up to one per hardware thread
+        // when fewer of the candidates turn out to be admissible.
+        std::size_t batch_size = parallel_candidates ? number_of_alternatives : 1;
+        const std::size_t max_batch_size =
+            std::max<std::size_t>(number_of_alternatives, std::thread::hardware_concurrency());
+        std::vector<ViaPath> via_paths(ranked_candidates_list.size());
+        std::vector<std::size_t> selected_via_paths;
+        for (std::size_t batch_begin = 0, batch_end = 0;
+             batch_begin < ranked_candidates_list.size() &&
+                 selected_via_paths.size() < number_of_alternatives;
+             batch_begin = batch_end)
+        {
+            batch_end = std::min(batch_begin + batch_size, ranked_candidates_list.size());
+            if (parallel_candidates)
+            {
+                batch_size = std::min(2 * batch_size, max_batch_size);
+            }
+            EvaluateCandidates(batch_begin,
+                               batch_end,
+                               engine_working_data,
+                               deadline,
+                               [&](const std::size_t index,
+                                   SearchEngineData &candidate_working_data,
+                                   QueryDeadline &candidate_deadline)
+                               {
+                candidate_working_data.InitializeOrClearSecondHeaps(
+                    super::facade->GetNumberOfNodes());
+                QueryHeap &forward_heap2 = *(candidate_working_data.forwardHeap2);
+                QueryHeap &reverse_heap2 = *(candidate_working_data.backwardHeap2);
+
+                NodeID s_v_middle = SPECIAL_NODEID, v_t_middle = SPECIAL_NODEID;
+                int length_of_via_path = INVALID_EDGE_WEIGHT;
+                if (ViaNodeCandidatePassesTTest(candidate_working_data,
+                                                forward_heap1,
+                                                reverse_heap1,
+                                                forward_heap2,
+                                                reverse_heap2,
+                                                ranked_candidates_list[index],
+                                                upper_bound_to_shortest_path_distance,
+                                                &length_of_via_path,
+                                                &s_v_middle,
+                                                &v_t_middle,
+                                                min_edge_offset,
+                                                candidate_deadline))
+                {
+                    via_paths[index].length = length_of_via_path;
+                    RetrievePackedAlternatePath(forward_heap1,
+                                                reverse_heap1,
+                                                forward_heap2,
+                                                reverse_heap2,
+                                                s_v_middle,
+                                                v_t_middle,
+                                                via_paths[index].packed_path);
+                }
+            });
+            if (deadline.WasExpired())
+            {
+                return;
+            }
+
+            for (std::size_t index = batch_begin;
+                 index < batch_end && selected_via_paths.size() < number_of_alternatives;
+                 ++index)
+            {
+                ViaPath &via_path = via_paths[index];
+                if (via_path.packed_path.empty())
+                {
+                    continue;
+                }
+                // different via nodes frequently lie on the very same detour
+                if (1 < number_of_alternatives)
+                {
+                    UnpackViaPathEdges(via_path);
+                }
+                const bool is_distinct =
+                    std::all_of(selected_via_paths.begin(),
+                                selected_via_paths.end(),
+                                [&](const std::size_t selected)
+                                {
+                    return ComputeSharingOfViaPaths(via_path, via_paths[selected]) <=
+                           via_paths[selected].length * VIAPATH_GAMMA;
+                });
+                if (is_distinct)
+                {
+                    selected_via_paths.emplace_back(index);
+                }
             }
         }
 
-        // Unpack shortest path and alternative, if they exist
+        // Unpack shortest path and alternatives, if they exist
         if (INVALID_EDGE_WEIGHT != upper_bound_to_shortest_path_distance)
         {
             BOOST_ASSERT(!packed_shortest_path.empty());
@@ -339,36 +397,129 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
             raw_route_data.shortest_path_length = upper_bound_to_shortest_path_distance;
         }
 
-        if (SPECIAL_NODEID != selected_via_node)
+        BOOST_ASSERT(raw_route_data.unpacked_alternatives.empty());
+        raw_route_data.unpacked_alternatives.resize(selected_via_paths.size());
+        for (const auto i : osrm::irange<std::size_t>(0, selected_via_paths.size()))
         {
-            std::vector<NodeID> packed_alternate_path;
-            // retrieve alternate path
-            RetrievePackedAlternatePath(forward_heap1,
-                                        reverse_heap1,
-                                        forward_heap2,
-                                        reverse_heap2,
-                                        s_v_middle,
-                                        v_t_middle,
-                                        packed_alternate_path);
-
-            raw_route_data.alt_source_traversed_in_reverse.push_back((
-                packed_alternate_path.front() != phantom_node_pair.source_phantom.forward_node_id));
+            const ViaPath &via_path = via_paths[selected_via_paths[i]];
+            raw_route_data.alt_source_traversed_in_reverse.push_back(
+                (via_path.packed_path.front() != phantom_node_pair.source_phantom.forward_node_id));
             raw_route_data.alt_target_traversed_in_reverse.push_back(
-                (packed_alternate_path.back() != phantom_node_pair.target_phantom.forward_node_id));
+                (via_path.packed_path.back() != phantom_node_pair.target_phantom.forward_node_id));
 
             // unpack the alternate path
             super::UnpackPath(
-                packed_alternate_path, phantom_node_pair, raw_route_data.unpacked_alternative);
+                via_path.packed_path, phantom_node_pair, raw_route_data.unpacked_alternatives[i]);
+            raw_route_data.alternative_path_lengths.emplace_back(via_path.length);
+        }
+    }
+
+  private:
+    // Sweep over a search space in the order it was settled. A node on the shortest path shares
+    // its whole distance to the origin of the search with it, any other node the sharing of its
+    // parent, which is nothing if there is no node of the shortest path among its ancestors.
+    // The result is indexed by the insertion index of a node in the search heap.
+    std::vector<int> ApproximateSharing(const QueryHeap &search_heap,
+                                        const std::vector<SearchSpaceEdge> &search_space,
+                                        const std::vector<NodeID> &packed_shortest_path) const
+    {
+        std::vector<int> approximated_sharing(search_heap.GetNumberOfInsertedNodes(), 0);
+        std::vector<bool> is_on_shortest_path(search_heap.GetNumberOfInsertedNodes(), false);
+        for (const NodeID node : packed_shortest_path)
+        {
+            if (search_heap.WasInserted(node))
+            {
+                is_on_shortest_path[search_heap.GetInsertionIndex(node)] = true;
+            }
+        }
+
+        // parents are settled before their children
+        for (const SearchSpaceEdge &current_edge : search_space)
+        {
+            const int u_index = search_heap.GetInsertionIndex(current_edge.first);
+            const int v_index = search_heap.GetInsertionIndex(current_edge.second);
+            approximated_sharing[v_index] = is_on_shortest_path[v_index]
+                                                ? search_heap.GetKey(current_edge.second)
+                                                : approximated_sharing[u_index];
+        }
+        return approximated_sharing;
+    }
 
-            raw_route_data.alternative_path_length = length_of_via_path;
+    // Calls evaluate(index, engine_working_data, deadline) for all candidates in [begin, end).
+    // Concurrent calls search in the heaps of a query context of their own and share nothing
+    // but the read-only heaps of the main search.
+    template <typename EvaluateT>
+    void EvaluateCandidates(const std::size_t begin,
+                            const std::size_t end,
+                            SearchEngineData &engine_working_data,
+                            QueryDeadline &deadline,
+                            const EvaluateT &evaluate)
+    {
+        if (parallel_candidates && 1 < end - begin)
+        {
+            std::vector<QueryDeadline> candidate_deadlines(end - begin, deadline);
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(begin, end),
+                              [&](const tbb::blocked_range<std::size_t> &range)
+                              {
+                const QueryContextPool::Handle query_context = query_contexts.Acquire();
+                for (std::size_t index = range.begin(); index != range.end(); ++index)
+                {
+                    evaluate(index, *query_context, candidate_deadlines[index - begin]);
+                }
+            });
+            for (const QueryDeadline &candidate_deadline : candidate_deadlines)
+            {
+                if (candidate_deadline.WasExpired())
+                {
+                    deadline = candidate_deadline;
+                }
+            }
         }
         else
         {
-            BOOST_ASSERT(raw_route_data.alternative_path_length == INVALID_EDGE_WEIGHT);
+            for (std::size_t index = begin; index != end && !deadline.WasExpired(); ++index)
+            {
+                evaluate(index, engine_working_data, deadline);
+            }
         }
     }
 
-  private:
+    // unpacked edges of a via path, sorted to look up the ones it shares with other paths
+    void UnpackViaPathEdges(ViaPath &via_path) const
+    {
+        std::vector<NodeID> unpacked_nodes;
+        for (std::size_t i = 1; i < via_path.packed_path.size(); ++i)
+        {
+            // the last node of an unpacked edge is the first one of the next
+            if (!unpacked_nodes.empty())
+            {
+                unpacked_nodes.pop_back();
+            }
+            super::UnpackEdge(via_path.packed_path[i - 1], via_path.packed_path[i], unpacked_nodes);
+        }
+        for (std::size_t i = 1; i < unpacked_nodes.size(); ++i)
+        {
+            via_path.unpacked_edges.emplace_back(unpacked_nodes[i - 1], unpacked_nodes[i]);
+        }
+        std::sort(via_path.unpacked_edges.begin(), via_path.unpacked_edges.end());
+    }
+
+    // length of the edges of a via path that are part of the other one as well
+    int ComputeSharingOfViaPaths(const ViaPath &via_path, const ViaPath &other_via_path) const
+    {
+        int sharing = 0;
+        for (const SearchSpaceEdge &edge : via_path.unpacked_edges)
+        {
+            if (std::binary_search(
+                    other_via_path.unpacked_edges.begin(), other_via_path.unpacked_edges.end(), edge))
+            {
+                const EdgeID edge_id = facade->FindEdgeInEitherDirection(edge.first, edge.second);
+                sharing += facade->GetEdgeData(edge_id).distance;
+            }
+        }
+        return sharing;
+    }
+
     // unpack alternate <s,..,v,..,t> by exploring search spaces from v
     inline void RetrievePackedAlternatePath(const QueryHeap &forward_heap1,
                                             const QueryHeap &reverse_heap1,
@@ -394,17 +545,19 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
     // compute and unpack <s,..,v> and <v,..,t> by exploring search spaces
     // from v and intersecting against queues. only half-searches have to be
     // done at this stage
-    inline void ComputeLengthAndSharingOfViaPath(const NodeID via_node,
+    inline void ComputeLengthAndSharingOfViaPath(const QueryHeap &existing_forward_heap,
+                                                 const QueryHeap &existing_reverse_heap,
+                                                 SearchEngineData &engine_working_data,
+                                                 const NodeID via_node,
                                                  int *real_length_of_via_path,
                                                  int *sharing_of_via_path,
                                                  const std::vector<NodeID> &packed_shortest_path,
-                                                 const EdgeWeight min_edge_offset)
+                                                 const EdgeWeight min_edge_offset,
+                                                 QueryDeadline &deadline)
     {
-        engine_working_data.InitializeOrClearSecondThreadLocalStorage(
+        engine_working_data.InitializeOrClearSecondHeaps(
             super::facade->GetNumberOfNodes());
 
-        QueryHeap &existing_forward_heap = *engine_working_data.forwardHeap;
-        QueryHeap &existing_reverse_heap = *engine_working_data.backwardHeap;
         QueryHeap &new_forward_heap = *engine_working_data.forwardHeap2;
         QueryHeap &new_reverse_heap = *engine_working_data.backwardHeap2;
 
@@ -418,7 +571,7 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
         int upper_bound_s_v_path_length = INVALID_EDGE_WEIGHT;
         new_reverse_heap.Insert(via_node, 0, via_node);
         // compute path <s,..,v> by reusing forward search from s
-        while (!new_reverse_heap.Empty())
+        while (!new_reverse_heap.Empty() && !deadline.IsExpired())
         {
             super::RoutingStep(new_reverse_heap,
                                existing_forward_heap,
@@ -431,7 +584,7 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
         NodeID v_t_middle = SPECIAL_NODEID;
         int upper_bound_of_v_t_path_length = INVALID_EDGE_WEIGHT;
         new_forward_heap.Insert(via_node, 0, via_node);
-        while (!new_forward_heap.Empty())
+        while (!new_forward_heap.Empty() && !deadline.IsExpired())
         {
             super::RoutingStep(new_forward_heap,
                                existing_reverse_heap,
@@ -442,7 +595,7 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
         }
         *real_length_of_via_path = upper_bound_s_v_path_length + upper_bound_of_v_t_path_length;
 
-        if (SPECIAL_NODEID == s_v_middle || SPECIAL_NODEID == v_t_middle)
+        if (deadline.WasExpired() || SPECIAL_NODEID == s_v_middle || SPECIAL_NODEID == v_t_middle)
         {
             return;
         }
@@ -674,8 +827,9 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
     }
 
     // conduct T-Test
-    inline bool ViaNodeCandidatePassesTTest(QueryHeap &existing_forward_heap,
-                                            QueryHeap &existing_reverse_heap,
+    inline bool ViaNodeCandidatePassesTTest(SearchEngineData &engine_working_data,
+                                            const QueryHeap &existing_forward_heap,
+                                            const QueryHeap &existing_reverse_heap,
                                             QueryHeap &new_forward_heap,
                                             QueryHeap &new_reverse_heap,
                                             const RankedCandidateNode &candidate,
@@ -683,7 +837,8 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
                                             int *length_of_via_path,
                                             NodeID *s_v_middle,
                                             NodeID *v_t_middle,
-                                            const EdgeWeight min_edge_offset) const
+                                            const EdgeWeight min_edge_offset,
+                                            QueryDeadline &deadline) const
     {
         new_forward_heap.Clear();
         new_reverse_heap.Clear();
@@ -694,7 +849,7 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
         int upper_bound_s_v_path_length = INVALID_EDGE_WEIGHT;
         // compute path <s,..,v> by reusing forward search from s
         new_reverse_heap.Insert(candidate.node, 0, candidate.node);
-        while (new_reverse_heap.Size() > 0)
+        while (new_reverse_heap.Size() > 0 && !deadline.IsExpired())
         {
             super::RoutingStep(new_reverse_heap,
                                existing_forward_heap,
@@ -704,7 +859,7 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
                                false);
         }
 
-        if (INVALID_EDGE_WEIGHT == upper_bound_s_v_path_length)
+        if (deadline.WasExpired() || INVALID_EDGE_WEIGHT == upper_bound_s_v_path_length)
         {
             return false;
         }
@@ -713,7 +868,7 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
         *v_t_middle = SPECIAL_NODEID;
         int upper_bound_of_v_t_path_length = INVALID_EDGE_WEIGHT;
         new_forward_heap.Insert(candidate.node, 0, candidate.node);
-        while (new_forward_heap.Size() > 0)
+        while (new_forward_heap.Size() > 0 && !deadline.IsExpired())
         {
             super::RoutingStep(new_forward_heap,
                                existing_reverse_heap,
@@ -723,7 +878,7 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
                                true);
         }
 
-        if (INVALID_EDGE_WEIGHT == upper_bound_of_v_t_path_length)
+        if (deadline.WasExpired() || INVALID_EDGE_WEIGHT == upper_bound_of_v_t_path_length)
         {
             return false;
         }
@@ -873,7 +1028,7 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
 
         t_test_path_length += unpacked_until_distance;
         // Run actual T-Test query and compare if distances equal.
-        engine_working_data.InitializeOrClearThirdThreadLocalStorage(
+        engine_working_data.InitializeOrClearThirdHeaps(
             super::facade->GetNumberOfNodes());
 
         QueryHeap &forward_heap3 = *engine_working_data.forwardHeap3;
@@ -884,7 +1039,7 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
         forward_heap3.Insert(s_P, 0, s_P);
         reverse_heap3.Insert(t_P, 0, t_P);
         // exploration from s and t until deletemin/(1+epsilon) > _lengt_oO_sShortest_path
-        while ((forward_heap3.Size() + reverse_heap3.Size()) > 0)
+        while ((forward_heap3.Size() + reverse_heap3.Size()) > 0 && !deadline.IsExpired())
         {
             if (!forward_heap3.Empty())
             {
@@ -897,7 +1052,7 @@ template <class DataFacadeT> class AlternativeRouting final : private BasicRouti
                     reverse_heap3, forward_heap3, &middle, &upper_bound, min_edge_offset, false);
             }
         }
-        return (upper_bound <= t_test_path_length);
+        return !deadline.WasExpired() && (upper_bound <= t_test_path_length);
     }
 };
 
@@ -37,13 +37,6 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <stack>
 
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::forwardHeap;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::backwardHeap;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::forwardHeap2;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::backwardHeap2;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::forwardHeap3;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::backwardHeap3;
-
 template <class DataFacadeT> class BasicRoutingInterface
 {
   private:
@@ -58,8 +51,9 @@ template <class DataFacadeT> class BasicRoutingInterface
     explicit BasicRoutingInterface(DataFacadeT *facade) : facade(facade) {}
     virtual ~BasicRoutingInterface() {};
 
-    inline void RoutingStep(SearchEngineData::QueryHeap &forward_heap,
-                            SearchEngineData::QueryHeap &reverse_heap,
+    template <class QueryHeapT>
+    inline void RoutingStep(QueryHeapT &forward_heap,
+                            const QueryHeapT &reverse_heap,
                             NodeID *middle_node_id,
                             int *upper_bound,
                             const int min_edge_offset,
@@ -68,6 +62,12 @@ template <class DataFacadeT> class BasicRoutingInterface
         const NodeID node = forward_heap.DeleteMin();
         const int distance = forward_heap.GetKey(node);
 
+        // the next node of this direction is settled after a step of the other one
+        if (!forward_heap.Empty())
+        {
+            facade->PrefetchEdges(forward_heap.Min());
+        }
+
         // const NodeID parentnode = forward_heap.GetData(node).parent;
         // SimpleLogger().Write() << (forward_direction ? "[fwd] " : "[rev] ") << "settled edge (" << parentnode << "," << node << "), dist: " << distance;
 
@@ -133,6 +133,7 @@ template <class DataFacadeT> class BasicRoutingInterface
                 if (!forward_heap.WasInserted(to))
                 {
                     forward_heap.Insert(to, to_distance, node);
+                    facade->PrefetchNode(to);
                 }
                 // Found a shorter Path -> Update distance
                 else if (to_distance < forward_heap.GetKey(to))
@@ -241,8 +242,11 @@ template <class DataFacadeT> class BasicRoutingInterface
                 else
                 {
                     std::vector<unsigned> id_vector;
-                    facade->GetUncompressedGeometry(facade->GetGeometryIndexForEdgeID(ed.id),
-                                                    id_vector);
+                    std::vector<SimplificationRank> rank_vector;
+                    const unsigned geometry_index = facade->GetGeometryIndexForEdgeID(ed.id);
+                    facade->GetUncompressedGeometry(geometry_index, id_vector);
+                    facade->GetUncompressedGeometryRanks(geometry_index, rank_vector);
+                    BOOST_ASSERT(id_vector.size() == rank_vector.size());
 
                     const std::size_t start_index =
                         (unpacked_path.empty()
@@ -257,7 +261,12 @@ template <class DataFacadeT> class BasicRoutingInterface
                     BOOST_ASSERT(start_index <= end_index);
                     for (std::size_t i = start_index; i < end_index; ++i)
                     {
-                        unpacked_path.emplace_back(id_vector[i], name_index, TurnInstruction::NoTurn, 0, travel_mode);
+                        unpacked_path.emplace_back(id_vector[i],
+                                                   name_index,
+                                                   TurnInstruction::NoTurn,
+                                                   0,
+                                                   travel_mode,
+                                                   rank_vector[i]);
                     }
                     unpacked_path.back().turn_instruction = turn_instruction;
                     unpacked_path.back().segment_duration = ed.distance;
@@ -267,8 +276,12 @@ template <class DataFacadeT> class BasicRoutingInterface
         if (SPECIAL_EDGEID != phantom_node_pair.target_phantom.packed_geometry_id)
         {
             std::vector<unsigned> id_vector;
+            std::vector<SimplificationRank> rank_vector;
             facade->GetUncompressedGeometry(phantom_node_pair.target_phantom.packed_geometry_id,
                                             id_vector);
+            facade->GetUncompressedGeometryRanks(
+                phantom_node_pair.target_phantom.packed_geometry_id, rank_vector);
+            BOOST_ASSERT(id_vector.size() == rank_vector.size());
             const bool is_local_path = (phantom_node_pair.source_phantom.packed_geometry_id ==
                                         phantom_node_pair.target_phantom.packed_geometry_id) &&
                                        unpacked_path.empty();
@@ -288,6 +301,7 @@ template <class DataFacadeT> class BasicRoutingInterface
             if (target_traversed_in_reverse)
             {
                 std::reverse(id_vector.begin(), id_vector.end());
+                std::reverse(rank_vector.begin(), rank_vector.end());
                 end_index =
                     id_vector.size() - phantom_node_pair.target_phantom.fwd_segment_position;
             }
@@ -305,7 +319,8 @@ template <class DataFacadeT> class BasicRoutingInterface
                                                     phantom_node_pair.target_phantom.name_id,
                                                     TurnInstruction::NoTurn,
                                                     0,
-                                                    phantom_node_pair.target_phantom.forward_travel_mode});
+                                                    phantom_node_pair.target_phantom.forward_travel_mode,
+                                                    rank_vector[i]});
             }
         }
 
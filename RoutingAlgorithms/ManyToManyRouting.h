@@ -29,6 +29,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define MANY_TO_MANY_ROUTING_H
 
 #include "BasicRoutingInterface.h"
+#include "../DataStructures/QueryContextPool.h"
+#include "../DataStructures/QueryDeadline.h"
 #include "../DataStructures/SearchEngineData.h"
 #include "../typedefs.h"
 
@@ -43,36 +45,67 @@ template <class DataFacadeT> class ManyToManyRouting final : public BasicRouting
 {
     using super = BasicRoutingInterface<DataFacadeT>;
     using QueryHeap = SearchEngineData::QueryHeap;
-    SearchEngineData &engine_working_data;
+    QueryContextPool &query_contexts;
 
     struct NodeBucket
     {
         unsigned target_id; // essentially a row in the distance matrix
         EdgeWeight distance;
-        NodeBucket(const unsigned target_id, const EdgeWeight distance)
-            : target_id(target_id), distance(distance)
+        EdgeWeight length;
+        NodeBucket(const unsigned target_id, const EdgeWeight distance, const EdgeWeight length)
+            : target_id(target_id), distance(distance), length(length)
         {
         }
     };
     using SearchSpaceWithBuckets = std::unordered_map<NodeID, std::vector<NodeBucket>>;
 
   public:
-    ManyToManyRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
-        : super(facade), engine_working_data(engine_working_data)
+    ManyToManyRouting(DataFacadeT *facade, QueryContextPool &query_contexts)
+        : super(facade), query_contexts(query_contexts)
     {
     }
 
     ~ManyToManyRouting() {}
 
-    std::shared_ptr<std::vector<EdgeWeight>> operator()(const PhantomNodeArray &phantom_nodes_array)
-        const
+    // square table of all locations against each other
+    std::shared_ptr<std::vector<EdgeWeight>> operator()(const PhantomNodeArray &phantom_nodes_array,
+                                                        QueryDeadline &deadline,
+                                                        std::vector<EdgeWeight> *length_table =
+                                                            nullptr) const
+    {
+        return operator()(phantom_nodes_array, phantom_nodes_array, deadline, length_table);
+    }
+
+    // row-major table with a row per source and a column per target. A backward search runs
+    // from every target and a forward search from every source. Returns nullptr if the deadline
+    // expires during the search. If length_table is given, it receives the length in decimeters
+    // of each of the fastest paths, summed up from the lengths stored with the (shortcut) edges
+    // of the search spaces.
+    std::shared_ptr<std::vector<EdgeWeight>> operator()(const PhantomNodeArray &source_nodes_array,
+                                                        const PhantomNodeArray &target_nodes_array,
+                                                        QueryDeadline &deadline,
+                                                        std::vector<EdgeWeight> *length_table =
+                                                            nullptr) const
     {
-        const unsigned number_of_locations = static_cast<unsigned>(phantom_nodes_array.size());
+        const unsigned number_of_sources = static_cast<unsigned>(source_nodes_array.size());
+        const unsigned number_of_targets = static_cast<unsigned>(target_nodes_array.size());
         std::shared_ptr<std::vector<EdgeWeight>> result_table =
-            std::make_shared<std::vector<EdgeWeight>>(number_of_locations * number_of_locations,
+            std::make_shared<std::vector<EdgeWeight>>(number_of_sources * number_of_targets,
                                                       std::numeric_limits<EdgeWeight>::max());
+        // lengths of the paths in the heap, indexed by insertion index
+        std::vector<EdgeWeight> path_lengths;
+        std::vector<EdgeWeight> *query_lengths = nullptr;
+        if (nullptr != length_table)
+        {
+            length_table->assign(number_of_sources * number_of_targets,
+                                 std::numeric_limits<EdgeWeight>::max());
+            query_lengths = &path_lengths;
+        }
 
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
+        // heaps of this query, handed back to the pool when it returns
+        const QueryContextPool::Handle query_context = query_contexts.Acquire();
+        SearchEngineData &engine_working_data = *query_context;
+        engine_working_data.InitializeOrClearFirstHeaps(
             super::facade->GetNumberOfNodes());
 
         QueryHeap &query_heap = *(engine_working_data.forwardHeap);
@@ -80,81 +113,107 @@ template <class DataFacadeT> class ManyToManyRouting final : public BasicRouting
         SearchSpaceWithBuckets search_space_with_buckets;
 
         unsigned target_id = 0;
-        for (const std::vector<PhantomNode> &phantom_node_vector : phantom_nodes_array)
+        for (const std::vector<PhantomNode> &phantom_node_vector : target_nodes_array)
         {
             query_heap.Clear();
+            path_lengths.clear();
             // insert target(s) at distance 0
 
             for (const PhantomNode &phantom_node : phantom_node_vector)
             {
                 if (SPECIAL_NODEID != phantom_node.forward_node_id)
                 {
-                    query_heap.Insert(phantom_node.forward_node_id,
-                                      phantom_node.GetForwardWeightPlusOffset(),
-                                      phantom_node.forward_node_id);
+                    InsertNode(phantom_node.forward_node_id,
+                               phantom_node.GetForwardWeightPlusOffset(),
+                               phantom_node.forward_length,
+                               phantom_node.forward_node_id,
+                               query_heap,
+                               query_lengths);
                 }
                 if (SPECIAL_NODEID != phantom_node.reverse_node_id)
                 {
-                    query_heap.Insert(phantom_node.reverse_node_id,
-                                      phantom_node.GetReverseWeightPlusOffset(),
-                                      phantom_node.reverse_node_id);
+                    InsertNode(phantom_node.reverse_node_id,
+                               phantom_node.GetReverseWeightPlusOffset(),
+                               phantom_node.reverse_length,
+                               phantom_node.reverse_node_id,
+                               query_heap,
+                               query_lengths);
                 }
             }
 
             // explore search space
             while (!query_heap.Empty())
             {
-                BackwardRoutingStep(target_id, query_heap, search_space_with_buckets);
+                if (deadline.IsExpired())
+                {
+                    return nullptr;
+                }
+                BackwardRoutingStep(target_id, query_heap, query_lengths, search_space_with_buckets);
             }
             ++target_id;
         }
 
         // for each source do forward search
         unsigned source_id = 0;
-        for (const std::vector<PhantomNode> &phantom_node_vector : phantom_nodes_array)
+        for (const std::vector<PhantomNode> &phantom_node_vector : source_nodes_array)
         {
             query_heap.Clear();
+            path_lengths.clear();
             for (const PhantomNode &phantom_node : phantom_node_vector)
             {
                 // insert sources at distance 0
                 if (SPECIAL_NODEID != phantom_node.forward_node_id)
                 {
-                    query_heap.Insert(phantom_node.forward_node_id,
-                                      -phantom_node.GetForwardWeightPlusOffset(),
-                                      phantom_node.forward_node_id);
+                    InsertNode(phantom_node.forward_node_id,
+                               -phantom_node.GetForwardWeightPlusOffset(),
+                               -phantom_node.forward_length,
+                               phantom_node.forward_node_id,
+                               query_heap,
+                               query_lengths);
                 }
                 if (SPECIAL_NODEID != phantom_node.reverse_node_id)
                 {
-                    query_heap.Insert(phantom_node.reverse_node_id,
-                                      -phantom_node.GetReverseWeightPlusOffset(),
-                                      phantom_node.reverse_node_id);
+                    InsertNode(phantom_node.reverse_node_id,
+                               -phantom_node.GetReverseWeightPlusOffset(),
+                               -phantom_node.reverse_length,
+                               phantom_node.reverse_node_id,
+                               query_heap,
+                               query_lengths);
                 }
             }
 
             // explore search space
             while (!query_heap.Empty())
             {
+                if (deadline.IsExpired())
+                {
+                    return nullptr;
+                }
                 ForwardRoutingStep(source_id,
-                                   number_of_locations,
+                                   number_of_targets,
                                    query_heap,
+                                   query_lengths,
                                    search_space_with_buckets,
-                                   result_table);
+                                   result_table,
+                                   length_table);
             }
 
             ++source_id;
         }
-        BOOST_ASSERT(source_id == target_id);
         return result_table;
     }
 
     void ForwardRoutingStep(const unsigned source_id,
-                            const unsigned number_of_locations,
+                            const unsigned number_of_targets,
                             QueryHeap &query_heap,
+                            std::vector<EdgeWeight> *query_lengths,
                             const SearchSpaceWithBuckets &search_space_with_buckets,
-                            std::shared_ptr<std::vector<EdgeWeight>> result_table) const
+                            std::shared_ptr<std::vector<EdgeWeight>> result_table,
+                            std::vector<EdgeWeight> *length_table) const
     {
         const NodeID node = query_heap.DeleteMin();
         const int source_distance = query_heap.GetKey(node);
+        const EdgeWeight source_length = GetLength(node, query_heap, query_lengths);
 
         // check if each encountered node has an entry
         const auto bucket_iterator = search_space_with_buckets.find(node);
@@ -168,13 +227,18 @@ template <class DataFacadeT> class ManyToManyRouting final : public BasicRouting
                 const unsigned target_id = current_bucket.target_id;
                 const int target_distance = current_bucket.distance;
                 const EdgeWeight current_distance =
-                    (*result_table)[source_id * number_of_locations + target_id];
+                    (*result_table)[source_id * number_of_targets + target_id];
                 // check if new distance is better
                 const EdgeWeight new_distance = source_distance + target_distance;
                 if (new_distance >= 0 && new_distance < current_distance)
                 {
-                    (*result_table)[source_id * number_of_locations + target_id] =
+                    (*result_table)[source_id * number_of_targets + target_id] =
                         (source_distance + target_distance);
+                    if (nullptr != length_table)
+                    {
+                        (*length_table)[source_id * number_of_targets + target_id] =
+                            source_length + current_bucket.length;
+                    }
                 }
             }
         }
@@ -182,30 +246,62 @@ template <class DataFacadeT> class ManyToManyRouting final : public BasicRouting
         {
             return;
         }
-        RelaxOutgoingEdges<true>(node, source_distance, query_heap);
+        RelaxOutgoingEdges<true>(node, source_distance, source_length, query_heap, query_lengths);
     }
 
     void BackwardRoutingStep(const unsigned target_id,
                              QueryHeap &query_heap,
+                             std::vector<EdgeWeight> *query_lengths,
                              SearchSpaceWithBuckets &search_space_with_buckets) const
     {
         const NodeID node = query_heap.DeleteMin();
         const int target_distance = query_heap.GetKey(node);
+        const EdgeWeight target_length = GetLength(node, query_heap, query_lengths);
 
         // store settled nodes in search space bucket
-        search_space_with_buckets[node].emplace_back(target_id, target_distance);
+        search_space_with_buckets[node].emplace_back(target_id, target_distance, target_length);
 
         if (StallAtNode<false>(node, target_distance, query_heap))
         {
             return;
         }
 
-        RelaxOutgoingEdges<false>(node, target_distance, query_heap);
+        RelaxOutgoingEdges<false>(node, target_distance, target_length, query_heap, query_lengths);
+    }
+
+    // lengths are only tracked if query_lengths is set, parallel to the insertion order of the heap
+    inline void InsertNode(const NodeID node,
+                           const EdgeWeight distance,
+                           const EdgeWeight length,
+                           const NodeID parent,
+                           QueryHeap &query_heap,
+                           std::vector<EdgeWeight> *query_lengths) const
+    {
+        query_heap.Insert(node, distance, parent);
+        if (nullptr != query_lengths)
+        {
+            BOOST_ASSERT(query_lengths->size() == query_heap.GetInsertionIndex(node));
+            query_lengths->push_back(length);
+        }
+    }
+
+    inline EdgeWeight GetLength(const NodeID node,
+                                const QueryHeap &query_heap,
+                                const std::vector<EdgeWeight> *query_lengths) const
+    {
+        if (nullptr == query_lengths)
+        {
+            return 0;
+        }
+        return (*query_lengths)[query_heap.GetInsertionIndex(node)];
     }
 
     template <bool forward_direction>
-    inline void
-    RelaxOutgoingEdges(const NodeID node, const EdgeWeight distance, QueryHeap &query_heap) const
+    inline void RelaxOutgoingEdges(const NodeID node,
+                                   const EdgeWeight distance,
+                                   const EdgeWeight length,
+                                   QueryHeap &query_heap,
+                                   std::vector<EdgeWeight> *query_lengths) const
     {
         for (auto edge : super::facade->GetAdjacentEdgeRange(node))
         {
@@ -222,7 +318,7 @@ template <class DataFacadeT> class ManyToManyRouting final : public BasicRouting
                 // New Node discovered -> Add to Heap + Node Info Storage
                 if (!query_heap.WasInserted(to))
                 {
-                    query_heap.Insert(to, to_distance, node);
+                    InsertNode(to, to_distance, length + data.length, node, query_heap, query_lengths);
                 }
                 // Found a shorter Path -> Update distance
                 else if (to_distance < query_heap.GetKey(to))
@@ -230,6 +326,10 @@ template <class DataFacadeT> class ManyToManyRouting final : public BasicRouting
                     // new parent
                     query_heap.GetData(to).parent = node;
                     query_heap.DecreaseKey(to, to_distance);
+                    if (nullptr != query_lengths)
+                    {
+                        (*query_lengths)[query_heap.GetInsertionIndex(to)] = length + data.length;
+                    }
                 }
             }
         }
@@ -32,41 +32,232 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "BasicRoutingInterface.h"
 #include "../DataStructures/Range.h"
+#include "../DataStructures/QueryContextPool.h"
+#include "../DataStructures/QueryDeadline.h"
 #include "../DataStructures/SearchEngineData.h"
 #include "../typedefs.h"
 
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
 template <class DataFacadeT> class ShortestPathRouting final : public BasicRoutingInterface<DataFacadeT>
 {
     using super = BasicRoutingInterface<DataFacadeT>;
     using QueryHeap = SearchEngineData::QueryHeap;
-    SearchEngineData &engine_working_data;
+    QueryContextPool &query_contexts;
+    const bool parallel_legs;
+
+    // packed paths of consecutive legs, starting at either segment of the first source
+    struct PackedLegs
+    {
+        enum CopyType
+        { NoCopy,
+          CopiedLegs2To1,
+          CopiedLegs1To2 };
+
+        PackedLegs() : distance1(0), distance2(0), is_found(false), first_copy(NoCopy) {}
+
+        std::vector<std::vector<NodeID>> packed_legs1;
+        std::vector<std::vector<NodeID>> packed_legs2;
+        int distance1;
+        int distance2;
+        bool is_found;
+        // first time that one set of legs replaced the other one, which also replaces the
+        // legs that were computed before these
+        CopyType first_copy;
+    };
 
   public:
-    ShortestPathRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
-        : super(facade), engine_working_data(engine_working_data)
+    // the legs after a via point with u-turns are searched in parallel if parallel_legs is set.
+    // They run on the global TBB pool, which the compute lanes of the server do not bound.
+    ShortestPathRouting(DataFacadeT *facade,
+                        QueryContextPool &query_contexts,
+                        const bool parallel_legs = false)
+        : super(facade), query_contexts(query_contexts), parallel_legs(parallel_legs)
     {
     }
 
     ~ShortestPathRouting() {}
 
+    // no route is returned if the deadline expires during the search
     void operator()(const std::vector<PhantomNodes> &phantom_nodes_vector,
                     const std::vector<bool> &uturn_indicators,
-                    RawRouteData &raw_route_data) const
+                    RawRouteData &raw_route_data,
+                    QueryDeadline &deadline) const
     {
+        // A leg that may start with a u-turn does not depend on the legs before it. Such runs
+        // of legs are searched in parallel, each with heaps of its own.
+        std::vector<std::size_t> run_begins(1, 0);
+        for (std::size_t leg = 1; leg < phantom_nodes_vector.size(); ++leg)
+        {
+            if (IsUTurnAllowed(uturn_indicators, leg))
+            {
+                run_begins.emplace_back(leg);
+            }
+        }
+        run_begins.emplace_back(phantom_nodes_vector.size());
+        const std::size_t number_of_runs = run_begins.size() - 1;
+
+        std::vector<PackedLegs> runs(number_of_runs);
+        if (parallel_legs && 1 < number_of_runs)
+        {
+            std::vector<QueryDeadline> run_deadlines(number_of_runs, deadline);
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_runs),
+                              [&](const tbb::blocked_range<std::size_t> &range)
+                              {
+                for (std::size_t run = range.begin(); run != range.end(); ++run)
+                {
+                    SearchLegs(phantom_nodes_vector,
+                               uturn_indicators,
+                               run_begins[run],
+                               run_begins[run + 1],
+                               run_deadlines[run],
+                               runs[run]);
+                }
+            });
+            for (const QueryDeadline &run_deadline : run_deadlines)
+            {
+                if (run_deadline.WasExpired())
+                {
+                    deadline = run_deadline;
+                }
+            }
+        }
+        else
+        {
+            for (const std::size_t run : osrm::irange<std::size_t>(0, number_of_runs))
+            {
+                SearchLegs(phantom_nodes_vector,
+                           uturn_indicators,
+                           run_begins[run],
+                           run_begins[run + 1],
+                           deadline,
+                           runs[run]);
+                if (!runs[run].is_found)
+                {
+                    break;
+                }
+            }
+        }
+
+        // stitch the runs together as if their legs had been searched one after another
+        std::vector<std::vector<NodeID>> packed_legs1;
+        std::vector<std::vector<NodeID>> packed_legs2;
+        packed_legs1.reserve(phantom_nodes_vector.size());
+        packed_legs2.reserve(phantom_nodes_vector.size());
+        for (PackedLegs &run : runs)
+        {
+            // No path found for one of the legs, or the search was aborted?
+            if (!run.is_found)
+            {
+                raw_route_data.shortest_path_length = INVALID_EDGE_WEIGHT;
+                return;
+            }
+            if (PackedLegs::CopiedLegs2To1 == run.first_copy)
+            {
+                packed_legs1 = packed_legs2;
+            }
+            else if (PackedLegs::CopiedLegs1To2 == run.first_copy)
+            {
+                packed_legs2 = packed_legs1;
+            }
+            std::move(run.packed_legs1.begin(), run.packed_legs1.end(),
+                      std::back_inserter(packed_legs1));
+            std::move(run.packed_legs2.begin(), run.packed_legs2.end(),
+                      std::back_inserter(packed_legs2));
+        }
+        const int distance1 = runs.back().distance1;
+        const int distance2 = runs.back().distance2;
+
+        if (distance1 > distance2)
+        {
+            std::swap(packed_legs1, packed_legs2);
+        }
+        raw_route_data.unpacked_path_segments.resize(packed_legs1.size());
+
+        // the legs are unpacked independently of each other
+        const auto unpack_leg = [&](const std::size_t index)
+        {
+            BOOST_ASSERT(!phantom_nodes_vector.empty());
+            BOOST_ASSERT(packed_legs1.size() == raw_route_data.unpacked_path_segments.size());
+
+            PhantomNodes unpack_phantom_node_pair = phantom_nodes_vector[index];
+            super::UnpackPath(
+                // -- packed input
+                packed_legs1[index],
+                // -- start and end of (sub-)route
+                unpack_phantom_node_pair,
+                // -- unpacked output
+                raw_route_data.unpacked_path_segments[index]);
+        };
+        if (parallel_legs && 1 < packed_legs1.size())
+        {
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, packed_legs1.size()),
+                              [&](const tbb::blocked_range<std::size_t> &range)
+                              {
+                for (std::size_t index = range.begin(); index != range.end(); ++index)
+                {
+                    unpack_leg(index);
+                }
+            });
+        }
+        else
+        {
+            for (const std::size_t index : osrm::irange<std::size_t>(0, packed_legs1.size()))
+            {
+                unpack_leg(index);
+            }
+        }
+
+        for (const std::size_t index : osrm::irange<std::size_t>(0, packed_legs1.size()))
+        {
+            raw_route_data.source_traversed_in_reverse.push_back(
+            (packed_legs1[index].front() != phantom_nodes_vector[index].source_phantom.forward_node_id));
+            raw_route_data.target_traversed_in_reverse.push_back(
+            (packed_legs1[index].back() != phantom_nodes_vector[index].target_phantom.forward_node_id));
+        }
+        raw_route_data.shortest_path_length = std::min(distance1, distance2);
+    }
+
+  private:
+    static bool IsUTurnAllowed(const std::vector<bool> &uturn_indicators, const std::size_t leg)
+    {
+        return leg > 0 && uturn_indicators.size() > leg && uturn_indicators[leg - 1];
+    }
+
+    // searches the legs [first_leg, end_leg), the first leg either is the first leg of the
+    // route or may start with a u-turn
+    void SearchLegs(const std::vector<PhantomNodes> &phantom_nodes_vector,
+                    const std::vector<bool> &uturn_indicators,
+                    const std::size_t first_leg,
+                    const std::size_t end_leg,
+                    QueryDeadline &deadline,
+                    PackedLegs &result) const
+    {
+        BOOST_ASSERT(0 == first_leg || IsUTurnAllowed(uturn_indicators, first_leg));
         int distance1 = 0;
         int distance2 = 0;
         bool search_from_1st_node = true;
         bool search_from_2nd_node = true;
         NodeID middle1 = SPECIAL_NODEID;
         NodeID middle2 = SPECIAL_NODEID;
-        std::vector<std::vector<NodeID>> packed_legs1(phantom_nodes_vector.size());
-        std::vector<std::vector<NodeID>> packed_legs2(phantom_nodes_vector.size());
-
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
+        std::vector<std::vector<NodeID>> &packed_legs1 = result.packed_legs1;
+        std::vector<std::vector<NodeID>> &packed_legs2 = result.packed_legs2;
+        packed_legs1.resize(end_leg - first_leg);
+        packed_legs2.resize(end_leg - first_leg);
+
+        // heaps of this query, handed back to the pool when it returns
+        const QueryContextPool::Handle query_context = query_contexts.Acquire();
+        SearchEngineData &engine_working_data = *query_context;
+        engine_working_data.InitializeOrClearFirstHeaps(
             super::facade->GetNumberOfNodes());
-        engine_working_data.InitializeOrClearSecondThreadLocalStorage(
+        engine_working_data.InitializeOrClearSecondHeaps(
             super::facade->GetNumberOfNodes());
-        engine_working_data.InitializeOrClearThirdThreadLocalStorage(
+        engine_working_data.InitializeOrClearThirdHeaps(
             super::facade->GetNumberOfNodes());
 
         QueryHeap &forward_heap1 = *(engine_working_data.forwardHeap);
@@ -74,10 +265,12 @@ template <class DataFacadeT> class ShortestPathRouting final : public BasicRouti
         QueryHeap &forward_heap2 = *(engine_working_data.forwardHeap2);
         QueryHeap &reverse_heap2 = *(engine_working_data.backwardHeap2);
 
-        std::size_t current_leg = 0;
         // Get distance to next pair of target nodes.
-        for (const PhantomNodes &phantom_node_pair : phantom_nodes_vector)
+        for (std::size_t current_leg = first_leg; current_leg < end_leg; ++current_leg)
         {
+            const PhantomNodes &phantom_node_pair = phantom_nodes_vector[current_leg];
+            // index of the leg in this run
+            const std::size_t run_leg = current_leg - first_leg;
             forward_heap1.Clear();
             forward_heap2.Clear();
             reverse_heap1.Clear();
@@ -88,7 +281,7 @@ template <class DataFacadeT> class ShortestPathRouting final : public BasicRouti
             middle1 = SPECIAL_NODEID;
             middle2 = SPECIAL_NODEID;
 
-            const bool allow_u_turn = current_leg > 0 && uturn_indicators.size() > current_leg && uturn_indicators[current_leg-1];
+            const bool allow_u_turn = IsUTurnAllowed(uturn_indicators, current_leg);
             EdgeWeight min_edge_offset = 0;
 
             // insert new starting nodes into forward heap, adjusted by previous distances.
@@ -148,7 +341,7 @@ template <class DataFacadeT> class ShortestPathRouting final : public BasicRouti
             }
 
             // run two-Target Dijkstra routing step.
-            while (0 < (forward_heap1.Size() + reverse_heap1.Size()))
+            while (0 < (forward_heap1.Size() + reverse_heap1.Size()) && !deadline.IsExpired())
             {
                 if (!forward_heap1.Empty())
                 {
@@ -164,7 +357,7 @@ template <class DataFacadeT> class ShortestPathRouting final : public BasicRouti
 
             if (!reverse_heap2.Empty())
             {
-                while (0 < (forward_heap2.Size() + reverse_heap2.Size()))
+                while (0 < (forward_heap2.Size() + reverse_heap2.Size()) && !deadline.IsExpired())
                 {
                     if (!forward_heap2.Empty())
                     {
@@ -179,12 +372,10 @@ template <class DataFacadeT> class ShortestPathRouting final : public BasicRouti
                 }
             }
 
-            // No path found for both target nodes?
-            if ((INVALID_EDGE_WEIGHT == local_upper_bound1) &&
-                (INVALID_EDGE_WEIGHT == local_upper_bound2))
+            // No path found for both target nodes, or the search was aborted?
+            if (deadline.WasExpired() || ((INVALID_EDGE_WEIGHT == local_upper_bound1) &&
+                                          (INVALID_EDGE_WEIGHT == local_upper_bound2)))
             {
-                raw_route_data.shortest_path_length = INVALID_EDGE_WEIGHT;
-                raw_route_data.alternative_path_length = INVALID_EDGE_WEIGHT;
                 return;
             }
 
@@ -206,8 +397,8 @@ template <class DataFacadeT> class ShortestPathRouting final : public BasicRouti
             std::vector<NodeID> temporary_packed_leg1;
             std::vector<NodeID> temporary_packed_leg2;
 
-            BOOST_ASSERT((unsigned)current_leg < packed_legs1.size());
-            BOOST_ASSERT((unsigned)current_leg < packed_legs2.size());
+            BOOST_ASSERT(run_leg < packed_legs1.size());
+            BOOST_ASSERT(run_leg < packed_legs2.size());
 
             if (INVALID_EDGE_WEIGHT != local_upper_bound1)
             {
@@ -242,13 +433,13 @@ template <class DataFacadeT> class ShortestPathRouting final : public BasicRouti
             BOOST_ASSERT_MSG(!temporary_packed_leg1.empty() || !temporary_packed_leg2.empty(),
                              "tempory packed paths empty");
 
-            BOOST_ASSERT((0 == current_leg) || !packed_legs1[current_leg - 1].empty());
-            BOOST_ASSERT((0 == current_leg) || !packed_legs2[current_leg - 1].empty());
+            BOOST_ASSERT((0 == run_leg) || !packed_legs1[run_leg - 1].empty());
+            BOOST_ASSERT((0 == run_leg) || !packed_legs2[run_leg - 1].empty());
 
-            if (!allow_u_turn && 0 < current_leg)
+            if (!allow_u_turn && 0 < run_leg)
             {
-                const NodeID end_id_of_segment1 = packed_legs1[current_leg - 1].back();
-                const NodeID end_id_of_segment2 = packed_legs2[current_leg - 1].back();
+                const NodeID end_id_of_segment1 = packed_legs1[run_leg - 1].back();
+                const NodeID end_id_of_segment2 = packed_legs2[run_leg - 1].back();
                 BOOST_ASSERT(!temporary_packed_leg1.empty());
                 const NodeID start_id_of_leg1 = temporary_packed_leg1.front();
                 const NodeID start_id_of_leg2 = temporary_packed_leg2.front();
@@ -262,35 +453,43 @@ template <class DataFacadeT> class ShortestPathRouting final : public BasicRouti
                 // remove the shorter path if both legs end at the same segment
                 if (start_id_of_leg1 == start_id_of_leg2)
                 {
-                    const NodeID last_id_of_packed_legs1 = packed_legs1[current_leg - 1].back();
-                    const NodeID last_id_of_packed_legs2 = packed_legs2[current_leg - 1].back();
+                    const NodeID last_id_of_packed_legs1 = packed_legs1[run_leg - 1].back();
+                    const NodeID last_id_of_packed_legs2 = packed_legs2[run_leg - 1].back();
                     if (start_id_of_leg1 != last_id_of_packed_legs1)
                     {
                         packed_legs1 = packed_legs2;
+                        if (PackedLegs::NoCopy == result.first_copy)
+                        {
+                            result.first_copy = PackedLegs::CopiedLegs2To1;
+                        }
                         BOOST_ASSERT(start_id_of_leg1 == temporary_packed_leg1.front());
                     }
                     else if (start_id_of_leg2 != last_id_of_packed_legs2)
                     {
                         packed_legs2 = packed_legs1;
+                        if (PackedLegs::NoCopy == result.first_copy)
+                        {
+                            result.first_copy = PackedLegs::CopiedLegs1To2;
+                        }
                         BOOST_ASSERT(start_id_of_leg2 == temporary_packed_leg2.front());
                     }
                 }
             }
             BOOST_ASSERT(packed_legs1.size() == packed_legs2.size());
 
-            packed_legs1[current_leg].insert(packed_legs1[current_leg].end(),
-                                             temporary_packed_leg1.begin(),
-                                             temporary_packed_leg1.end());
-            BOOST_ASSERT(packed_legs1[current_leg].size() == temporary_packed_leg1.size());
-            packed_legs2[current_leg].insert(packed_legs2[current_leg].end(),
-                                             temporary_packed_leg2.begin(),
-                                             temporary_packed_leg2.end());
-            BOOST_ASSERT(packed_legs2[current_leg].size() == temporary_packed_leg2.size());
+            packed_legs1[run_leg].insert(packed_legs1[run_leg].end(),
+                                         temporary_packed_leg1.begin(),
+                                         temporary_packed_leg1.end());
+            BOOST_ASSERT(packed_legs1[run_leg].size() == temporary_packed_leg1.size());
+            packed_legs2[run_leg].insert(packed_legs2[run_leg].end(),
+                                         temporary_packed_leg2.begin(),
+                                         temporary_packed_leg2.end());
+            BOOST_ASSERT(packed_legs2[run_leg].size() == temporary_packed_leg2.size());
 
-            if (!allow_u_turn && (packed_legs1[current_leg].back() == packed_legs2[current_leg].back()) &&
+            if (!allow_u_turn && (packed_legs1[run_leg].back() == packed_legs2[run_leg].back()) &&
                 phantom_node_pair.target_phantom.isBidirected())
             {
-                const NodeID last_node_id = packed_legs2[current_leg].back();
+                const NodeID last_node_id = packed_legs2[run_leg].back();
                 search_from_1st_node &=
                     !(last_node_id == phantom_node_pair.target_phantom.reverse_node_id);
                 search_from_2nd_node &=
@@ -300,35 +499,11 @@ template <class DataFacadeT> class ShortestPathRouting final : public BasicRouti
 
             distance1 = local_upper_bound1;
             distance2 = local_upper_bound2;
-            ++current_leg;
         }
 
-        if (distance1 > distance2)
-        {
-            std::swap(packed_legs1, packed_legs2);
-        }
-        raw_route_data.unpacked_path_segments.resize(packed_legs1.size());
-
-        for (const std::size_t index : osrm::irange<std::size_t>(0, packed_legs1.size()))
-        {
-            BOOST_ASSERT(!phantom_nodes_vector.empty());
-            BOOST_ASSERT(packed_legs1.size() == raw_route_data.unpacked_path_segments.size());
-
-            PhantomNodes unpack_phantom_node_pair = phantom_nodes_vector[index];
-            super::UnpackPath(
-                // -- packed input
-                packed_legs1[index],
-                // -- start and end of (sub-)route
-                unpack_phantom_node_pair,
-                // -- unpacked output
-                raw_route_data.unpacked_path_segments[index]);
-
-            raw_route_data.source_traversed_in_reverse.push_back(
-            (packed_legs1[index].front() != phantom_nodes_vector[index].source_phantom.forward_node_id));
-            raw_route_data.target_traversed_in_reverse.push_back(
-            (packed_legs1[index].back() != phantom_nodes_vector[index].target_phantom.forward_node_id));
-        }
-        raw_route_data.shortest_path_length = std::min(distance1, distance2);
+        result.distance1 = distance1;
+        result.distance2 = distance2;
+        result.is_found = true;
     }
 };
 
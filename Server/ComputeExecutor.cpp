@@ -0,0 +1,186 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ComputeExecutor.h"
+
+#include "../Util/make_unique.hpp"
+#include "../Util/simple_logger.hpp"
+#include "../Util/ThreadAffinity.h"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <mutex>
+
+ComputeExecutor::ComputeExecutor(const unsigned number_of_threads,
+                                 const unsigned max_queue_length,
+                                 const std::vector<std::vector<unsigned>> &cpu_sets)
+    : running(true)
+{
+    // the light lane only needs a few workers as its requests are cheap. Each lane has at
+    // least one worker, so there are two even if a single thread is requested.
+    lane_threads.push_back(std::max(1u, number_of_threads / 4));
+    lane_threads.push_back(std::max(1u, number_of_threads - number_of_threads / 4));
+
+    for (unsigned lane = 0; lane < number_of_lanes; ++lane)
+    {
+        lane_queues.emplace_back(osrm::make_unique<ConcurrentQueue<Task>>(max_queue_length));
+        rejected[lane] = 0;
+        logged_rejections[lane] = 0;
+        next_rejection_log[lane] = 0;
+    }
+    for (unsigned lane = 0; lane < number_of_lanes; ++lane)
+    {
+        for (unsigned i = 0; i < lane_threads[lane]; ++i)
+        {
+            const std::vector<unsigned> cpus =
+                cpu_sets.empty() ? std::vector<unsigned>() : cpu_sets[i % cpu_sets.size()];
+            workers.emplace_back([this, lane, cpus]()
+                                 {
+                if (!cpus.empty())
+                {
+                    BindCurrentThreadToCPUs(cpus);
+                }
+                Work(static_cast<Lane>(lane));
+            });
+        }
+    }
+    SimpleLogger().Write() << "compute threads: " << lane_threads[light] << " light, "
+                           << lane_threads[heavy] << " heavy";
+    if (!cpu_sets.empty())
+    {
+        SimpleLogger().Write() << "compute threads bound to " << cpu_sets.size()
+                               << " cpu set(s)";
+    }
+}
+
+ComputeExecutor::~ComputeExecutor()
+{
+    Stop();
+    for (std::thread &worker : workers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+}
+
+bool ComputeExecutor::Post(const Lane lane, const Task &task)
+{
+    BOOST_ASSERT(lane < number_of_lanes);
+    bool queued = false;
+    {
+        // a task queued after the quit tasks of Stop would never run
+        std::lock_guard<std::mutex> lock(running_mutex);
+        queued = running && lane_queues[lane]->try_push(task);
+    }
+    if (!queued)
+    {
+        ++rejected[lane];
+        LogRejections(lane);
+        return false;
+    }
+    return true;
+}
+
+void ComputeExecutor::LogRejections(const Lane lane)
+{
+    // under overload every request is rejected, so only one thread logs per interval
+    const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                            std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t next_log = next_rejection_log[lane].load();
+    if (now < next_log ||
+        !next_rejection_log[lane].compare_exchange_strong(next_log, now + REJECTION_LOG_INTERVAL))
+    {
+        return;
+    }
+    const uint64_t rejected_so_far = rejected[lane].load();
+    const uint64_t rejected_since_last_log =
+        rejected_so_far - logged_rejections[lane].exchange(rejected_so_far);
+    SimpleLogger().Write(logWARNING) << "compute queue " << lane << " full, depth "
+                                     << lane_queues[lane]->size() << ", rejected "
+                                     << rejected_since_last_log << " request(s) since last report";
+}
+
+std::size_t ComputeExecutor::QueueDepth(const Lane lane) { return lane_queues[lane]->size(); }
+
+uint64_t ComputeExecutor::GetRejectedCount(const Lane lane) const { return rejected[lane].load(); }
+
+void ComputeExecutor::Stop()
+{
+    std::lock_guard<std::mutex> lock(running_mutex);
+    if (!running)
+    {
+        return;
+    }
+    running = false;
+    // an empty task tells a worker to quit once the work queued before it is done
+    for (unsigned lane = 0; lane < number_of_lanes; ++lane)
+    {
+        for (unsigned i = 0; i < lane_threads[lane]; ++i)
+        {
+            lane_queues[lane]->push(Task());
+        }
+    }
+}
+
+ComputeExecutor::Lane ComputeExecutor::GetLane(const std::string &uri)
+{
+    const std::string path = uri.substr(0, uri.find('?'));
+    const std::string::size_type last_slash = path.rfind('/');
+    const std::string service =
+        (std::string::npos == last_slash) ? path : path.substr(last_slash + 1);
+    if ("table" == service || "viaroute" == service)
+    {
+        return heavy;
+    }
+    return light;
+}
+
+void ComputeExecutor::Work(const Lane lane)
+{
+    while (true)
+    {
+        Task task;
+        lane_queues[lane]->wait_and_pop(task);
+        if (!task)
+        {
+            return;
+        }
+        try
+        {
+            task();
+        }
+        catch (const std::exception &e)
+        {
+            SimpleLogger().Write(logWARNING) << "[compute] " << e.what();
+        }
+    }
+}
@@ -0,0 +1,97 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef COMPUTE_EXECUTOR_H
+#define COMPUTE_EXECUTOR_H
+
+#include "../DataStructures/ConcurrentQueue.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs parsed requests off the network threads. Cheap services and expensive
+// services are queued in separate lanes, each served by its own workers, so
+// that a burst of large tables does not delay locate/nearest calls.
+class ComputeExecutor
+{
+  public:
+    enum Lane
+    { light = 0,
+      heavy = 1,
+      number_of_lanes = 2 };
+
+    using Task = std::function<void()>;
+
+    // number_of_threads is split among the lanes, a quarter of them serve the light lane.
+    // With cpu_sets, e.g. one per NUMA node, the workers of each lane are spread round-robin
+    // over the sets and may only run on the CPUs of their set
+    ComputeExecutor(const unsigned number_of_threads,
+                    const unsigned max_queue_length,
+                    const std::vector<std::vector<unsigned>> &cpu_sets = {});
+    ComputeExecutor(const ComputeExecutor &) = delete;
+    ~ComputeExecutor();
+
+    // returns false if the lane's queue is full, the task is not run then. Rejections are
+    // counted and logged at most once per REJECTION_LOG_INTERVAL seconds and lane.
+    bool Post(const Lane lane, const Task &task);
+
+    std::size_t QueueDepth(const Lane lane);
+
+    uint64_t GetRejectedCount(const Lane lane) const;
+
+    void Stop();
+
+    // determine the lane from the service name, i.e. the last path segment of the URI
+    static Lane GetLane(const std::string &uri);
+
+  private:
+    static constexpr unsigned REJECTION_LOG_INTERVAL = 10;
+
+    void Work(const Lane lane);
+
+    void LogRejections(const Lane lane);
+
+    std::vector<unsigned> lane_threads;
+    std::vector<std::unique_ptr<ConcurrentQueue<Task>>> lane_queues;
+    std::vector<std::thread> workers;
+    // Post queues its tasks and Stop its quit tasks while holding running_mutex
+    std::mutex running_mutex;
+    bool running;
+    std::array<std::atomic<uint64_t>, number_of_lanes> rejected;
+    // rejections up to the last log message, and the earliest time of the next one
+    std::array<std::atomic<uint64_t>, number_of_lanes> logged_rejections;
+    std::array<std::atomic<int64_t>, number_of_lanes> next_rejection_log;
+};
+
+#endif // COMPUTE_EXECUTOR_H
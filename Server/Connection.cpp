@@ -26,6 +26,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "Connection.h"
+#include "ComputeExecutor.h"
 #include "RequestHandler.h"
 #include "RequestParser.h"
 
@@ -34,23 +35,52 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 
+#include <cstring>
 #include <string>
 #include <vector>
 
 namespace http
 {
 
-Connection::Connection(boost::asio::io_service &io_service, RequestHandler &handler)
-    : strand(io_service), TCP_socket(io_service), request_handler(handler)
+namespace
 {
+// address of a TCP peer, unspecified for local clients connected via a Unix domain socket
+boost::asio::ip::address
+GetRemoteAddress(const boost::asio::generic::stream_protocol::socket &stream_socket)
+{
+    boost::system::error_code error;
+    const boost::asio::generic::stream_protocol::endpoint remote_endpoint =
+        stream_socket.remote_endpoint(error);
+    if (error || (AF_INET != remote_endpoint.protocol().family() &&
+                  AF_INET6 != remote_endpoint.protocol().family()))
+    {
+        return boost::asio::ip::address();
+    }
+    boost::asio::ip::tcp::endpoint tcp_endpoint;
+    BOOST_ASSERT(remote_endpoint.size() <= tcp_endpoint.capacity());
+    std::memcpy(tcp_endpoint.data(), remote_endpoint.data(), remote_endpoint.size());
+    tcp_endpoint.resize(remote_endpoint.size());
+    return tcp_endpoint.address();
+}
+}
+
+Connection::Connection(boost::asio::io_service &io_service,
+                       RequestHandler &handler,
+                       ComputeExecutor &executor,
+                       const bool cancel_on_close)
+    : strand(io_service), stream_socket(io_service), request_handler(handler),
+      compute_executor(executor), compression_type(noCompression),
+      cancel_on_close(cancel_on_close), cancelled(false)
+{
+    request.cancelled = &cancelled;
 }
 
-boost::asio::ip::tcp::socket &Connection::socket() { return TCP_socket; }
+boost::asio::generic::stream_protocol::socket &Connection::socket() { return stream_socket; }
 
 /// Start the first asynchronous operation for the connection.
 void Connection::start()
 {
-    TCP_socket.async_read_some(
+    stream_socket.async_read_some(
         boost::asio::buffer(incoming_data_buffer),
         strand.wrap(boost::bind(&Connection::handle_read,
                                 this->shared_from_this(),
@@ -66,7 +96,6 @@ void Connection::handle_read(const boost::system::error_code &error, std::size_t
     }
 
     // no error detected, let's parse the request
-    CompressionType compression_type(noCompression);
     boost::tribool result;
     boost::tie(result, boost::tuples::ignore) =
         request_parser.Parse(request,
@@ -77,41 +106,28 @@ void Connection::handle_read(const boost::system::error_code &error, std::size_t
     // the request has been parsed
     if (result)
     {
-        request.endpoint = TCP_socket.remote_endpoint().address();
-        request_handler.handle_request(request, reply);
-
-        // Header compression_header;
-        std::vector<char> compressed_output;
-        std::vector<boost::asio::const_buffer> output_buffer;
+        request.endpoint = GetRemoteAddress(stream_socket);
 
-        // compress the result w/ gzip/deflate if requested
-        switch (compression_type)
+        // charged to the admission budget before it waits for a compute thread
+        const std::shared_ptr<RequestHandler::AdmittedRequest> admitted_request =
+            request_handler.admit_request(request, reply);
+        if (nullptr != admitted_request)
         {
-        case deflateRFC1951:
-            // use deflate for compression
-            reply.headers.insert(reply.headers.begin(), {"Content-Encoding", "deflate"});
-            CompressBufferCollection(reply.content, compression_type, compressed_output);
-            reply.SetSize(static_cast<unsigned>(compressed_output.size()));
-            output_buffer = reply.HeaderstoBuffers();
-            output_buffer.push_back(boost::asio::buffer(compressed_output));
-            break;
-        case gzipRFC1952:
-            // use gzip for compression
-            reply.headers.insert(reply.headers.begin(), {"Content-Encoding", "gzip"});
-            CompressBufferCollection(reply.content, compression_type, compressed_output);
-            reply.SetSize(static_cast<unsigned>(compressed_output.size()));
-            output_buffer = reply.HeaderstoBuffers();
-            output_buffer.push_back(boost::asio::buffer(compressed_output));
-            break;
-        case noCompression:
-            // don't use any compression
-            reply.SetUncompressedSize();
-            output_buffer = reply.ToBuffers();
-            break;
+            // hand the query over to the compute threads, the reply is written from the strand
+            auto self = this->shared_from_this();
+            const bool queued = compute_executor.Post(
+                ComputeExecutor::GetLane(request.uri),
+                [self, admitted_request]()
+                { self->handle_request(*admitted_request); });
+            if (queued)
+            {
+                watch_peer();
+                return;
+            }
+            reply = Reply::StockReply(Reply::serviceUnavailable);
         }
-        // write result to stream
-        boost::asio::async_write(TCP_socket,
-                                 output_buffer,
+        boost::asio::async_write(stream_socket,
+                                 reply.ToBuffers(),
                                  strand.wrap(boost::bind(&Connection::handle_write,
                                                          this->shared_from_this(),
                                                          boost::asio::placeholders::error)));
@@ -120,7 +136,7 @@ void Connection::handle_read(const boost::system::error_code &error, std::size_t
     { // request is not parseable
         reply = Reply::StockReply(Reply::badRequest);
 
-        boost::asio::async_write(TCP_socket,
+        boost::asio::async_write(stream_socket,
                                  reply.ToBuffers(),
                                  strand.wrap(boost::bind(&Connection::handle_write,
                                                          this->shared_from_this(),
@@ -129,7 +145,7 @@ void Connection::handle_read(const boost::system::error_code &error, std::size_t
     else
     {
         // we don't have a result yet, so continue reading
-        TCP_socket.async_read_some(
+        stream_socket.async_read_some(
             boost::asio::buffer(incoming_data_buffer),
             strand.wrap(boost::bind(&Connection::handle_read,
                                     this->shared_from_this(),
@@ -138,14 +154,85 @@ void Connection::handle_read(const boost::system::error_code &error, std::size_t
     }
 }
 
+void Connection::watch_peer()
+{
+    stream_socket.async_read_some(
+        boost::asio::buffer(peer_data_buffer),
+        strand.wrap(boost::bind(&Connection::handle_peer_read,
+                                this->shared_from_this(),
+                                boost::asio::placeholders::error)));
+}
+
+void Connection::handle_peer_read(const boost::system::error_code &error)
+{
+    if (boost::asio::error::operation_aborted == error)
+    {
+        return;
+    }
+    if (!error)
+    {
+        // more data, e.g. a pipelined request. The connection is closed after the reply, so
+        // it is dropped rather than left unread, which would reset the connection on close.
+        watch_peer();
+        return;
+    }
+    // the end of the stream may just be a half-close by a client that still waits
+    if (boost::asio::error::eof == error && !cancel_on_close)
+    {
+        return;
+    }
+    cancelled = true;
+}
+
+void Connection::handle_request(RequestHandler::AdmittedRequest &admitted_request)
+{
+    request_handler.handle_request(admitted_request, reply);
+
+    // compress the result w/ gzip/deflate if requested
+    switch (compression_type)
+    {
+    case deflateRFC1951:
+        // use deflate for compression
+        CompressBufferCollection(reply.content, compression_type, compressed_output);
+        output_buffer = {{reply.HeaderstoBuffer(compressed_output.size(), "deflate"),
+                          boost::asio::buffer(compressed_output)}};
+        break;
+    case gzipRFC1952:
+        // use gzip for compression
+        CompressBufferCollection(reply.content, compression_type, compressed_output);
+        output_buffer = {{reply.HeaderstoBuffer(compressed_output.size(), "gzip"),
+                          boost::asio::buffer(compressed_output)}};
+        break;
+    case noCompression:
+        // don't use any compression
+        output_buffer = reply.ToBuffers();
+        break;
+    }
+    strand.post(boost::bind(&Connection::write_reply, this->shared_from_this()));
+}
+
+void Connection::write_reply()
+{
+    // write result to stream
+    boost::asio::async_write(stream_socket,
+                             output_buffer,
+                             strand.wrap(boost::bind(&Connection::handle_write,
+                                                     this->shared_from_this(),
+                                                     boost::asio::placeholders::error)));
+}
+
 /// Handle completion of a write operation.
 void Connection::handle_write(const boost::system::error_code &error)
 {
-    if (!error)
+    if (error)
+    {
+        cancelled = true;
+    }
+    else
     {
         // Initiate graceful connection closure.
         boost::system::error_code ignore_error;
-        TCP_socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignore_error);
+        stream_socket.shutdown(boost::asio::socket_base::shutdown_both, ignore_error);
     }
 }
 
@@ -28,6 +28,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef CONNECTION_H
 #define CONNECTION_H
 
+#include "RequestHandler.h"
 #include "RequestParser.h"
 #include "Http/CompressionType.h"
 #include "Http/Request.h"
@@ -39,6 +40,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/config.hpp>
 #include <boost/version.hpp>
 
+ #include <array>
+ #include <atomic>
  #include <memory>
  #include <string>
  #include <vector>
@@ -64,7 +67,7 @@ T* get_pointer(std::shared_ptr<T>& p)
 
 
 
-class RequestHandler;
+class ComputeExecutor;
 
 namespace http
 {
@@ -73,11 +76,15 @@ namespace http
 class Connection : public std::enable_shared_from_this<Connection>
 {
   public:
-    explicit Connection(boost::asio::io_service &io_service, RequestHandler &handler);
+    explicit Connection(boost::asio::io_service &io_service,
+                        RequestHandler &handler,
+                        ComputeExecutor &executor,
+                        const bool cancel_on_close = true);
     Connection(const Connection &) = delete;
     Connection() = delete;
 
-    boost::asio::ip::tcp::socket &socket();
+    // a generic stream socket, accepted from either a TCP or a Unix domain socket acceptor
+    boost::asio::generic::stream_protocol::socket &socket();
 
     /// Start the first asynchronous operation for the connection.
     void start();
@@ -85,6 +92,18 @@ class Connection : public std::enable_shared_from_this<Connection>
   private:
     void handle_read(const boost::system::error_code &e, std::size_t bytes_transferred);
 
+    /// Wait for the client to close the connection while its query runs.
+    void watch_peer();
+
+    /// Raise the cancellation flag if the client has gone away, keep watching otherwise.
+    void handle_peer_read(const boost::system::error_code &e);
+
+    /// Run the query and compress the reply, executed by a compute thread.
+    void handle_request(RequestHandler::AdmittedRequest &admitted_request);
+
+    /// Start writing the prepared output buffer, executed within the strand.
+    void write_reply();
+
     /// Handle completion of a write operation.
     void handle_write(const boost::system::error_code &e);
 
@@ -93,12 +112,24 @@ class Connection : public std::enable_shared_from_this<Connection>
                                   std::vector<char> &compressed_data);
 
     boost::asio::io_service::strand strand;
-    boost::asio::ip::tcp::socket TCP_socket;
+    boost::asio::generic::stream_protocol::socket stream_socket;
     RequestHandler &request_handler;
+    ComputeExecutor &compute_executor;
     boost::array<char, 8192> incoming_data_buffer;
+    // takes what the client sends after its request, which is never answered
+    boost::array<char, 512> peer_data_buffer;
     Request request;
     RequestParser request_parser;
     Reply reply;
+    // kept across reads as headers may arrive in an earlier chunk than the end of the request
+    CompressionType compression_type;
+    std::vector<char> compressed_output;
+    std::array<boost::asio::const_buffer, 2> output_buffer;
+    // whether the end of the stream from the client cancels its query, a client may also
+    // just shut down its sending side and still wait for the reply
+    const bool cancel_on_close;
+    // polled by the searches of the query, which give up once it is raised
+    std::atomic<bool> cancelled;
 };
 
 } // namespace http
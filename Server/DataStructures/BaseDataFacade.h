@@ -72,6 +72,11 @@ template <class EdgeDataT> class BaseDataFacade
 
     virtual EdgeRange GetAdjacentEdgeRange(const NodeID node) const = 0;
 
+    // hints only, the routing step calls these for nodes it will settle soon
+    virtual void PrefetchNode(const NodeID n) const = 0;
+
+    virtual void PrefetchEdges(const NodeID n) const = 0;
+
     // searches for a specific edge
     virtual EdgeID FindEdge(const NodeID from, const NodeID to) const = 0;
 
@@ -90,6 +95,10 @@ template <class EdgeDataT> class BaseDataFacade
     virtual void GetUncompressedGeometry(const unsigned id,
                                          std::vector<unsigned> &result_nodes) const = 0;
 
+    // simplification ranks of the nodes returned by GetUncompressedGeometry
+    virtual void GetUncompressedGeometryRanks(const unsigned id,
+                                              std::vector<SimplificationRank> &result_ranks) const = 0;
+
     virtual TurnInstruction GetTurnInstructionForEdgeID(const unsigned id) const = 0;
 
     virtual TravelMode GetTravelModeForEdgeID(const unsigned id) const = 0;
@@ -122,6 +131,9 @@ template <class EdgeDataT> class BaseDataFacade
     }
 
     virtual std::string GetTimestamp() const = 0;
+
+    // faults in the data and the r-tree leaves ahead of the first queries
+    virtual void Prefault(const bool lock_to_ram) = 0;
 };
 
 #endif // BASE_DATA_FACADE_H
@@ -41,12 +41,16 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../../DataStructures/RangeTable.h"
 #include "../../Util/BoostFileSystemFix.h"
 #include "../../Util/GraphLoader.h"
+#include "../../Util/Prefault.h"
 #include "../../Util/ProgramOptions.h"
 #include "../../Util/simple_logger.hpp"
 
 #include <osrm/Coordinate.h>
 
-template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<EdgeDataT>
+#include <memory>
+#include <mutex>
+
+template <class EdgeDataT> class InternalDataFacade final : public BaseDataFacade<EdgeDataT>
 {
 
   private:
@@ -54,6 +58,7 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
     typedef StaticGraph<typename super::EdgeData> QueryGraph;
     typedef typename QueryGraph::InputEdge InputEdge;
     typedef typename super::RTreeLeaf RTreeLeaf;
+    typedef StaticRTree<RTreeLeaf, ShM<FixedPointCoordinate, false>::vector, false> InternalRTree;
 
     InternalDataFacade() {}
 
@@ -71,9 +76,11 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
     ShM<bool, false>::vector m_edge_is_compressed;
     ShM<unsigned, false>::vector m_geometry_indices;
     ShM<unsigned, false>::vector m_geometry_list;
+    ShM<SimplificationRank, false>::vector m_geometry_rank_list;
 
-    boost::thread_specific_ptr<
-        StaticRTree<RTreeLeaf, ShM<FixedPointCoordinate, false>::vector, false>> m_static_rtree;
+    // loaded on first use and shared by all threads, freed with the facade
+    std::unique_ptr<InternalRTree> m_static_rtree;
+    std::once_flag m_static_rtree_loaded;
     boost::filesystem::path ram_index_path;
     boost::filesystem::path file_index_path;
     RangeTable<16, false> m_name_table;
@@ -194,6 +201,21 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
             geometry_stream.read((char *)&(m_geometry_list[0]),
                                  number_of_compressed_geometries * sizeof(unsigned));
         }
+
+        m_geometry_rank_list.resize(number_of_compressed_geometries);
+        if (number_of_compressed_geometries > 0)
+        {
+            geometry_stream.read((char *)&(m_geometry_rank_list[0]),
+                                 number_of_compressed_geometries * sizeof(SimplificationRank));
+            if (!geometry_stream)
+            {
+                SimpleLogger().Write(logWARNING)
+                    << "geometry file has no simplification ranks, rerun osrm-prepare";
+                std::fill(m_geometry_rank_list.begin(),
+                          m_geometry_rank_list.end(),
+                          INVALID_SIMPLIFICATION_RANK);
+            }
+        }
         geometry_stream.close();
     }
 
@@ -201,8 +223,16 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
     {
         BOOST_ASSERT_MSG(!m_coordinate_list->empty(), "coordinates must be loaded before r-tree");
 
-        m_static_rtree.reset(
-            new StaticRTree<RTreeLeaf>(ram_index_path, file_index_path, m_coordinate_list));
+        m_static_rtree.reset(new InternalRTree(ram_index_path, file_index_path, m_coordinate_list));
+    }
+
+    InternalRTree &GetRTree()
+    {
+        std::call_once(m_static_rtree_loaded, [this]()
+                       {
+            LoadRTree();
+        });
+        return *m_static_rtree;
     }
 
     void LoadStreetNames(const boost::filesystem::path &names_file)
@@ -227,7 +257,6 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
     virtual ~InternalDataFacade()
     {
         delete m_query_graph;
-        m_static_rtree.reset();
     }
 
     explicit InternalDataFacade(const ServerPaths &server_paths)
@@ -330,6 +359,10 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
         return m_query_graph->GetAdjacentEdgeRange(node);
     };
 
+    void PrefetchNode(const NodeID n) const final { m_query_graph->PrefetchNode(n); }
+
+    void PrefetchEdges(const NodeID n) const final { m_query_graph->PrefetchEdges(n); }
+
     // searches for a specific edge
     EdgeID FindEdge(const NodeID from, const NodeID to) const final
     {
@@ -368,12 +401,7 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
                                             FixedPointCoordinate &result,
                                             const unsigned zoom_level = 18) final
     {
-        if (!m_static_rtree.get())
-        {
-            LoadRTree();
-        }
-
-        return m_static_rtree->LocateClosestEndPointForCoordinate(
+        return GetRTree().LocateClosestEndPointForCoordinate(
             input_coordinate, result, zoom_level);
     }
 
@@ -381,12 +409,7 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
                                       PhantomNode &resulting_phantom_node,
                                       const unsigned zoom_level) final
     {
-        if (!m_static_rtree.get())
-        {
-            LoadRTree();
-        }
-
-        return m_static_rtree->FindPhantomNodeForCoordinate(
+        return GetRTree().FindPhantomNodeForCoordinate(
             input_coordinate, resulting_phantom_node, zoom_level);
     }
 
@@ -396,12 +419,7 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
                                             const unsigned zoom_level,
                                             const unsigned number_of_results) final
     {
-        if (!m_static_rtree.get())
-        {
-            LoadRTree();
-        }
-
-        return m_static_rtree->IncrementalFindPhantomNodeForCoordinate(
+        return GetRTree().IncrementalFindPhantomNodeForCoordinate(
             input_coordinate, resulting_phantom_node_vector, zoom_level, number_of_results);
     }
 
@@ -447,7 +465,29 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
             result_nodes.begin(), m_geometry_list.begin() + begin, m_geometry_list.begin() + end);
     }
 
+    virtual void GetUncompressedGeometryRanks(const unsigned id,
+                                              std::vector<SimplificationRank> &result_ranks) const
+        final
+    {
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+
+        result_ranks.clear();
+        result_ranks.insert(result_ranks.begin(),
+                            m_geometry_rank_list.begin() + begin,
+                            m_geometry_rank_list.begin() + end);
+    }
+
     std::string GetTimestamp() const final { return m_timestamp; }
+
+    // the graph and all tables were read into the heap and are resident already, only the
+    // r-tree leaves are read from disk on demand
+    void Prefault(const bool) final
+    {
+        GetRTree();
+        SimpleLogger().Write() << "read " << PrefaultFile(file_index_path)
+                               << " bytes of r-tree leaves";
+    }
 };
 
 #endif // INTERNAL_DATA_FACADE
@@ -39,16 +39,20 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../../Util/BoostFileSystemFix.h"
 #include "../../Util/ProgramOptions.h"
 #include "../../Util/make_unique.hpp"
+#include "../../Util/Prefault.h"
 #include "../../Util/simple_logger.hpp"
 
 #include <algorithm>
 #include <memory>
 
-template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDataT>
+template <class EdgeDataT> class SharedDataFacade final : public BaseDataFacade<EdgeDataT>
 {
 
-  private:
+  public:
+    // the routing algorithms are instantiated with this type directly
     typedef EdgeDataT EdgeData;
+
+  private:
     typedef BaseDataFacade<EdgeData> super;
     typedef StaticGraph<EdgeData, true> QueryGraph;
     typedef typename StaticGraph<EdgeData, true>::NodeArrayEntry GraphNode;
@@ -84,6 +88,7 @@ template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDa
     ShM<bool, true>::vector m_edge_is_compressed;
     ShM<unsigned, true>::vector m_geometry_indices;
     ShM<unsigned, true>::vector m_geometry_list;
+    ShM<SimplificationRank, true>::vector m_geometry_rank_list;
 
     boost::thread_specific_ptr<std::pair<unsigned, std::shared_ptr<SharedRTree>>> m_static_rtree;
     boost::filesystem::path file_index_path;
@@ -215,6 +220,13 @@ template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDa
         typename ShM<unsigned, true>::vector geometry_list(
             geometries_list_ptr, data_layout->num_entries[SharedDataLayout::GEOMETRIES_LIST]);
         m_geometry_list.swap(geometry_list);
+
+        SimplificationRank *geometries_rank_list_ptr = data_layout->GetBlockPtr<SimplificationRank>(
+            shared_memory, SharedDataLayout::GEOMETRIES_RANK_LIST);
+        typename ShM<SimplificationRank, true>::vector geometry_rank_list(
+            geometries_rank_list_ptr,
+            data_layout->num_entries[SharedDataLayout::GEOMETRIES_RANK_LIST]);
+        m_geometry_rank_list.swap(geometry_rank_list);
     }
 
   public:
@@ -304,6 +316,10 @@ template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDa
         return m_query_graph->GetAdjacentEdgeRange(node);
     };
 
+    void PrefetchNode(const NodeID n) const final { m_query_graph->PrefetchNode(n); }
+
+    void PrefetchEdges(const NodeID n) const final { m_query_graph->PrefetchEdges(n); }
+
     // searches for a specific edge
     EdgeID FindEdge(const NodeID from, const NodeID to) const final
     {
@@ -342,6 +358,19 @@ template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDa
             result_nodes.begin(), m_geometry_list.begin() + begin, m_geometry_list.begin() + end);
     }
 
+    virtual void GetUncompressedGeometryRanks(const unsigned id,
+                                              std::vector<SimplificationRank> &result_ranks) const
+        final
+    {
+        const unsigned begin = m_geometry_indices.at(id);
+        const unsigned end = m_geometry_indices.at(id + 1);
+
+        result_ranks.clear();
+        result_ranks.insert(result_ranks.begin(),
+                            m_geometry_rank_list.begin() + begin,
+                            m_geometry_rank_list.begin() + end);
+    }
+
     virtual unsigned GetGeometryIndexForEdgeID(const unsigned id) const final
     {
         return m_via_node_list.at(id);
@@ -425,6 +454,16 @@ template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDa
     }
 
     std::string GetTimestamp() const final { return m_timestamp; }
+
+    void Prefault(const bool lock_to_ram) final
+    {
+        m_layout_memory->Prefault(lock_to_ram);
+        m_large_memory->Prefault(lock_to_ram);
+        SimpleLogger().Write() << "prefaulted " << (m_layout_memory->Size() + m_large_memory->Size())
+                               << " bytes of shared memory";
+        SimpleLogger().Write() << "read " << PrefaultFile(file_index_path)
+                               << " bytes of r-tree leaves";
+    }
 };
 
 #endif // SHARED_DATA_FACADE_H
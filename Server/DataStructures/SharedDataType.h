@@ -54,6 +54,7 @@ struct SharedDataLayout
         R_SEARCH_TREE,
         GEOMETRIES_INDEX,
         GEOMETRIES_LIST,
+        GEOMETRIES_RANK_LIST,
         GEOMETRIES_INDICATORS,
         HSGR_CHECKSUM,
         TIMESTAMP,
@@ -89,6 +90,7 @@ struct SharedDataLayout
                                        << "/" << ((num_entries[GEOMETRIES_INDICATORS] / 8) + 1);
         SimpleLogger().Write(logDEBUG) << "geometries_index_list_size: " << num_entries[GEOMETRIES_INDEX];
         SimpleLogger().Write(logDEBUG) << "geometries_list_size:       " << num_entries[GEOMETRIES_LIST];
+        SimpleLogger().Write(logDEBUG) << "geometries_rank_list_size:  " << num_entries[GEOMETRIES_RANK_LIST];
         SimpleLogger().Write(logDEBUG) << "sizeof(checksum):           " << entry_size[HSGR_CHECKSUM];
 
         SimpleLogger().Write(logDEBUG) << "NAME_OFFSETS         " << ": " << GetBlockSize(NAME_OFFSETS         );
@@ -104,6 +106,7 @@ struct SharedDataLayout
         SimpleLogger().Write(logDEBUG) << "R_SEARCH_TREE        " << ": " << GetBlockSize(R_SEARCH_TREE        );
         SimpleLogger().Write(logDEBUG) << "GEOMETRIES_INDEX     " << ": " << GetBlockSize(GEOMETRIES_INDEX     );
         SimpleLogger().Write(logDEBUG) << "GEOMETRIES_LIST      " << ": " << GetBlockSize(GEOMETRIES_LIST      );
+        SimpleLogger().Write(logDEBUG) << "GEOMETRIES_RANK_LIST " << ": " << GetBlockSize(GEOMETRIES_RANK_LIST );
         SimpleLogger().Write(logDEBUG) << "GEOMETRIES_INDICATORS" << ": " << GetBlockSize(GEOMETRIES_INDICATORS);
         SimpleLogger().Write(logDEBUG) << "HSGR_CHECKSUM        " << ": " << GetBlockSize(HSGR_CHECKSUM        );
         SimpleLogger().Write(logDEBUG) << "TIMESTAMP            " << ": " << GetBlockSize(TIMESTAMP            );
@@ -27,68 +27,145 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <osrm/Reply.h>
 
-#include "../../Util/cast.hpp"
+#include <boost/assert.hpp>
+
+#include <cstring>
 
 namespace http
 {
 
-void Reply::SetSize(const unsigned size)
+namespace
+{
+// preformatted header blocks, one per reply format
+const char htmlHeaders[] = "Access-Control-Allow-Origin: *\r\n"
+                           "Content-Type: text/html\r\n";
+const char jsonHeaders[] = "Content-Type: application/json; charset=UTF-8\r\n"
+                           "Content-Disposition: inline; filename=\"response.json\"\r\n";
+const char jsonpHeaders[] = "Content-Type: text/javascript; charset=UTF-8\r\n"
+                            "Content-Disposition: inline; filename=\"response.js\"\r\n";
+const char gpxHeaders[] = "Content-Type: application/gpx+xml; charset=UTF-8\r\n"
+                          "Content-Disposition: attachment; filename=\"route.gpx\"\r\n";
+const char binaryHeaders[] = "Content-Type: application/octet-stream\r\n"
+                             "Content-Disposition: inline; filename=\"response.bin\"\r\n";
+
+// appends to a fixed-size buffer, input that does not fit is dropped
+class HeaderBuilder
 {
-    for (Header &h : headers)
+  public:
+    HeaderBuilder(char *buffer, const std::size_t capacity)
+        : buffer(buffer), capacity(capacity), length(0)
+    {
+    }
+
+    void Append(const char *data, const std::size_t size)
     {
-        if ("Content-Length" == h.name)
+        BOOST_ASSERT_MSG(length + size <= capacity, "header buffer too small");
+        if (length + size <= capacity)
         {
-            h.value = cast::integral_to_string(size);
+            std::memcpy(buffer + length, data, size);
+            length += size;
         }
     }
-}
 
-// Sets the size of the uncompressed output.
-void Reply::SetUncompressedSize() { SetSize(static_cast<unsigned>(content.size())); }
+    template <std::size_t N> void Append(const char (&literal)[N]) { Append(literal, N - 1); }
 
-std::vector<boost::asio::const_buffer> Reply::ToBuffers()
-{
-    std::vector<boost::asio::const_buffer> buffers;
-    buffers.push_back(ToBuffer(status));
-    for (const Header &h : headers)
+    void Append(const std::string &data) { Append(data.data(), data.size()); }
+
+    void AppendNumber(std::size_t number)
     {
-        buffers.push_back(boost::asio::buffer(h.name));
-        buffers.push_back(boost::asio::buffer(seperators));
-        buffers.push_back(boost::asio::buffer(h.value));
-        buffers.push_back(boost::asio::buffer(crlf));
+        char digits[20];
+        std::size_t position = sizeof(digits);
+        do
+        {
+            digits[--position] = static_cast<char>('0' + number % 10);
+            number /= 10;
+        } while (0 != number);
+        Append(digits + position, sizeof(digits) - position);
     }
-    buffers.push_back(boost::asio::buffer(crlf));
-    buffers.push_back(boost::asio::buffer(content));
-    return buffers;
+
+    std::size_t Length() const { return length; }
+
+  private:
+    char *buffer;
+    const std::size_t capacity;
+    std::size_t length;
+};
+}
+
+std::array<boost::asio::const_buffer, 2> Reply::ToBuffers()
+{
+    return {{HeaderstoBuffer(content.size()), boost::asio::buffer(content)}};
 }
 
-std::vector<boost::asio::const_buffer> Reply::HeaderstoBuffers()
+boost::asio::const_buffer Reply::HeaderstoBuffer(const std::size_t content_length,
+                                                 const char *content_encoding)
 {
-    std::vector<boost::asio::const_buffer> buffers;
-    buffers.push_back(ToBuffer(status));
-    for (std::size_t i = 0; i < headers.size(); ++i)
+    HeaderBuilder builder(header_data.data(), header_data.size());
+    switch (status)
     {
-        Header &current_header = headers[i];
-        buffers.push_back(boost::asio::buffer(current_header.name));
-        buffers.push_back(boost::asio::buffer(seperators));
-        buffers.push_back(boost::asio::buffer(current_header.value));
-        buffers.push_back(boost::asio::buffer(crlf));
+    case Reply::ok:
+        builder.Append(okString);
+        break;
+    case Reply::badRequest:
+        builder.Append(badRequestString);
+        break;
+    case Reply::serviceUnavailable:
+        builder.Append(serviceUnavailableString);
+        break;
+    default:
+        builder.Append(internalServerErrorString);
+        break;
     }
-    buffers.push_back(boost::asio::buffer(crlf));
-    return buffers;
+
+    switch (format)
+    {
+    case Reply::jsonFormat:
+        builder.Append(jsonHeaders);
+        break;
+    case Reply::jsonpFormat:
+        builder.Append(jsonpHeaders);
+        break;
+    case Reply::gpxFormat:
+        builder.Append(gpxHeaders);
+        break;
+    case Reply::binaryFormat:
+        builder.Append(binaryHeaders);
+        break;
+    default:
+        builder.Append(htmlHeaders);
+        break;
+    }
+
+    if (nullptr != content_encoding)
+    {
+        builder.Append("Content-Encoding: ");
+        builder.Append(content_encoding, std::strlen(content_encoding));
+        builder.Append("\r\n");
+    }
+    builder.Append("Content-Length: ");
+    builder.AppendNumber(content_length);
+    builder.Append("\r\n");
+
+    for (const Header &h : headers)
+    {
+        builder.Append(h.name);
+        builder.Append(": ");
+        builder.Append(h.value);
+        builder.Append("\r\n");
+    }
+    builder.Append("\r\n");
+    return boost::asio::buffer(header_data.data(), builder.Length());
 }
 
 Reply Reply::StockReply(Reply::status_type status)
 {
     Reply reply;
     reply.status = status;
+    reply.format = Reply::htmlFormat;
     reply.content.clear();
 
     const std::string status_string = reply.ToString(status);
     reply.content.insert(reply.content.end(), status_string.begin(), status_string.end());
-    reply.headers.emplace_back("Access-Control-Allow-Origin", "*");
-    reply.headers.emplace_back("Content-Length", cast::integral_to_string(reply.content.size()));
-    reply.headers.emplace_back("Content-Type", "text/html");
     return reply;
 }
 
@@ -102,21 +179,12 @@ std::string Reply::ToString(Reply::status_type status)
     {
         return badRequestHTML;
     }
-    return internalServerErrorHTML;
-}
-
-boost::asio::const_buffer Reply::ToBuffer(Reply::status_type status)
-{
-    if (Reply::ok == status)
-    {
-        return boost::asio::buffer(okString);
-    }
-    if (Reply::internalServerError == status)
+    if (Reply::serviceUnavailable == status)
     {
-        return boost::asio::buffer(internalServerErrorString);
+        return serviceUnavailableHTML;
     }
-    return boost::asio::buffer(badRequestString);
+    return internalServerErrorHTML;
 }
 
-Reply::Reply() : status(ok) {}
+Reply::Reply() : status(ok), format(jsonFormat) {}
 }
@@ -30,7 +30,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/asio.hpp>
 
+#include <atomic>
 #include <string>
+#include <vector>
 
 namespace http
 {
@@ -40,7 +42,11 @@ struct Request
     std::string uri;
     std::string referrer;
     std::string agent;
+    std::string content_type;
+    std::vector<char> body;
     boost::asio::ip::address endpoint;
+    // raised by the connection once the client has gone away
+    const std::atomic<bool> *cancelled = nullptr;
 };
 
 } // namespace http
@@ -0,0 +1,99 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "QueryLogReplay.h"
+
+#include "APIGrammar.h"
+
+#include "../Library/OSRM.h"
+#include "../Util/OSRMException.h"
+#include "../Util/simple_logger.hpp"
+#include "../Util/StringUtil.h"
+#include "../Util/TimingUtil.h"
+
+#include <osrm/Reply.h>
+#include <osrm/RouteParameters.h>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/spirit/include/qi.hpp>
+
+#include <string>
+#include <vector>
+
+unsigned ReplayQueryLog(OSRM &routing_machine, const boost::filesystem::path &log_path)
+{
+    boost::filesystem::ifstream log_stream(log_path);
+    if (!log_stream.is_open())
+    {
+        throw OSRMException("could not open query log " + log_path.string());
+    }
+    std::vector<std::string> requests;
+    std::string line;
+    while (std::getline(log_stream, line))
+    {
+        if (!line.empty() && '#' != line[0])
+        {
+            char *begin = &line[0];
+            requests.emplace_back(begin, URIDecodeInPlace(begin, begin + line.size()));
+        }
+    }
+    SimpleLogger().Write() << "replaying " << requests.size() << " queries of "
+                           << log_path.string();
+
+    TIMER_START(replay);
+    unsigned successful_queries = 0;
+    std::size_t reported_tenths = 0;
+    for (std::size_t i = 0; i < requests.size(); ++i)
+    {
+        const std::string &request = requests[i];
+        RouteParameters route_parameters;
+        APIGrammar<std::string::const_iterator, RouteParameters> api_parser(&route_parameters);
+        auto iter = request.begin();
+        const bool result = boost::spirit::qi::parse(iter, request.end(), api_parser);
+        if (result && iter == request.end())
+        {
+            http::Reply reply;
+            routing_machine.RunQuery(route_parameters, reply);
+            if (http::Reply::ok == reply.status)
+            {
+                ++successful_queries;
+            }
+        }
+
+        const std::size_t done_tenths = 10 * (i + 1) / requests.size();
+        if (done_tenths != reported_tenths && i + 1 < requests.size())
+        {
+            SimpleLogger().Write() << "warm-up " << (10 * done_tenths) << "% done";
+            reported_tenths = done_tenths;
+        }
+    }
+    TIMER_STOP(replay);
+    SimpleLogger().Write() << "replayed " << requests.size() << " queries in "
+                           << TIMER_SEC(replay) << " seconds, " << successful_queries
+                           << " succeeded";
+    return successful_queries;
+}
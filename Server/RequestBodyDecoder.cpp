@@ -0,0 +1,87 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "RequestBodyDecoder.h"
+
+#include <boost/fusion/include/std_pair.hpp>
+#include <boost/spirit/include/qi.hpp>
+
+#include <cstdint>
+
+#include <utility>
+
+namespace http
+{
+
+bool DecodeBinaryCoordinates(const std::vector<char> &body,
+                             std::vector<FixedPointCoordinate> &coordinates)
+{
+    const std::size_t record_size = 2 * sizeof(int32_t);
+    if (0 != body.size() % record_size)
+    {
+        return false;
+    }
+    const auto read_int32 = [&body](const std::size_t offset)
+    {
+        const auto *bytes = reinterpret_cast<const unsigned char *>(body.data() + offset);
+        const uint32_t value = uint32_t(bytes[0]) | (uint32_t(bytes[1]) << 8) |
+                               (uint32_t(bytes[2]) << 16) | (uint32_t(bytes[3]) << 24);
+        return static_cast<int32_t>(value);
+    };
+    coordinates.reserve(coordinates.size() + body.size() / record_size);
+    for (std::size_t offset = 0; offset < body.size(); offset += record_size)
+    {
+        coordinates.emplace_back(read_int32(offset), read_int32(offset + sizeof(int32_t)));
+    }
+    return true;
+}
+
+bool DecodeJSONCoordinates(const std::vector<char> &body,
+                           std::vector<FixedPointCoordinate> &coordinates)
+{
+    namespace qi = boost::spirit::qi;
+    std::vector<std::pair<double, double>> locations;
+    auto iter = body.begin();
+    const bool result = qi::phrase_parse(
+        iter,
+        body.end(),
+        '[' >> -(('[' >> qi::double_ >> ',' >> qi::double_ >> ']') % ',') >> ']',
+        qi::space,
+        locations);
+    if (!result || iter != body.end())
+    {
+        return false;
+    }
+    coordinates.reserve(coordinates.size() + locations.size());
+    for (const auto &location : locations)
+    {
+        coordinates.emplace_back(static_cast<int>(COORDINATE_PRECISION * location.first),
+                                 static_cast<int>(COORDINATE_PRECISION * location.second));
+    }
+    return true;
+}
+}
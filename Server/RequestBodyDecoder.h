@@ -0,0 +1,50 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef REQUEST_BODY_DECODER_H
+#define REQUEST_BODY_DECODER_H
+
+#include <osrm/Coordinate.h>
+
+#include <vector>
+
+namespace http
+{
+
+// Decoders of the coordinates of a POST body. They append to coordinates and return false if
+// the body is malformed, in which case coordinates may hold a part of the body.
+
+// binary payload: consecutive pairs of little-endian int32 lat/lon in fixed-point notation
+bool DecodeBinaryCoordinates(const std::vector<char> &body,
+                             std::vector<FixedPointCoordinate> &coordinates);
+
+// JSON payload: [[lat,lon],[lat,lon],...] in degrees
+bool DecodeJSONCoordinates(const std::vector<char> &body,
+                           std::vector<FixedPointCoordinate> &coordinates);
+}
+
+#endif // REQUEST_BODY_DECODER_H
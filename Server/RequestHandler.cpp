@@ -28,10 +28,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "RequestHandler.h"
 
 #include "APIGrammar.h"
+#include "RequestBodyDecoder.h"
 #include "Http/Request.h"
 
 #include "../DataStructures/JSONContainer.h"
+#include "../DataStructures/AdmissionControl.h"
 #include "../Library/OSRM.h"
+#include "../Util/NUMAUtil.h"
 #include "../Util/simple_logger.hpp"
 #include "../Util/StringUtil.h"
 #include "../typedefs.h"
@@ -39,20 +42,34 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <osrm/Reply.h>
 #include <osrm/RouteParameters.h>
 
+#include <boost/spirit/include/qi.hpp>
+
 #include <ctime>
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <vector>
+
+struct RequestHandler::AdmittedRequest
+{
+    RouteParameters route_parameters;
+    // holds the estimated cost in the budget of one of the routing machines
+    std::shared_ptr<const AdmissionTicket> ticket;
+    std::string uri;
+};
 
-RequestHandler::RequestHandler() : routing_machine(nullptr) {}
+RequestHandler::RequestHandler() {}
 
-void RequestHandler::handle_request(const http::Request &req, http::Reply &reply)
+std::shared_ptr<RequestHandler::AdmittedRequest>
+RequestHandler::admit_request(const http::Request &req, http::Reply &reply)
 {
     // parse command
     try
     {
-        std::string request;
-        URIDecode(req.uri, request);
+        // the request parser has already percent-decoded the URI
+        const std::string &request = req.uri;
 
         // deactivated as GCC apparently does not implement that, not even in 4.9
         // std::time_t t = std::time(nullptr);
@@ -77,7 +94,10 @@ void RequestHandler::handle_request(const http::Request &req, http::Reply &reply
                                << (0 == req.referrer.length() ? "- " : " ") << req.agent
                                << (0 == req.agent.length() ? "- " : " ") << request;
 
-        RouteParameters route_parameters;
+        auto admitted_request = std::make_shared<AdmittedRequest>();
+        admitted_request->uri = request;
+        RouteParameters &route_parameters = admitted_request->route_parameters;
+        route_parameters.cancelled = req.cancelled;
         APIGrammarParser api_parser(&route_parameters);
 
         auto iter = request.begin();
@@ -95,48 +115,114 @@ void RequestHandler::handle_request(const http::Request &req, http::Reply &reply
             message += cast::integral_to_string(position);
             json_result.values["status_message"] = message;
             JSON::render(reply.content, json_result);
-            return;
+            return nullptr;
+        }
+
+        // coordinates of a POST body are appended to those given in the query string
+        if (!req.body.empty())
+        {
+            std::vector<FixedPointCoordinate> &coordinates = route_parameters.coordinates;
+            const bool body_ok = (0 == req.content_type.find("application/octet-stream"))
+                                     ? http::DecodeBinaryCoordinates(req.body, coordinates)
+                                     : http::DecodeJSONCoordinates(req.body, coordinates);
+            if (!body_ok)
+            {
+                reply = http::Reply::StockReply(http::Reply::badRequest);
+                reply.content.clear();
+                JSON::Object json_result;
+                json_result.values["status"] = 400;
+                json_result.values["status_message"] = "Request body malformed";
+                JSON::render(reply.content, json_result);
+                return nullptr;
+            }
         }
 
-        // parsing done, lets call the right plugin to handle the request
-        BOOST_ASSERT_MSG(routing_machine != nullptr, "pointer not init'ed");
+        // the replicas share the budget, the query may run on any of them
+        BOOST_ASSERT_MSG(!routing_machines.empty(), "pointer not init'ed");
+        for (OSRM *routing_machine : routing_machines)
+        {
+            admitted_request->ticket = routing_machine->Admit(route_parameters);
+            if (nullptr != admitted_request->ticket)
+            {
+                return admitted_request;
+            }
+        }
+        // shed load early instead of queueing more work than can be done in time
+        reply = http::Reply::StockReply(http::Reply::serviceUnavailable);
+        reply.headers.emplace_back("Retry-After", "1");
+        return nullptr;
+    }
+    catch (const std::exception &e)
+    {
+        reply = http::Reply::StockReply(http::Reply::internalServerError);
+        SimpleLogger().Write(logWARNING) << "[server error] code: " << e.what()
+                                         << ", uri: " << req.uri;
+        return nullptr;
+    }
+}
+
+void RequestHandler::handle_request(AdmittedRequest &admitted_request, http::Reply &reply)
+{
+    RouteParameters &route_parameters = admitted_request.route_parameters;
+    // called by a compute thread right after the request was taken off the queue
+    route_parameters.query_start = std::chrono::steady_clock::now();
+    // the cost stays reserved until the query has been answered
+    const std::shared_ptr<const AdmissionTicket> ticket = std::move(admitted_request.ticket);
+
+    try
+    {
+        OSRM *routing_machine =
+            routing_machines[(1 == routing_machines.size())
+                                 ? 0
+                                 : GetCurrentNUMANodeIndex() % routing_machines.size()];
+
+        // jsonp only wraps text output
+        const bool is_binary_output = ("binary" == route_parameters.output_format);
+        if (is_binary_output)
+        {
+            route_parameters.jsonp_parameter.clear();
+        }
 
         if (!route_parameters.jsonp_parameter.empty())
         { // prepend response with jsonp parameter
             const std::string json_p = (route_parameters.jsonp_parameter + "(");
             reply.content.insert(reply.content.end(), json_p.begin(), json_p.end());
         }
-        routing_machine->RunQuery(route_parameters, reply);
+        routing_machine->RunQuery(route_parameters, reply, *ticket);
+        if (http::Reply::ok != reply.status)
+        { // stock replies come with their own format
+            return;
+        }
         if (!route_parameters.jsonp_parameter.empty())
         { // append brace to jsonp response
             reply.content.push_back(')');
         }
 
-        // set headers
-        reply.headers.emplace_back("Content-Length", cast::integral_to_string(reply.content.size()));
+        // select the preformatted headers, Content-Length is added when the reply is written
         if ("gpx" == route_parameters.output_format)
         { // gpx file
-            reply.headers.emplace_back("Content-Type", "application/gpx+xml; charset=UTF-8");
-            reply.headers.emplace_back("Content-Disposition", "attachment; filename=\"route.gpx\"");
+            reply.format = http::Reply::gpxFormat;
+        }
+        else if (is_binary_output)
+        { // little-endian binary, see DataStructures/BinaryContainer.h
+            reply.format = http::Reply::binaryFormat;
         }
         else if (route_parameters.jsonp_parameter.empty())
         { // json file
-            reply.headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
-            reply.headers.emplace_back("Content-Disposition", "inline; filename=\"response.json\"");
+            reply.format = http::Reply::jsonFormat;
         }
         else
         { // jsonp
-            reply.headers.emplace_back("Content-Type", "text/javascript; charset=UTF-8");
-            reply.headers.emplace_back("Content-Disposition", "inline; filename=\"response.js\"");
+            reply.format = http::Reply::jsonpFormat;
         }
     }
     catch (const std::exception &e)
     {
         reply = http::Reply::StockReply(http::Reply::internalServerError);
         SimpleLogger().Write(logWARNING) << "[server error] code: " << e.what()
-                                         << ", uri: " << req.uri;
+                                         << ", uri: " << admitted_request.uri;
         return;
     }
 }
 
-void RequestHandler::RegisterRoutingMachine(OSRM *osrm) { routing_machine = osrm; }
+void RequestHandler::RegisterRoutingMachine(OSRM *osrm) { routing_machines.push_back(osrm); }
@@ -28,7 +28,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef REQUEST_HANDLER_H
 #define REQUEST_HANDLER_H
 
+#include <memory>
 #include <string>
+#include <vector>
 
 template <typename Iterator, class HandlerT> struct APIGrammar;
 struct RouteParameters;
@@ -44,16 +46,27 @@ class RequestHandler
 {
 
   public:
-    using APIGrammarParser = APIGrammar<std::string::iterator, RouteParameters>;
+    using APIGrammarParser = APIGrammar<std::string::const_iterator, RouteParameters>;
 
     RequestHandler();
     RequestHandler(const RequestHandler &) = delete;
 
-    void handle_request(const http::Request &req, http::Reply &rep);
+    // a request that was parsed and admitted, see admit_request
+    struct AdmittedRequest;
+
+    // Parses the request and reserves its estimated cost in the admission budget. Called by a
+    // network thread before the request is queued, so that the budget also counts requests
+    // that wait for a compute thread. Returns nullptr with the reply set if the request is
+    // malformed or over budget.
+    std::shared_ptr<AdmittedRequest> admit_request(const http::Request &req, http::Reply &rep);
+    // computes the reply and releases the reserved cost, called by a compute thread
+    void handle_request(AdmittedRequest &admitted_request, http::Reply &rep);
+    // Registering several routing machines replicates the dataset, one per NUMA node in node
+    // order. Requests are then answered by the replica of the node they are computed on.
     void RegisterRoutingMachine(OSRM *osrm);
 
   private:
-    OSRM *routing_machine;
+    std::vector<OSRM *> routing_machines;
 };
 
 #endif // REQUEST_HANDLER_H
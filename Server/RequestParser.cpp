@@ -29,245 +29,281 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Http/Request.h"
 
-namespace http
-{
+#include "../Util/StringUtil.h"
 
-RequestParser::RequestParser() : state_(method_start), header({"", ""}) {}
+#include <algorithm>
+#include <cstring>
 
-void RequestParser::Reset() { state_ = method_start; }
+namespace http
+{
 
-boost::tuple<boost::tribool, char *>
-RequestParser::Parse(Request &req, char *begin, char *end, http::CompressionType *compression_type)
+namespace
+{
+// returns the position behind the blank line that ends the headers, or nullptr
+char *FindEndOfHeaders(char *begin, char *end)
 {
-    while (begin != end)
+    char *position = begin;
+    while (position != end)
     {
-        boost::tribool result = consume(req, *begin++, compression_type);
-        if (result || !result)
+        position = static_cast<char *>(std::memchr(position, '\n', end - position));
+        if (nullptr == position)
         {
-            return boost::make_tuple(result, begin);
+            return nullptr;
+        }
+        ++position;
+        if (end - position >= 2 && '\r' == position[0] && '\n' == position[1])
+        {
+            return position + 2;
         }
     }
-    boost::tribool result = boost::indeterminate;
-    return boost::make_tuple(result, begin);
+    return nullptr;
 }
 
-boost::tribool
-RequestParser::consume(Request &req, char input, http::CompressionType *compression_type)
+// header names are case-insensitive. Both are tokens, so setting the 0x20 bit
+// only folds upper case to lower case letters.
+template <std::size_t N>
+bool IsHeaderName(const char *begin, const char *end, const char (&name)[N])
 {
-    switch (state_)
+    if (static_cast<std::size_t>(end - begin) != N - 1)
     {
-    case method_start:
-        if (!isChar(input) || isCTL(input) || isTSpecial(input))
-        {
-            return false;
-        }
-        state_ = method;
-        return boost::indeterminate;
-    case method:
-        if (input == ' ')
-        {
-            state_ = uri;
-            return boost::indeterminate;
-        }
-        if (!isChar(input) || isCTL(input) || isTSpecial(input))
-        {
-            return false;
-        }
-        return boost::indeterminate;
-    case uri_start:
-        if (isCTL(input))
+        return false;
+    }
+    for (std::size_t i = 0; i < N - 1; ++i)
+    {
+        if ((begin[i] | 0x20) != (name[i] | 0x20))
         {
             return false;
         }
-        state_ = uri;
-        req.uri.push_back(input);
-        return boost::indeterminate;
-    case uri:
-        if (input == ' ')
-        {
-            state_ = http_version_h;
-            return boost::indeterminate;
-        }
-        if (isCTL(input))
+    }
+    return true;
+}
+
+template <std::size_t N> bool Contains(const char *begin, const char *end, const char (&needle)[N])
+{
+    return std::search(begin, end, needle, needle + N - 1) != end;
+}
+}
+
+RequestParser::RequestParser() : state_(header_block), content_length(0) {}
+
+void RequestParser::Reset()
+{
+    state_ = header_block;
+    header_buffer.clear();
+    content_length = 0;
+}
+
+boost::tuple<boost::tribool, char *>
+RequestParser::Parse(Request &req, char *begin, char *end, http::CompressionType *compression_type)
+{
+    if (body == state_)
+    {
+        const boost::tribool result = consume_body(req, begin, end);
+        return boost::make_tuple(result, begin);
+    }
+
+    char *block_begin = begin;
+    char *block_end = end;
+    char *search_begin = begin;
+    if (!header_buffer.empty())
+    {
+        // the headers span several reads, continue in the accumulated copy. The blank
+        // line may have been split between the last read and this one.
+        const std::size_t search_offset =
+            header_buffer.size() - std::min<std::size_t>(3, header_buffer.size());
+        header_buffer.insert(header_buffer.end(), begin, end);
+        block_begin = header_buffer.data();
+        block_end = block_begin + header_buffer.size();
+        search_begin = block_begin + search_offset;
+    }
+
+    char *end_of_headers = FindEndOfHeaders(search_begin, block_end);
+    if (nullptr == end_of_headers)
+    {
+        if (header_buffer.empty())
         {
-            return false;
+            header_buffer.assign(begin, end);
         }
-        req.uri.push_back(input);
-        return boost::indeterminate;
-    case http_version_h:
-        if (input == 'H')
+        boost::tribool result = boost::indeterminate;
+        if (header_buffer.size() > MAX_HEADER_LENGTH)
         {
-            state_ = http_version_t_1;
-            return boost::indeterminate;
+            result = false;
         }
+        return boost::make_tuple(result, end);
+    }
+
+    // the last header line keeps its CRLF, the blank line is dropped
+    boost::tribool result =
+        ParseHeaderBlock(req, block_begin, end_of_headers - 2, compression_type);
+    if (!result)
+    {
+        return boost::make_tuple(result, end);
+    }
+    if (0 != content_length)
+    {
+        // whatever follows the headers belongs to the POST body
+        state_ = body;
+        req.body.reserve(content_length);
+        result = consume_body(req, end_of_headers, block_end);
+    }
+    char *consumed_end = end - (block_end - end_of_headers);
+    header_buffer.clear();
+    return boost::make_tuple(result, consumed_end);
+}
+
+boost::tribool RequestParser::ParseHeaderBlock(Request &req,
+                                               char *begin,
+                                               char *end,
+                                               http::CompressionType *compression_type)
+{
+    char *line_end = static_cast<char *>(std::memchr(begin, '\n', end - begin));
+    if (nullptr == line_end || line_end == begin || '\r' != line_end[-1])
+    {
         return false;
-    case http_version_t_1:
-        if (input == 'T')
-        {
-            state_ = http_version_t_2;
-            return boost::indeterminate;
-        }
+    }
+    if (!ParseRequestLine(req, begin, line_end - 1))
+    {
         return false;
-    case http_version_t_2:
-        if (input == 'T')
+    }
+
+    char *position = line_end + 1;
+    while (position != end)
+    {
+        line_end = static_cast<char *>(std::memchr(position, '\n', end - position));
+        if (nullptr == line_end || line_end == position || '\r' != line_end[-1])
         {
-            state_ = http_version_p;
-            return boost::indeterminate;
+            return false;
         }
-        return false;
-    case http_version_p:
-        if (input == 'P')
+        if (!ParseHeaderLine(req, position, line_end - 1, compression_type))
         {
-            state_ = http_version_slash;
-            return boost::indeterminate;
+            return false;
         }
+        position = line_end + 1;
+    }
+    return true;
+}
+
+bool RequestParser::ParseRequestLine(Request &req, char *begin, char *end)
+{
+    char *method_end = static_cast<char *>(std::memchr(begin, ' ', end - begin));
+    if (nullptr == method_end || !isToken(begin, method_end))
+    {
         return false;
-    case http_version_slash:
-        if (input == '/')
-        {
-            state_ = http_version_major_start;
-            return boost::indeterminate;
-        }
+    }
+
+    char *uri_begin = method_end + 1;
+    char *uri_end = static_cast<char *>(std::memchr(uri_begin, ' ', end - uri_begin));
+    if (nullptr == uri_end || uri_begin == uri_end ||
+        std::any_of(uri_begin, uri_end, [this](const char c) { return isCTL(c); }))
+    {
         return false;
-    case http_version_major_start:
-        if (isDigit(input))
-        {
-            state_ = http_version_major;
-            return boost::indeterminate;
-        }
+    }
+
+    // HTTP/<major>.<minor>
+    const char *version = uri_end + 1;
+    if (end - version < 8 || 0 != std::memcmp(version, "HTTP/", 5))
+    {
         return false;
-    case http_version_major:
-        if (input == '.')
-        {
-            state_ = http_version_minor_start;
-            return boost::indeterminate;
-        }
-        if (isDigit(input))
-        {
-            return boost::indeterminate;
-        }
+    }
+    const char *dot = static_cast<const char *>(std::memchr(version + 5, '.', end - version - 5));
+    if (nullptr == dot || dot == version + 5 || dot + 1 == end ||
+        !std::all_of(version + 5, dot, [this](const char c) { return isDigit(c); }) ||
+        !std::all_of(dot + 1, version + (end - version), [this](const char c)
+                     { return isDigit(c); }))
+    {
         return false;
-    case http_version_minor_start:
-        if (isDigit(input))
-        {
-            state_ = http_version_minor;
-            return boost::indeterminate;
-        }
+    }
+
+    req.uri.assign(uri_begin, URIDecodeInPlace(uri_begin, uri_end));
+    return true;
+}
+
+bool RequestParser::ParseHeaderLine(Request &req,
+                                    const char *begin,
+                                    const char *end,
+                                    http::CompressionType *compression_type)
+{
+    if (' ' == *begin || '\t' == *begin)
+    {
+        // folded continuation of a header value, none of the headers we look at uses it
+        return true;
+    }
+
+    const char *colon = static_cast<const char *>(std::memchr(begin, ':', end - begin));
+    if (nullptr == colon || !isToken(begin, colon))
+    {
         return false;
-    case http_version_minor:
-        if (input == '\r')
+    }
+    const char *value_begin = colon + 1;
+    while (value_begin != end && (' ' == *value_begin || '\t' == *value_begin))
+    {
+        ++value_begin;
+    }
+    const char *value_end = end;
+    while (value_end != value_begin && (' ' == value_end[-1] || '\t' == value_end[-1]))
+    {
+        --value_end;
+    }
+    if (IsHeaderName(begin, colon, "Accept-Encoding"))
+    {
+        /* giving gzip precedence over deflate */
+        if (Contains(value_begin, value_end, "deflate"))
         {
-            state_ = expecting_newline_1;
-            return boost::indeterminate;
+            *compression_type = deflateRFC1951;
         }
-        if (isDigit(input))
+        if (Contains(value_begin, value_end, "gzip"))
         {
-            return boost::indeterminate;
+            *compression_type = gzipRFC1952;
         }
-        return false;
-    case expecting_newline_1:
-        if (input == '\n')
+    }
+    else if (IsHeaderName(begin, colon, "Referer"))
+    {
+        req.referrer.assign(value_begin, value_end);
+    }
+    else if (IsHeaderName(begin, colon, "User-Agent"))
+    {
+        req.agent.assign(value_begin, value_end);
+    }
+    else if (IsHeaderName(begin, colon, "Content-Type"))
+    {
+        req.content_type.assign(value_begin, value_end);
+    }
+    else if (IsHeaderName(begin, colon, "Content-Length"))
+    {
+        if (value_begin == value_end)
         {
-            state_ = header_line_start;
-            return boost::indeterminate;
+            return false;
         }
-        return false;
-    case header_line_start:
-        if (header.name == "Accept-Encoding")
+        content_length = 0;
+        for (const char *c = value_begin; c != value_end; ++c)
         {
-            /* giving gzip precedence over deflate */
-            if (header.value.find("deflate") != std::string::npos)
+            if (!isDigit(*c))
             {
-                *compression_type = deflateRFC1951;
+                return false;
             }
-            if (header.value.find("gzip") != std::string::npos)
+            content_length = 10 * content_length + (*c - '0');
+            if (content_length > MAX_CONTENT_LENGTH)
             {
-                *compression_type = gzipRFC1952;
+                return false;
             }
         }
+    }
+    return true;
+}
 
-        if ("Referer" == header.name)
-        {
-            req.referrer = header.value;
-        }
-
-        if ("User-Agent" == header.name)
-        {
-            req.agent = header.value;
-        }
-
-        if (input == '\r')
-        {
-            state_ = expecting_newline_3;
-            return boost::indeterminate;
-        }
-        if (!isChar(input) || isCTL(input) || isTSpecial(input))
-        {
-            return false;
-        }
-        state_ = header_name;
-        header.Clear();
-        header.name.push_back(input);
-        return boost::indeterminate;
-    case header_lws:
-        if (input == '\r')
-        {
-            state_ = expecting_newline_2;
-            return boost::indeterminate;
-        }
-        if (input == ' ' || input == '\t')
-        {
-            return boost::indeterminate;
-        }
-        if (isCTL(input))
-        {
-            return false;
-        }
-        state_ = header_value;
-        return boost::indeterminate;
-    case header_name:
-        if (input == ':')
-        {
-            state_ = space_before_header_value;
-            return boost::indeterminate;
-        }
-        if (!isChar(input) || isCTL(input) || isTSpecial(input))
-        {
-            return false;
-        }
-        header.name.push_back(input);
-        return boost::indeterminate;
-    case space_before_header_value:
-        if (input == ' ')
-        {
-            state_ = header_value;
-            return boost::indeterminate;
-        }
-        return false;
-    case header_value:
-        if (input == '\r')
-        {
-            state_ = expecting_newline_2;
-            return boost::indeterminate;
-        }
-        if (isCTL(input))
-        {
-            return false;
-        }
-        header.value.push_back(input);
-        return boost::indeterminate;
-    case expecting_newline_2:
-        if (input == '\n')
-        {
-            state_ = header_line_start;
-            return boost::indeterminate;
-        }
-        return false;
-    default: // expecting_newline_3:
-        return (input == '\n');
-        // default:
-        //     return false;
+boost::tribool RequestParser::consume_body(Request &req, char *&begin, char *end)
+{
+    // copy as much of the body as the current buffer holds in one go
+    const std::size_t missing_bytes = content_length - req.body.size();
+    const std::size_t available_bytes =
+        std::min(missing_bytes, static_cast<std::size_t>(end - begin));
+    req.body.insert(req.body.end(), begin, begin + available_bytes);
+    begin += available_bytes;
+    if (req.body.size() == content_length)
+    {
+        return true;
     }
+    return boost::indeterminate;
 }
 
 inline bool RequestParser::isChar(int character) { return character >= 0 && character <= 127; }
@@ -307,4 +343,12 @@ inline bool RequestParser::isTSpecial(int character)
 }
 
 inline bool RequestParser::isDigit(int character) { return character >= '0' && character <= '9'; }
+
+inline bool RequestParser::isToken(const char *begin, const char *end)
+{
+    return begin != end && std::all_of(begin,
+                                       end,
+                                       [this](const char c)
+                                       { return isChar(c) && !isCTL(c) && !isTSpecial(c); });
+}
 }
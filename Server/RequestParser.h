@@ -29,16 +29,28 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define REQUEST_PARSER_H
 
 #include "Http/CompressionType.h"
-#include <osrm/Header.h>
 
 #include <boost/logic/tribool.hpp>
 #include <boost/tuple/tuple.hpp>
 
+#include <cstddef>
+
+#include <vector>
+
 namespace http
 {
 
+// upper bound for POST bodies, i.e. roughly 500k binary encoded coordinates
+constexpr std::size_t MAX_CONTENT_LENGTH = 4 * 1024 * 1024;
+// upper bound for request line and headers
+constexpr std::size_t MAX_HEADER_LENGTH = 256 * 1024;
+
 struct Request;
 
+// Parses the request line and headers in one go once the blank line that ends them
+// has been seen. The common case of a request that arrives in a single read is
+// parsed directly in the read buffer, only requests split over several reads are
+// copied into an internal buffer first. The URI is percent-decoded in place.
 class RequestParser
 {
   public:
@@ -49,7 +61,17 @@ class RequestParser
     Parse(Request &req, char *begin, char *end, CompressionType *compressionType);
 
   private:
-    boost::tribool consume(Request &req, char input, CompressionType *compressionType);
+    boost::tribool
+    ParseHeaderBlock(Request &req, char *begin, char *end, CompressionType *compression_type);
+
+    bool ParseRequestLine(Request &req, char *begin, char *end);
+
+    bool ParseHeaderLine(Request &req,
+                         const char *begin,
+                         const char *end,
+                         CompressionType *compression_type);
+
+    boost::tribool consume_body(Request &req, char *&begin, char *end);
 
     inline bool isChar(int c);
 
@@ -59,30 +81,14 @@ class RequestParser
 
     inline bool isDigit(int c);
 
+    inline bool isToken(const char *begin, const char *end);
+
     enum state
-    { method_start,
-      method,
-      uri_start,
-      uri,
-      http_version_h,
-      http_version_t_1,
-      http_version_t_2,
-      http_version_p,
-      http_version_slash,
-      http_version_major_start,
-      http_version_major,
-      http_version_minor_start,
-      http_version_minor,
-      expecting_newline_1,
-      header_line_start,
-      header_lws,
-      header_name,
-      space_before_header_value,
-      header_value,
-      expecting_newline_2,
-      expecting_newline_3 } state_;
-
-    Header header;
+    { header_block,
+      body } state_;
+
+    std::vector<char> header_buffer;
+    std::size_t content_length;
 };
 
 } // namespace http
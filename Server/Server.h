@@ -28,20 +28,32 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef SERVER_H
 #define SERVER_H
 
+#include "ComputeExecutor.h"
 #include "Connection.h"
 #include "RequestHandler.h"
 
 #include "../Util/cast.hpp"
 #include "../Util/make_unique.hpp"
+#include "../Util/NUMAUtil.h"
+#include "../Util/OSRMException.h"
 #include "../Util/simple_logger.hpp"
+#include "../Util/ThreadAffinity.h"
 
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
 
 #include <zlib.h>
 
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
 #include <functional>
 #include <memory>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -50,31 +62,131 @@ class Server
   public:
 
     // Note: returns a shared instead of a unique ptr as it is captured in a lambda somewhere else
-    static std::shared_ptr<Server> CreateServer(std::string &ip_address, int ip_port, unsigned requested_num_threads)
+    static std::shared_ptr<Server> CreateServer(std::string &ip_address,
+                                                int ip_port,
+                                                unsigned requested_num_threads,
+                                                unsigned requested_num_compute_threads,
+                                                bool use_reuse_port,
+                                                bool pin_threads,
+                                                bool cancel_on_close,
+                                                const std::string &unix_socket_path)
     {
         SimpleLogger().Write() << "http 1.1 compression handled by zlib version " << zlibVersion();
         const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
         const unsigned real_num_threads = std::min(hardware_threads, requested_num_threads);
-        return std::make_shared<Server>(ip_address, ip_port, real_num_threads);
+        const unsigned real_num_compute_threads =
+            std::min(hardware_threads, requested_num_compute_threads);
+#ifndef SO_REUSEPORT
+        if (use_reuse_port)
+        {
+            SimpleLogger().Write(logWARNING)
+                << "SO_REUSEPORT not supported, falling back to a single acceptor";
+            use_reuse_port = false;
+        }
+#endif
+#ifndef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        if (!unix_socket_path.empty())
+        {
+            SimpleLogger().Write(logWARNING) << "Unix domain sockets not supported, ignoring "
+                                             << unix_socket_path;
+        }
+#endif
+        return std::make_shared<Server>(ip_address,
+                                        ip_port,
+                                        real_num_threads,
+                                        real_num_compute_threads,
+                                        use_reuse_port,
+                                        pin_threads,
+                                        cancel_on_close,
+                                        unix_socket_path);
     }
 
-    explicit Server(const std::string &address, const int port, const unsigned thread_pool_size)
-        : thread_pool_size(thread_pool_size), acceptor(io_service),
-          new_connection(std::make_shared<http::Connection>(io_service, request_handler)), request_handler()
+    // With use_reuse_port every thread runs its own io_service and acceptor on the same
+    // port and the kernel distributes incoming connections among them. Otherwise all
+    // threads share a single io_service and acceptor. Co-located clients may additionally
+    // connect through a Unix domain socket, which is served by the first io_service.
+    // With cancel_on_close a query is cancelled once its client closes the connection.
+    explicit Server(const std::string &address,
+                    const int port,
+                    const unsigned thread_pool_size,
+                    const unsigned compute_pool_size,
+                    const bool use_reuse_port,
+                    const bool pin_threads,
+                    const bool cancel_on_close,
+                    const std::string &unix_socket_path)
+        : thread_pool_size(thread_pool_size), cancel_on_close(cancel_on_close),
+          thread_placement(pin_threads ? PlaceThreads(thread_pool_size) : ThreadPlacement()),
+          request_handler(),
+          compute_executor(
+              compute_pool_size, MAX_QUEUED_REQUESTS, thread_placement.compute_cpu_sets)
     {
         const std::string port_string = cast::integral_to_string(port);
+        const unsigned number_of_listeners = use_reuse_port ? thread_pool_size : 1;
+        for (unsigned i = 0; i < number_of_listeners; ++i)
+        {
+            io_services.emplace_back(osrm::make_unique<boost::asio::io_service>());
+            listeners.emplace_back(osrm::make_unique<Listener>(*io_services.back()));
+            Listener &listener = *listeners.back();
 
-        boost::asio::ip::tcp::resolver resolver(io_service);
-        boost::asio::ip::tcp::resolver::query query(address, port_string);
-        boost::asio::ip::tcp::endpoint endpoint = *resolver.resolve(query);
-
-        acceptor.open(endpoint.protocol());
-        acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
-        acceptor.bind(endpoint);
-        acceptor.listen();
-        acceptor.async_accept(
-            new_connection->socket(),
-            boost::bind(&Server::HandleAccept, this, boost::asio::placeholders::error));
+            boost::asio::ip::tcp::resolver resolver(listener.io_service);
+            boost::asio::ip::tcp::resolver::query query(address, port_string);
+            const boost::asio::generic::stream_protocol::endpoint endpoint(
+                resolver.resolve(query)->endpoint());
+
+            listener.acceptor.open(endpoint.protocol());
+            listener.acceptor.set_option(boost::asio::socket_base::reuse_address(true));
+#ifdef SO_REUSEPORT
+            if (use_reuse_port)
+            {
+                listener.acceptor.set_option(
+                    boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+            }
+#endif
+            listener.acceptor.bind(endpoint);
+            listener.acceptor.listen();
+            StartAccept(listener);
+        }
+        if (use_reuse_port)
+        {
+            SimpleLogger().Write() << "listening with " << number_of_listeners
+                                   << " SO_REUSEPORT acceptors";
+        }
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        if (!unix_socket_path.empty())
+        {
+            listeners.emplace_back(osrm::make_unique<Listener>(*io_services.front()));
+            Listener &listener = *listeners.back();
+
+            // a socket file left behind by a previous run would make bind fail
+            RemoveSocketFile(unix_socket_path);
+            const boost::asio::local::stream_protocol::endpoint local_endpoint(unix_socket_path);
+            const boost::asio::generic::stream_protocol::endpoint endpoint(local_endpoint);
+
+            listener.acceptor.open(endpoint.protocol());
+            listener.acceptor.bind(endpoint);
+            listener.acceptor.listen();
+            StartAccept(listener);
+            local_socket_path = unix_socket_path;
+            SimpleLogger().Write() << "listening on Unix domain socket " << local_socket_path;
+        }
+#endif
+    }
+
+    ~Server()
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        if (!local_socket_path.empty())
+        {
+            try
+            {
+                RemoveSocketFile(local_socket_path);
+            }
+            catch (const std::exception &e)
+            {
+                SimpleLogger().Write(logWARNING) << e.what();
+            }
+        }
+#endif
     }
 
     void Run()
@@ -82,8 +194,18 @@ class Server
         std::vector<std::shared_ptr<std::thread>> threads;
         for (unsigned i = 0; i < thread_pool_size; ++i)
         {
+            boost::asio::io_service &io_service = *io_services[i % io_services.size()];
+            const bool pin_thread = !thread_placement.network_cpus.empty();
+            const unsigned cpu = pin_thread ? thread_placement.network_cpus[i] : 0;
             std::shared_ptr<std::thread> thread = std::make_shared<std::thread>(
-                boost::bind(&boost::asio::io_service::run, &io_service));
+                [&io_service, pin_thread, cpu]()
+                {
+                    if (pin_thread)
+                    {
+                        PinCurrentThreadToCPU(cpu);
+                    }
+                    io_service.run();
+                });
             threads.push_back(thread);
         }
         for (auto thread : threads)
@@ -92,28 +214,92 @@ class Server
         }
     }
 
-    void Stop() { io_service.stop(); }
+    void Stop()
+    {
+        for (auto &io_service : io_services)
+        {
+            io_service->stop();
+        }
+        compute_executor.Stop();
+    }
 
     RequestHandler &GetRequestHandlerPtr() { return request_handler; }
 
+    ComputeExecutor &GetComputeExecutor() { return compute_executor; }
+
   private:
-    void HandleAccept(const boost::system::error_code &e)
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    // unlinks the socket file at path, if any. Anything else at the path, e.g. a regular file
+    // after a typo in --unix-socket, is kept and reported as an error.
+    static void RemoveSocketFile(const std::string &path)
+    {
+        struct stat file_status;
+        if (0 != lstat(path.c_str(), &file_status))
+        {
+            if (ENOENT == errno)
+            {
+                return;
+            }
+            throw OSRMException("cannot access " + path + ": " + std::strerror(errno));
+        }
+        if (!S_ISSOCK(file_status.st_mode))
+        {
+            throw OSRMException(path + " exists and is not a socket, not replacing it");
+        }
+        if (0 != unlink(path.c_str()))
+        {
+            throw OSRMException("cannot remove " + path + ": " + std::strerror(errno));
+        }
+    }
+#endif
+
+    struct Listener
+    {
+        explicit Listener(boost::asio::io_service &io_service)
+            : io_service(io_service), acceptor(io_service)
+        {
+        }
+
+        boost::asio::io_service &io_service;
+        boost::asio::basic_socket_acceptor<boost::asio::generic::stream_protocol> acceptor;
+        std::shared_ptr<http::Connection> new_connection;
+    };
+
+    void StartAccept(Listener &listener)
+    {
+        listener.new_connection = std::make_shared<http::Connection>(
+            listener.io_service, request_handler, compute_executor, cancel_on_close);
+        listener.acceptor.async_accept(listener.new_connection->socket(),
+                                       boost::bind(&Server::HandleAccept,
+                                                   this,
+                                                   boost::ref(listener),
+                                                   boost::asio::placeholders::error));
+    }
+
+    void HandleAccept(Listener &listener, const boost::system::error_code &e)
     {
         if (!e)
         {
-            new_connection->start();
-            new_connection = std::make_shared<http::Connection>(io_service, request_handler);
-            acceptor.async_accept(
-                new_connection->socket(),
-                boost::bind(&Server::HandleAccept, this, boost::asio::placeholders::error));
+            listener.new_connection->start();
+            StartAccept(listener);
         }
     }
 
+    // requests waiting per compute lane before new ones are rejected with 503
+    static constexpr unsigned MAX_QUEUED_REQUESTS = 256;
+
     unsigned thread_pool_size;
-    boost::asio::io_service io_service;
-    boost::asio::ip::tcp::acceptor acceptor;
-    std::shared_ptr<http::Connection> new_connection;
+    bool cancel_on_close;
+    // with pin_threads the network threads and compute workers are placed on disjoint CPUs
+    ThreadPlacement thread_placement;
     RequestHandler request_handler;
+    // declared before the listeners as their acceptors must be destroyed first
+    std::vector<std::unique_ptr<boost::asio::io_service>> io_services;
+    std::vector<std::unique_ptr<Listener>> listeners;
+    // declared last, so that its workers are joined while the io_services and the sockets
+    // of the connections they reply to still exist
+    ComputeExecutor compute_executor;
+    std::string local_socket_path;
 };
 
 #endif // SERVER_H
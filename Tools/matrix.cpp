@@ -0,0 +1,470 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+#include "../DataStructures/Percent.h"
+
+#include "../Library/OSRM.h"
+#include "../Util/GitDescription.h"
+#include "../Util/OSRMException.h"
+#include "../Util/simple_logger.hpp"
+#include "../Util/TimingUtil.h"
+
+#include <osrm/Coordinate.h>
+#include <osrm/Reply.h>
+#include <osrm/RouteParameters.h>
+#include <osrm/ServerPaths.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/program_options.hpp>
+
+#include <tbb/parallel_for.h>
+#include <tbb/task_scheduler_init.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Computes large travel time matrices offline. The table is split into tiles of sources and
+// destinations that are computed in parallel with the bucket-based many-to-many search. Tiles
+// of one band of sources are written as soon as the band is complete, so memory stays bounded
+// by the band and the tiles in flight.
+//
+// The output is little-endian and starts with a 32 byte header:
+//
+//   char[8]  magic "OSRMMTX2"
+//   uint32   rows, i.e. number of sources
+//   uint32   columns, i.e. number of destinations
+//   uint32   flags, 1 if the lengths are included
+//   uint32   checksum of the dataset
+//   uint64   hash of the source and destination coordinates
+//
+// followed by a record per source in input order: columns int32 times in 1/10 s and, if
+// requested, columns int32 lengths in m. Unreachable destinations are INT_MAX. A run that
+// finds a file of the same matrix on the same dataset continues after its last complete
+// record.
+namespace
+{
+const char MATRIX_MAGIC[8] = {'O', 'S', 'R', 'M', 'M', 'T', 'X', '2'};
+const std::uint64_t MATRIX_HEADER_SIZE = 32;
+const std::uint32_t MATRIX_HAS_LENGTHS = 1;
+
+struct MatrixHeader
+{
+    std::uint32_t number_of_rows;
+    std::uint32_t number_of_columns;
+    std::uint32_t flags;
+    std::uint32_t dataset_check_sum;
+    std::uint64_t input_hash;
+
+    bool operator==(const MatrixHeader &other) const
+    {
+        return number_of_rows == other.number_of_rows &&
+               number_of_columns == other.number_of_columns && flags == other.flags &&
+               dataset_check_sum == other.dataset_check_sum && input_hash == other.input_hash;
+    }
+};
+
+void WriteUInt(std::ostream &output, const std::uint64_t value, const unsigned number_of_bytes)
+{
+    for (unsigned i = 0; i < number_of_bytes; ++i)
+    {
+        output.put(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+std::uint64_t ReadUInt(std::istream &input, const unsigned number_of_bytes)
+{
+    std::uint64_t value = 0;
+    for (unsigned i = 0; i < number_of_bytes; ++i)
+    {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(input.get())) << (8 * i);
+    }
+    return value;
+}
+
+void WriteHeader(std::ostream &output, const MatrixHeader &header)
+{
+    output.write(MATRIX_MAGIC, sizeof(MATRIX_MAGIC));
+    WriteUInt(output, header.number_of_rows, 4);
+    WriteUInt(output, header.number_of_columns, 4);
+    WriteUInt(output, header.flags, 4);
+    WriteUInt(output, header.dataset_check_sum, 4);
+    WriteUInt(output, header.input_hash, 8);
+}
+
+// returns false if the input does not start with a matrix header
+bool ReadHeader(std::istream &input, MatrixHeader &header)
+{
+    char magic[sizeof(MATRIX_MAGIC)];
+    input.read(magic, sizeof(magic));
+    if (!input || !std::equal(magic, magic + sizeof(magic), MATRIX_MAGIC))
+    {
+        return false;
+    }
+    header.number_of_rows = static_cast<std::uint32_t>(ReadUInt(input, 4));
+    header.number_of_columns = static_cast<std::uint32_t>(ReadUInt(input, 4));
+    header.flags = static_cast<std::uint32_t>(ReadUInt(input, 4));
+    header.dataset_check_sum = static_cast<std::uint32_t>(ReadUInt(input, 4));
+    header.input_hash = ReadUInt(input, 8);
+    return static_cast<bool>(input);
+}
+
+// bulk copy of whole records, no per element conversion on little-endian hosts
+void WriteInt32Array(std::ostream &output, const std::vector<std::int32_t> &values)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    output.write(reinterpret_cast<const char *>(values.data()),
+                 values.size() * sizeof(std::int32_t));
+#else
+    for (const std::int32_t value : values)
+    {
+        WriteUInt(output, static_cast<std::uint32_t>(value), 4);
+    }
+#endif
+}
+
+// one location per line as lat,lon in degrees, empty lines and lines starting with # are skipped
+std::vector<FixedPointCoordinate> ReadCoordinates(const boost::filesystem::path &path)
+{
+    boost::filesystem::ifstream input(path);
+    if (!input)
+    {
+        throw OSRMException("cannot open " + path.string());
+    }
+    std::vector<FixedPointCoordinate> coordinates;
+    std::string line;
+    unsigned line_number = 0;
+    while (std::getline(input, line))
+    {
+        ++line_number;
+        if (line.empty() || '#' == line[0] || '\r' == line[0])
+        {
+            continue;
+        }
+        std::istringstream line_stream(line);
+        double lat = 0., lon = 0.;
+        char separator = 0;
+        line_stream >> lat >> separator >> lon;
+        const FixedPointCoordinate coordinate(static_cast<int>(COORDINATE_PRECISION * lat),
+                                              static_cast<int>(COORDINATE_PRECISION * lon));
+        if (!line_stream || ',' != separator || !coordinate.isValid())
+        {
+            throw OSRMException(path.string() + ":" + std::to_string(line_number) +
+                                ": expected lat,lon");
+        }
+        coordinates.emplace_back(coordinate);
+    }
+    return coordinates;
+}
+
+// FNV-1a over the fixed point coordinates, detects a resumed run with different input
+std::uint64_t HashCoordinates(const std::vector<FixedPointCoordinate> &sources,
+                              const std::vector<FixedPointCoordinate> &destinations)
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    const auto add = [&hash](const std::uint32_t value)
+    {
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            hash ^= (value >> (8 * i)) & 0xff;
+            hash *= 1099511628211ULL;
+        }
+    };
+    for (const std::vector<FixedPointCoordinate> *locations : {&sources, &destinations})
+    {
+        add(static_cast<std::uint32_t>(locations->size()));
+        for (const FixedPointCoordinate &coordinate : *locations)
+        {
+            add(static_cast<std::uint32_t>(coordinate.lat));
+            add(static_cast<std::uint32_t>(coordinate.lon));
+        }
+    }
+    return hash;
+}
+
+// computes the tile of sources [row_begin, row_end) and destinations [column_begin, column_end)
+// and copies it into the records of the band that starts at row_begin
+void ComputeTile(OSRM &routing_machine,
+                 const std::vector<FixedPointCoordinate> &sources,
+                 const std::vector<FixedPointCoordinate> &destinations,
+                 const unsigned row_begin,
+                 const unsigned row_end,
+                 const unsigned column_begin,
+                 const unsigned column_end,
+                 const bool with_lengths,
+                 std::vector<std::int32_t> &band)
+{
+    RouteParameters route_parameters;
+    route_parameters.service = "table";
+    for (unsigned row = row_begin; row < row_end; ++row)
+    {
+        route_parameters.coordinates.emplace_back(sources[row]);
+        route_parameters.is_source.push_back(true);
+        route_parameters.is_destination.push_back(false);
+    }
+    for (unsigned column = column_begin; column < column_end; ++column)
+    {
+        route_parameters.coordinates.emplace_back(destinations[column]);
+        route_parameters.is_source.push_back(false);
+        route_parameters.is_destination.push_back(true);
+    }
+
+    std::vector<int> distance_table, length_table;
+    const http::Reply::status_type status =
+        with_lengths ? routing_machine.Table(route_parameters, distance_table, length_table)
+                     : routing_machine.Table(route_parameters, distance_table);
+    if (http::Reply::ok != status)
+    {
+        throw OSRMException("table of sources " + std::to_string(row_begin) + "-" +
+                            std::to_string(row_end - 1) + " failed with status " +
+                            std::to_string(status));
+    }
+
+    const unsigned number_of_columns = static_cast<unsigned>(destinations.size());
+    const unsigned record_size = (with_lengths ? 2 : 1) * number_of_columns;
+    const unsigned tile_columns = column_end - column_begin;
+    for (unsigned row = 0; row < row_end - row_begin; ++row)
+    {
+        std::copy(distance_table.begin() + row * tile_columns,
+                  distance_table.begin() + (row + 1) * tile_columns,
+                  band.begin() + row * record_size + column_begin);
+        if (with_lengths)
+        {
+            std::copy(length_table.begin() + row * tile_columns,
+                      length_table.begin() + (row + 1) * tile_columns,
+                      band.begin() + row * record_size + number_of_columns + column_begin);
+        }
+    }
+}
+}
+
+int main(int argc, char *argv[])
+{
+    LogPolicy::GetInstance().Unmute();
+    try
+    {
+        ServerPaths server_paths;
+        boost::filesystem::path sources_path, destinations_path, output_path;
+        unsigned tile_size = 0, requested_num_threads = 0;
+        bool with_lengths = false;
+
+        boost::program_options::options_description generic_options("Options");
+        generic_options.add_options()("version,v", "Show version")("help,h",
+                                                                     "Show this help message");
+
+        boost::program_options::options_description config_options("Configuration");
+        config_options.add_options()(
+            "sources",
+            boost::program_options::value<boost::filesystem::path>(&sources_path)->required(),
+            "File with the source locations, one lat,lon per line")(
+            "destinations",
+            boost::program_options::value<boost::filesystem::path>(&destinations_path),
+            "File with the destination locations, the sources if not given")(
+            "output,o",
+            boost::program_options::value<boost::filesystem::path>(&output_path)->required(),
+            "Matrix file, continued if it holds a part of the same matrix")(
+            "lengths",
+            boost::program_options::value<bool>(&with_lengths)->implicit_value(true),
+            "Also write the lengths of the paths in meters")(
+            "tile-size",
+            boost::program_options::value<unsigned>(&tile_size)->default_value(1000),
+            "Sources and destinations per tile, larger tiles need fewer searches but more memory")(
+            "threads,t",
+            boost::program_options::value<unsigned>(&requested_num_threads)
+                ->default_value(tbb::task_scheduler_init::default_num_threads()),
+            "Number of threads to use");
+
+        boost::program_options::options_description hidden_options("Hidden options");
+        hidden_options.add_options()(
+            "base,b",
+            boost::program_options::value<boost::filesystem::path>(&server_paths["base"])
+                ->required(),
+            "base path to .osrm file");
+
+        boost::program_options::positional_options_description positional_options;
+        positional_options.add("base", 1);
+
+        boost::program_options::options_description cmdline_options;
+        cmdline_options.add(generic_options).add(config_options).add(hidden_options);
+
+        boost::program_options::options_description visible_options(
+            boost::filesystem::basename(argv[0]) +
+            " <base.osrm> --sources <file> -o <file> [<options>]");
+        visible_options.add(generic_options).add(config_options);
+
+        boost::program_options::variables_map option_variables;
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                          .options(cmdline_options)
+                                          .positional(positional_options)
+                                          .run(),
+                                      option_variables);
+
+        if (option_variables.count("version"))
+        {
+            SimpleLogger().Write() << g_GIT_DESCRIPTION;
+            return 0;
+        }
+
+        if (option_variables.count("help"))
+        {
+            SimpleLogger().Write() << visible_options;
+            return 0;
+        }
+
+        boost::program_options::notify(option_variables);
+
+        if (0 == tile_size || 0 == requested_num_threads)
+        {
+            throw OSRMException("tile size and number of threads must be positive");
+        }
+
+        const std::vector<FixedPointCoordinate> sources = ReadCoordinates(sources_path);
+        const std::vector<FixedPointCoordinate> destinations =
+            destinations_path.empty() ? sources : ReadCoordinates(destinations_path);
+        if (sources.empty() || destinations.empty())
+        {
+            throw OSRMException("no sources or no destinations given");
+        }
+
+        SimpleLogger().Write() << "starting up engines, " << g_GIT_DESCRIPTION;
+        OSRM routing_machine(server_paths);
+        tbb::task_scheduler_init init(requested_num_threads);
+
+        MatrixHeader header;
+        unsigned dataset_check_sum = 0;
+        if (http::Reply::ok != routing_machine.CheckSum(RouteParameters(), dataset_check_sum))
+        {
+            throw OSRMException("cannot read the checksum of the dataset");
+        }
+        header.dataset_check_sum = static_cast<std::uint32_t>(dataset_check_sum);
+        header.number_of_rows = static_cast<std::uint32_t>(sources.size());
+        header.number_of_columns = static_cast<std::uint32_t>(destinations.size());
+        header.flags = with_lengths ? MATRIX_HAS_LENGTHS : 0;
+        header.input_hash = HashCoordinates(sources, destinations);
+        const unsigned record_size = (with_lengths ? 2 : 1) * header.number_of_columns;
+        const std::uint64_t record_bytes = record_size * sizeof(std::int32_t);
+
+        // continue after the last complete record of an interrupted run
+        unsigned first_row = 0;
+        if (boost::filesystem::exists(output_path) &&
+            boost::filesystem::file_size(output_path) >= MATRIX_HEADER_SIZE)
+        {
+            MatrixHeader existing_header;
+            boost::filesystem::ifstream existing(output_path, std::ios::binary);
+            if (!ReadHeader(existing, existing_header))
+            {
+                throw OSRMException(output_path.string() +
+                                    " is no matrix file of this version, remove it to start over");
+            }
+            if (existing_header.dataset_check_sum != header.dataset_check_sum)
+            {
+                throw OSRMException(output_path.string() + " was computed on a different " +
+                                    "dataset, remove it to start over");
+            }
+            if (!(existing_header == header))
+            {
+                throw OSRMException(output_path.string() +
+                                    " holds a different matrix, remove it to start over");
+            }
+            existing.close();
+            first_row = static_cast<unsigned>(std::min<std::uint64_t>(
+                header.number_of_rows,
+                (boost::filesystem::file_size(output_path) - MATRIX_HEADER_SIZE) / record_bytes));
+            boost::filesystem::resize_file(output_path,
+                                           MATRIX_HEADER_SIZE + first_row * record_bytes);
+            SimpleLogger().Write() << "continuing " << output_path.string() << " at row "
+                                   << first_row;
+        }
+        else
+        {
+            boost::filesystem::ofstream output(output_path, std::ios::binary | std::ios::trunc);
+            WriteHeader(output, header);
+            if (!output)
+            {
+                throw OSRMException("cannot write " + output_path.string());
+            }
+        }
+        boost::filesystem::ofstream output(output_path, std::ios::binary | std::ios::app);
+
+        // narrower tiles if the columns of a band do not keep all threads busy
+        const unsigned number_of_columns = header.number_of_columns;
+        const unsigned column_tile_size = std::max(
+            1u,
+            std::min(tile_size,
+                     (number_of_columns + requested_num_threads - 1) / requested_num_threads));
+        const unsigned number_of_column_tiles =
+            (number_of_columns + column_tile_size - 1) / column_tile_size;
+
+        TIMER_START(matrix);
+        std::vector<std::int32_t> band;
+        for (unsigned row_begin = first_row; row_begin < header.number_of_rows;
+             row_begin += tile_size)
+        {
+            const unsigned row_end = std::min(header.number_of_rows, row_begin + tile_size);
+            band.resize((row_end - row_begin) * record_size);
+            tbb::parallel_for(tbb::blocked_range<unsigned>(0, number_of_column_tiles, 1),
+                              [&](const tbb::blocked_range<unsigned> &range)
+                              {
+                for (unsigned tile = range.begin(); tile != range.end(); ++tile)
+                {
+                    const unsigned column_begin = tile * column_tile_size;
+                    const unsigned column_end =
+                        std::min(number_of_columns, column_begin + column_tile_size);
+                    ComputeTile(routing_machine,
+                                sources,
+                                destinations,
+                                row_begin,
+                                row_end,
+                                column_begin,
+                                column_end,
+                                with_lengths,
+                                band);
+                }
+            });
+
+            WriteInt32Array(output, band);
+            output.flush();
+            if (!output)
+            {
+                throw OSRMException("cannot write " + output_path.string());
+            }
+            SimpleLogger().Write() << "wrote rows " << row_end << " of " << header.number_of_rows;
+        }
+        TIMER_STOP(matrix);
+        SimpleLogger().Write() << "computed " << (header.number_of_rows - first_row) << "x"
+                               << number_of_columns << " entries in " << TIMER_SEC(matrix)
+                               << " seconds";
+    }
+    catch (const std::exception &e)
+    {
+        SimpleLogger().Write(logWARNING) << "[exception] " << e.what();
+        return 1;
+    }
+    return 0;
+}
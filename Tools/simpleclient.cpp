@@ -64,16 +64,32 @@ int main(int argc, const char *argv[])
     LogPolicy::GetInstance().Unmute();
     try
     {
-        std::string ip_address;
-        int ip_port, requested_thread_num;
-        bool use_shared_memory = false, trial = false;
+        std::string ip_address, unix_socket_path, numa_policy;
+        int ip_port, requested_thread_num, requested_compute_thread_num, max_query_cost,
+            max_query_time;
+        bool use_shared_memory = false, trial = false, use_reuse_port = false,
+             pin_threads = false, parallel_search = false, cancel_on_close = true,
+             prefault = false, lock_memory = false;
         ServerPaths server_paths;
+        NamedServerPaths named_paths;
         if (!GenerateServerProgramOptions(argc,
                                           argv,
                                           server_paths,
+                                          named_paths,
                                           ip_address,
                                           ip_port,
                                           requested_thread_num,
+                                          requested_compute_thread_num,
+                                          max_query_cost,
+                                          max_query_time,
+                                          use_reuse_port,
+                                          pin_threads,
+                                          parallel_search,
+                                          cancel_on_close,
+                                          unix_socket_path,
+                                          prefault,
+                                          lock_memory,
+                                          numa_policy,
                                           use_shared_memory,
                                           trial))
         {
@@ -82,7 +98,8 @@ int main(int argc, const char *argv[])
 
         SimpleLogger().Write() << "starting up engines, " << g_GIT_DESCRIPTION;
 
-        OSRM routing_machine(server_paths, use_shared_memory);
+        OSRM routing_machine(
+            server_paths, use_shared_memory, 0, max_query_time, named_paths, parallel_search);
 
         RouteParameters route_parameters;
         route_parameters.zoom_level = 18;           // no generalization
@@ -0,0 +1,57 @@
+#include "../../DataStructures/BinaryContainer.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(binary_container)
+
+std::uint32_t ReadUInt32(const std::vector<char> &buffer, const std::size_t offset)
+{
+    std::uint32_t value = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        value |= static_cast<std::uint32_t>(static_cast<unsigned char>(buffer[offset + i]))
+                 << (8 * i);
+    }
+    return value;
+}
+
+BOOST_AUTO_TEST_CASE(header_and_payload_length)
+{
+    std::vector<char> buffer;
+    Binary::Writer writer(buffer, Binary::TablePayload);
+    writer.AppendUInt32(2);
+    writer.AppendUInt32(2);
+    writer.AppendInt32Array({0, 17, -1, 2147483647});
+    writer.Finish();
+
+    BOOST_CHECK_EQUAL(buffer.size(), Binary::HEADER_SIZE + 24);
+    BOOST_CHECK_EQUAL(std::string(buffer.begin(), buffer.begin() + 4), "OSRM");
+    BOOST_CHECK_EQUAL(buffer[4], Binary::FORMAT_VERSION);
+    BOOST_CHECK_EQUAL(buffer[6], Binary::TablePayload);
+    BOOST_CHECK_EQUAL(ReadUInt32(buffer, 8), 24u);
+
+    BOOST_CHECK_EQUAL(ReadUInt32(buffer, 12), 2u);
+    BOOST_CHECK_EQUAL(ReadUInt32(buffer, 20), 0u);
+    BOOST_CHECK_EQUAL(ReadUInt32(buffer, 24), 17u);
+    BOOST_CHECK_EQUAL(ReadUInt32(buffer, 28), 0xffffffffu);
+    BOOST_CHECK_EQUAL(ReadUInt32(buffer, 32), 0x7fffffffu);
+}
+
+BOOST_AUTO_TEST_CASE(length_prefixed_string)
+{
+    std::vector<char> buffer;
+    Binary::Writer writer(buffer, Binary::NearestPayload);
+    writer.AppendString("Hauptstraße");
+    writer.Finish();
+
+    const std::string name("Hauptstraße");
+    BOOST_CHECK_EQUAL(ReadUInt32(buffer, 8), 4 + name.size());
+    BOOST_CHECK_EQUAL(ReadUInt32(buffer, 12), name.size());
+    BOOST_CHECK_EQUAL(std::string(buffer.begin() + 16, buffer.end()), name);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
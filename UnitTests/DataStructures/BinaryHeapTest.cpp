@@ -148,4 +148,66 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(decrease_key_test, T, storage_types, RandomData
     }
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(quaternary_heap_test, T, storage_types, RandomDataFixture<NUM_NODES>)
+{
+    BinaryHeap<TestNodeID, TestKey, TestWeight, TestData, T, 4> heap(NUM_NODES);
+
+    for (unsigned idx : order)
+    {
+        heap.Insert(ids[idx], weights[idx], data[idx]);
+    }
+
+    // move every other node in front of its predecessor
+    for (unsigned idx = 1; idx < NUM_NODES; idx += 2)
+    {
+        weights[idx] -= 150;
+        heap.DecreaseKey(ids[idx], weights[idx]);
+    }
+
+    TestWeight last_weight = std::numeric_limits<TestWeight>::min();
+    for (unsigned count = 0; count < NUM_NODES; ++count)
+    {
+        const TestNodeID id = heap.DeleteMin();
+        BOOST_CHECK(heap.WasRemoved(id));
+        BOOST_CHECK_LE(last_weight, heap.GetKey(id));
+        BOOST_CHECK_EQUAL(heap.GetData(id).value, data[id].value);
+        last_weight = heap.GetKey(id);
+    }
+
+    BOOST_CHECK(heap.Empty());
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(const_lookup_test, T, storage_types, RandomDataFixture<NUM_NODES>)
+{
+    BinaryHeap<TestNodeID, TestKey, TestWeight, TestData, T> heap(NUM_NODES);
+
+    for (unsigned position = 0; position < NUM_NODES / 2; ++position)
+    {
+        const unsigned idx = order[position];
+        heap.Insert(ids[idx], weights[idx], data[idx]);
+    }
+
+    const auto &const_heap = heap;
+    BOOST_CHECK_EQUAL(const_heap.GetNumberOfInsertedNodes(), NUM_NODES / 2);
+    for (unsigned position = 0; position < NUM_NODES; ++position)
+    {
+        const unsigned idx = order[position];
+        if (position < NUM_NODES / 2)
+        {
+            BOOST_CHECK(const_heap.WasInserted(ids[idx]));
+            BOOST_CHECK_EQUAL(const_heap.GetKey(ids[idx]), weights[idx]);
+            BOOST_CHECK_EQUAL(const_heap.GetInsertionIndex(ids[idx]), position);
+        }
+        else
+        {
+            BOOST_CHECK(!const_heap.WasInserted(ids[idx]));
+        }
+    }
+
+    // looking up unknown nodes must not have touched the heap
+    heap.Insert(ids[order[NUM_NODES / 2]], weights[order[NUM_NODES / 2]], data[order[NUM_NODES / 2]]);
+    BOOST_CHECK(const_heap.WasInserted(ids[order[NUM_NODES / 2]]));
+    BOOST_CHECK_EQUAL(const_heap.GetInsertionIndex(ids[order[NUM_NODES / 2]]), NUM_NODES / 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,61 @@
+#include "../../DataStructures/QueryContextPool.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(query_context_pool)
+
+BOOST_AUTO_TEST_CASE(reuse_returned_contexts)
+{
+    QueryContextPool pool;
+    SearchEngineData *first_context = nullptr;
+    {
+        const QueryContextPool::Handle first = pool.Acquire();
+        const QueryContextPool::Handle second = pool.Acquire();
+        BOOST_CHECK(&*first != &*second);
+        BOOST_CHECK_EQUAL(pool.GetNumberOfContexts(), 2);
+        first_context = &*first;
+
+        first->InitializeOrClearFirstHeaps(10);
+        BOOST_CHECK(first->forwardHeap);
+        BOOST_CHECK(!second->forwardHeap);
+    }
+
+    // the most recently returned context comes back first, its heaps are still warm
+    const QueryContextPool::Handle third = pool.Acquire();
+    BOOST_CHECK_EQUAL(pool.GetNumberOfContexts(), 2);
+    BOOST_CHECK(&*third == first_context);
+    BOOST_CHECK(third->forwardHeap);
+}
+
+BOOST_AUTO_TEST_CASE(contexts_bounded_by_concurrent_queries)
+{
+    constexpr unsigned NUM_THREADS = 4;
+    constexpr unsigned NUM_QUERIES = 1000;
+
+    QueryContextPool pool;
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < NUM_THREADS; ++i)
+    {
+        threads.emplace_back([&pool]()
+                             {
+                                 for (unsigned query = 0; query < NUM_QUERIES; ++query)
+                                 {
+                                     const QueryContextPool::Handle context = pool.Acquire();
+                                     context->InitializeOrClearFirstHeaps(100);
+                                     context->forwardHeap->Insert(query % 100, query, query);
+                                 }
+                             });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    BOOST_CHECK_LE(pool.GetNumberOfContexts(), NUM_THREADS);
+    BOOST_CHECK_GE(pool.GetNumberOfContexts(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+#include "../../DataStructures/QueryDeadline.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+
+BOOST_AUTO_TEST_SUITE(query_deadline)
+
+BOOST_AUTO_TEST_CASE(unlimited_deadline_never_expires)
+{
+    const QueryTimeLimit time_limit(0);
+    QueryDeadline deadline = time_limit.Start();
+    for (unsigned i = 0; i < 10 * QueryDeadline::CHECK_INTERVAL; ++i)
+    {
+        BOOST_CHECK(!deadline.IsExpired());
+    }
+    BOOST_CHECK(!deadline.WasExpired());
+}
+
+BOOST_AUTO_TEST_CASE(past_deadline_expires_within_check_interval)
+{
+    QueryDeadline deadline(QueryDeadline::Clock::now() - std::chrono::milliseconds(1));
+    for (unsigned i = 1; i < QueryDeadline::CHECK_INTERVAL; ++i)
+    {
+        BOOST_CHECK(!deadline.IsExpired());
+    }
+    BOOST_CHECK(deadline.IsExpired());
+    BOOST_CHECK(deadline.WasExpired());
+
+    // stays expired without reading the clock again
+    BOOST_CHECK(deadline.IsExpired());
+}
+
+BOOST_AUTO_TEST_CASE(cancelled_deadline_expires_within_check_interval)
+{
+    std::atomic<bool> cancelled(false);
+    const QueryTimeLimit time_limit(0);
+    QueryDeadline deadline = time_limit.Start(QueryDeadline::Clock::time_point(), &cancelled);
+    for (unsigned i = 0; i < 2 * QueryDeadline::CHECK_INTERVAL; ++i)
+    {
+        BOOST_CHECK(!deadline.IsExpired());
+    }
+
+    cancelled = true;
+    for (unsigned i = 1; i < QueryDeadline::CHECK_INTERVAL; ++i)
+    {
+        BOOST_CHECK(!deadline.IsExpired());
+    }
+    BOOST_CHECK(deadline.IsExpired());
+    BOOST_CHECK(deadline.WasExpired());
+    BOOST_CHECK(deadline.WasCancelled());
+}
+
+BOOST_AUTO_TEST_CASE(deadline_counts_from_start)
+{
+    const QueryTimeLimit time_limit(100);
+    QueryDeadline deadline =
+        time_limit.Start(QueryDeadline::Clock::now() - std::chrono::milliseconds(200));
+    for (unsigned i = 1; i < QueryDeadline::CHECK_INTERVAL; ++i)
+    {
+        BOOST_CHECK(!deadline.IsExpired());
+    }
+    BOOST_CHECK(deadline.IsExpired());
+    BOOST_CHECK(!deadline.WasCancelled());
+}
+
+BOOST_AUTO_TEST_CASE(count_aborted_queries)
+{
+    QueryTimeLimit time_limit(100);
+    BOOST_CHECK_EQUAL(time_limit.GetMaxMilliseconds(), 100);
+    BOOST_CHECK_EQUAL(time_limit.GetAbortedCount(), 0);
+    time_limit.CountAborted();
+    BOOST_CHECK_EQUAL(time_limit.GetAbortedCount(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
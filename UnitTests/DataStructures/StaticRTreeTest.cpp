@@ -6,12 +6,17 @@
 
 #include <osrm/Coordinate.h>
 
+#include <boost/filesystem/fstream.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/test/test_case_template.hpp>
 #include <boost/mpl/list.hpp>
 
+#include <atomic>
+#include <iterator>
 #include <random>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE(static_rtree)
 
@@ -152,7 +157,13 @@ class LinearSearchNN
     const std::vector<TestData> &edges;
 };
 
-template <unsigned NUM_NODES, unsigned NUM_EDGES> struct RandomGraphFixture
+template <unsigned NUM_NODES,
+          unsigned NUM_EDGES,
+          int32_t MIN_LAT = WORLD_MIN_LAT,
+          int32_t MAX_LAT = WORLD_MAX_LAT,
+          int32_t MIN_LON = WORLD_MIN_LON,
+          int32_t MAX_LON = WORLD_MAX_LON>
+struct RandomGraphFixture
 {
     struct TupleHash
     {
@@ -174,8 +185,8 @@ template <unsigned NUM_NODES, unsigned NUM_EDGES> struct RandomGraphFixture
 
         std::mt19937 g(RANDOM_SEED);
 
-        std::uniform_int_distribution<> lat_udist(WORLD_MIN_LAT, WORLD_MAX_LAT);
-        std::uniform_int_distribution<> lon_udist(WORLD_MIN_LON, WORLD_MAX_LON);
+        std::uniform_int_distribution<> lat_udist(MIN_LAT, MAX_LAT);
+        std::uniform_int_distribution<> lon_udist(MIN_LON, MAX_LON);
 
         for (unsigned i = 0; i < NUM_NODES; i++)
         {
@@ -250,6 +261,14 @@ TestRandomGraphFixture_Branch;
 typedef RandomGraphFixture<TEST_LEAF_NODE_SIZE * TEST_BRANCHING_FACTOR * 3,
                            TEST_LEAF_NODE_SIZE * TEST_BRANCHING_FACTOR * 2>
 TestRandomGraphFixture_MultipleLevels;
+// city sized extent, leaves are quantized at (almost) full precision
+typedef RandomGraphFixture<TEST_LEAF_NODE_SIZE * TEST_BRANCHING_FACTOR * 3,
+                           TEST_LEAF_NODE_SIZE * TEST_BRANCHING_FACTOR,
+                           static_cast<int32_t>(52.3 * COORDINATE_PRECISION),
+                           static_cast<int32_t>(52.7 * COORDINATE_PRECISION),
+                           static_cast<int32_t>(13.1 * COORDINATE_PRECISION),
+                           static_cast<int32_t>(13.7 * COORDINATE_PRECISION)>
+TestRandomGraphFixture_City;
 
 template <typename RTreeT>
 void simple_verify_rtree(RTreeT &rtree,
@@ -275,11 +294,28 @@ void simple_verify_rtree(RTreeT &rtree,
 }
 
 template <typename RTreeT>
-void sampling_verify_rtree(RTreeT &rtree, LinearSearchNN &lsnn, unsigned num_samples)
+void sampling_verify_rtree(RTreeT &rtree,
+                           LinearSearchNN &lsnn,
+                           const std::shared_ptr<std::vector<FixedPointCoordinate>> &coords,
+                           unsigned num_samples)
 {
+    // sample around the extent of the data
+    TestStaticRTree::RectangleT extent;
+    for (const FixedPointCoordinate &c : *coords)
+    {
+        extent.min_lat = std::min(extent.min_lat, c.lat);
+        extent.max_lat = std::max(extent.max_lat, c.lat);
+        extent.min_lon = std::min(extent.min_lon, c.lon);
+        extent.max_lon = std::max(extent.max_lon, c.lon);
+    }
+    const int32_t lat_margin = (extent.max_lat - extent.min_lat) / 10;
+    const int32_t lon_margin = (extent.max_lon - extent.min_lon) / 10;
+
     std::mt19937 g(RANDOM_SEED);
-    std::uniform_int_distribution<> lat_udist(WORLD_MIN_LAT, WORLD_MAX_LAT);
-    std::uniform_int_distribution<> lon_udist(WORLD_MIN_LON, WORLD_MAX_LON);
+    std::uniform_int_distribution<> lat_udist(std::max(WORLD_MIN_LAT, extent.min_lat - lat_margin),
+                                              std::min(WORLD_MAX_LAT, extent.max_lat + lat_margin));
+    std::uniform_int_distribution<> lon_udist(std::max(WORLD_MIN_LON, extent.min_lon - lon_margin),
+                                              std::min(WORLD_MAX_LON, extent.max_lon + lon_margin));
     std::vector<FixedPointCoordinate> queries;
     for (unsigned i = 0; i < num_samples; i++)
     {
@@ -307,7 +343,8 @@ template <typename FixtureT, typename RTreeT = TestStaticRTree>
 void build_rtree(const std::string &prefix,
                  FixtureT *fixture,
                  std::string &leaves_path,
-                 std::string &nodes_path)
+                 std::string &nodes_path,
+                 const uint64_t sort_memory_limit = std::numeric_limits<uint64_t>::max())
 {
     nodes_path = prefix + ".ramIndex";
     leaves_path = prefix + ".fileIndex";
@@ -319,7 +356,7 @@ void build_rtree(const std::string &prefix,
     node_stream.write((char *)&(fixture->nodes[0]), num_nodes * sizeof(NodeInfo));
     node_stream.close();
 
-    RTreeT r(fixture->edges, nodes_path, leaves_path, fixture->nodes);
+    RTreeT r(fixture->edges, nodes_path, leaves_path, fixture->nodes, sort_memory_limit);
 }
 
 template <typename FixtureT, typename RTreeT = TestStaticRTree>
@@ -332,7 +369,7 @@ void construction_test(const std::string &prefix, FixtureT *fixture)
     LinearSearchNN lsnn(fixture->coords, fixture->edges);
 
     simple_verify_rtree(rtree, fixture->coords, fixture->edges);
-    sampling_verify_rtree(rtree, lsnn, 100);
+    sampling_verify_rtree(rtree, lsnn, fixture->coords, 100);
 }
 
 BOOST_FIXTURE_TEST_CASE(construct_half_leaf_test, TestRandomGraphFixture_LeafHalfFull)
@@ -360,6 +397,122 @@ BOOST_FIXTURE_TEST_CASE(construct_multiple_levels_test, TestRandomGraphFixture_M
     construction_test("test_5", this);
 }
 
+BOOST_FIXTURE_TEST_CASE(construct_city_test, TestRandomGraphFixture_City)
+{
+    construction_test("test_6", this);
+}
+
+// sort keys take 16 bytes, i.e. sort runs of three leaves each and the last run is only partially filled
+BOOST_FIXTURE_TEST_CASE(construct_external_sort_test, TestRandomGraphFixture_Branch)
+{
+    std::string leaves_path, nodes_path;
+    build_rtree("test_7", this, leaves_path, nodes_path);
+    std::string external_leaves_path, external_nodes_path;
+    build_rtree("test_8",
+                this,
+                external_leaves_path,
+                external_nodes_path,
+                3 * TEST_LEAF_NODE_SIZE * 2 * sizeof(uint64_t));
+
+    // both sorts yield the same leaves, hence the same tree
+    boost::filesystem::ifstream nodes_stream(nodes_path, std::ios::binary);
+    boost::filesystem::ifstream external_nodes_stream(external_nodes_path, std::ios::binary);
+    const std::vector<char> nodes((std::istreambuf_iterator<char>(nodes_stream)),
+                                  std::istreambuf_iterator<char>());
+    const std::vector<char> external_nodes((std::istreambuf_iterator<char>(external_nodes_stream)),
+                                           std::istreambuf_iterator<char>());
+    BOOST_CHECK(nodes == external_nodes);
+    BOOST_CHECK(!boost::filesystem::exists(external_leaves_path + ".run0"));
+
+    TestStaticRTree rtree(external_nodes_path, external_leaves_path, coords);
+    LinearSearchNN lsnn(coords, edges);
+    simple_verify_rtree(rtree, coords, edges);
+    sampling_verify_rtree(rtree, lsnn, coords, 100);
+}
+
+// leaf segments are ranked by their quantized bounds and then by their exact distance
+BOOST_FIXTURE_TEST_CASE(incremental_with_distance_test, TestRandomGraphFixture_City)
+{
+    std::string leaves_path, nodes_path;
+    build_rtree("test_distance", this, leaves_path, nodes_path);
+    TestStaticRTree rtree(nodes_path, leaves_path, coords);
+    LinearSearchNN lsnn(coords, edges);
+
+    std::mt19937 g(RANDOM_SEED);
+    std::uniform_int_distribution<> lat_udist(52.3 * COORDINATE_PRECISION,
+                                              52.7 * COORDINATE_PRECISION);
+    std::uniform_int_distribution<> lon_udist(13.1 * COORDINATE_PRECISION,
+                                              13.7 * COORDINATE_PRECISION);
+    for (unsigned i = 0; i < 100; i++)
+    {
+        const FixedPointCoordinate q(lat_udist(g), lon_udist(g));
+
+        std::vector<std::pair<PhantomNode, double>> results;
+        BOOST_REQUIRE(rtree.IncrementalFindPhantomNodeForCoordinateWithDistance(q, results, 1, 1));
+        std::vector<PhantomNode> phantoms;
+        BOOST_REQUIRE(rtree.IncrementalFindPhantomNodeForCoordinate(q, phantoms, 1, 1));
+        BOOST_CHECK_EQUAL(results.size(), phantoms.size());
+        BOOST_CHECK_EQUAL(results.back().first, phantoms.back());
+
+        PhantomNode phantom_ln;
+        lsnn.FindPhantomNodeForCoordinate(q, phantom_ln, 1);
+        BOOST_CHECK_EQUAL(results.back().first.location, phantom_ln.location);
+
+        float min_distance = std::numeric_limits<float>::max();
+        for (const TestData &e : edges)
+        {
+            float ratio = 0.;
+            FixedPointCoordinate foot_point;
+            min_distance = std::min(min_distance,
+                                    FixedPointCoordinate::ComputePerpendicularDistance(
+                                        coords->at(e.u), coords->at(e.v), q, foot_point, ratio));
+        }
+        BOOST_CHECK_CLOSE(results.back().second, min_distance, 0.001);
+    }
+}
+
+// threads share one tree and its leaf file, their reads must not interfere
+BOOST_FIXTURE_TEST_CASE(concurrent_queries_test, TestRandomGraphFixture_City)
+{
+    std::string leaves_path, nodes_path;
+    build_rtree("test_concurrent", this, leaves_path, nodes_path);
+    TestStaticRTree rtree(nodes_path, leaves_path, coords);
+
+    std::mt19937 g(RANDOM_SEED);
+    std::uniform_int_distribution<> lat_udist(WORLD_MIN_LAT, WORLD_MAX_LAT);
+    std::uniform_int_distribution<> lon_udist(WORLD_MIN_LON, WORLD_MAX_LON);
+    std::vector<FixedPointCoordinate> queries;
+    std::vector<PhantomNode> expected(200);
+    for (unsigned i = 0; i < expected.size(); i++)
+    {
+        queries.emplace_back(FixedPointCoordinate(lat_udist(g), lon_udist(g)));
+        rtree.FindPhantomNodeForCoordinate(queries.back(), expected[i], 1);
+    }
+
+    std::atomic<unsigned> mismatches(0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&]()
+                             {
+            for (unsigned i = 0; i < queries.size(); i++)
+            {
+                PhantomNode phantom;
+                rtree.FindPhantomNodeForCoordinate(queries[i], phantom, 1);
+                if (!(phantom == expected[i]))
+                {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0u);
+}
+
 /*
  * Bug: If you querry a point that lies between two BBs that have a gap,
  * one BB will be pruned, even if it could contain a nearer match.
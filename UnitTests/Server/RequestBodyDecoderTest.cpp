@@ -0,0 +1,111 @@
+#include "../../Server/RequestBodyDecoder.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(request_body_decoder)
+
+std::vector<char> MakeBody(const std::string &text) { return {text.begin(), text.end()}; }
+
+void AppendInt32(std::vector<char> &body, const int32_t value)
+{
+    const uint32_t bits = static_cast<uint32_t>(value);
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        body.push_back(static_cast<char>((bits >> (8 * i)) & 0xff));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(binary_body)
+{
+    std::vector<char> body;
+    AppendInt32(body, 52500000);
+    AppendInt32(body, 13400000);
+    AppendInt32(body, -33900000);
+    AppendInt32(body, -70600000);
+
+    // appended to the coordinates of the query string
+    std::vector<FixedPointCoordinate> coordinates = {FixedPointCoordinate(1, 2)};
+    BOOST_CHECK(http::DecodeBinaryCoordinates(body, coordinates));
+    BOOST_REQUIRE_EQUAL(coordinates.size(), 3u);
+    BOOST_CHECK(coordinates[0] == FixedPointCoordinate(1, 2));
+    BOOST_CHECK(coordinates[1] == FixedPointCoordinate(52500000, 13400000));
+    BOOST_CHECK(coordinates[2] == FixedPointCoordinate(-33900000, -70600000));
+
+    std::vector<FixedPointCoordinate> no_coordinates;
+    BOOST_CHECK(http::DecodeBinaryCoordinates(std::vector<char>(), no_coordinates));
+    BOOST_CHECK(no_coordinates.empty());
+}
+
+BOOST_AUTO_TEST_CASE(truncated_binary_body)
+{
+    std::vector<char> body;
+    AppendInt32(body, 52500000);
+    AppendInt32(body, 13400000);
+    AppendInt32(body, 52600000);
+    // every length that is not a whole number of lat/lon pairs
+    for (std::size_t length = 1; length < body.size(); ++length)
+    {
+        if (0 == length % 8)
+        {
+            continue;
+        }
+        std::vector<FixedPointCoordinate> coordinates;
+        BOOST_CHECK_MESSAGE(!http::DecodeBinaryCoordinates(
+                                std::vector<char>(body.begin(), body.begin() + length), coordinates),
+                            length);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(json_body)
+{
+    std::vector<FixedPointCoordinate> coordinates = {FixedPointCoordinate(1, 2)};
+    BOOST_CHECK(http::DecodeJSONCoordinates(
+        MakeBody(" [ [52.5, 13.25] ,\n[-33.875,-7.05e1]]\r\n"), coordinates));
+    BOOST_REQUIRE_EQUAL(coordinates.size(), 3u);
+    BOOST_CHECK(coordinates[0] == FixedPointCoordinate(1, 2));
+    BOOST_CHECK(coordinates[1] == FixedPointCoordinate(52500000, 13250000));
+    BOOST_CHECK(coordinates[2] == FixedPointCoordinate(-33875000, -70500000));
+
+    std::vector<FixedPointCoordinate> no_coordinates;
+    BOOST_CHECK(http::DecodeJSONCoordinates(MakeBody("[]"), no_coordinates));
+    BOOST_CHECK(no_coordinates.empty());
+}
+
+BOOST_AUTO_TEST_CASE(truncated_json_body)
+{
+    const std::string text = "[[52.5,13.4],[52.6,13.5]]";
+    // every proper prefix, some of which end in a valid number
+    for (std::size_t length = 0; length < text.size(); ++length)
+    {
+        std::vector<FixedPointCoordinate> coordinates;
+        BOOST_CHECK_MESSAGE(!http::DecodeJSONCoordinates(MakeBody(text.substr(0, length)),
+                                                         coordinates),
+                            text.substr(0, length));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(malformed_json_body)
+{
+    const std::vector<std::string> inputs = {"[[52.5,13.4]]]",
+                                             "[[52.5,13.4],]",
+                                             "[[52.5;13.4]]",
+                                             "[[52.5,13.4,0]]",
+                                             "[[52.5]]",
+                                             "[52.5,13.4]",
+                                             "[[\"52.5\",13.4]]",
+                                             "{\"locations\":[[52.5,13.4]]}",
+                                             "[[52.5,13.4]] trailing",
+                                             std::string("[[52.5,13.4]]\0", 14)};
+    for (const std::string &input : inputs)
+    {
+        std::vector<FixedPointCoordinate> coordinates;
+        BOOST_CHECK_MESSAGE(!http::DecodeJSONCoordinates(MakeBody(input), coordinates), input);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,216 @@
+#include "../../Server/RequestParser.h"
+#include "../../Server/Http/Request.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(request_parser)
+
+// a tribool only converts to true if it is true, and its negation if it is false
+bool IsAccepted(const boost::tribool result) { return static_cast<bool>(result); }
+bool IsRejected(const boost::tribool result) { return static_cast<bool>(!result); }
+
+// Feeds the input in reads of at most read_size bytes through a single read buffer, which is
+// overwritten by every read just like the buffer of a connection.
+boost::tribool ParseInReads(const std::string &input,
+                            const std::size_t read_size,
+                            http::Request &request,
+                            http::CompressionType &compression_type)
+{
+    http::RequestParser parser;
+    std::vector<char> read_buffer(read_size);
+    boost::tribool result = boost::indeterminate;
+    for (std::size_t offset = 0; offset < input.size() && boost::indeterminate(result);
+         offset += read_size)
+    {
+        const std::size_t bytes_read = std::min(read_size, input.size() - offset);
+        std::copy(input.begin() + offset, input.begin() + offset + bytes_read, read_buffer.begin());
+        boost::tie(result, boost::tuples::ignore) = parser.Parse(
+            request, read_buffer.data(), read_buffer.data() + bytes_read, &compression_type);
+    }
+    return result;
+}
+
+boost::tribool ParseInOneRead(const std::string &input, http::Request &request)
+{
+    http::CompressionType compression_type = http::noCompression;
+    return ParseInReads(input, input.size(), request, compression_type);
+}
+
+BOOST_AUTO_TEST_CASE(single_read)
+{
+    const std::string input = "GET /viaroute?loc=52.5,13.4&loc=52.6,13.5 HTTP/1.1\r\n"
+                              "Host: localhost\r\n"
+                              "user-agent: test\r\n"
+                              "Referer: http://example.com/\r\n"
+                              "Accept-Encoding: deflate, gzip\r\n"
+                              "\r\n";
+    http::Request request;
+    http::CompressionType compression_type = http::noCompression;
+    BOOST_CHECK(IsAccepted(ParseInReads(input, input.size(), request, compression_type)));
+    BOOST_CHECK_EQUAL(request.uri, "/viaroute?loc=52.5,13.4&loc=52.6,13.5");
+    BOOST_CHECK_EQUAL(request.agent, "test");
+    BOOST_CHECK_EQUAL(request.referrer, "http://example.com/");
+    BOOST_CHECK_EQUAL(compression_type, http::gzipRFC1952);
+    BOOST_CHECK(request.body.empty());
+}
+
+BOOST_AUTO_TEST_CASE(split_across_reads)
+{
+    const std::string input = "POST /table HTTP/1.1\r\n"
+                              "User-Agent: test\r\n"
+                              "Accept-Encoding: deflate\r\n"
+                              "Content-Type: application/json\r\n"
+                              "Content-Length: 19\r\n"
+                              "\r\n"
+                              "[[52.5,13.4],[1,2]]";
+    // every split point, including the ones inside the blank line that ends the headers
+    for (std::size_t read_size = 1; read_size <= input.size(); ++read_size)
+    {
+        http::Request request;
+        http::CompressionType compression_type = http::noCompression;
+        BOOST_CHECK(IsAccepted(ParseInReads(input, read_size, request, compression_type)));
+        BOOST_CHECK_EQUAL(request.uri, "/table");
+        BOOST_CHECK_EQUAL(request.agent, "test");
+        BOOST_CHECK_EQUAL(request.content_type, "application/json");
+        BOOST_CHECK_EQUAL(compression_type, http::deflateRFC1951);
+        BOOST_CHECK_EQUAL(std::string(request.body.begin(), request.body.end()),
+                          "[[52.5,13.4],[1,2]]");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(incomplete_request)
+{
+    http::Request request;
+    BOOST_CHECK(boost::indeterminate(ParseInOneRead("GET /nearest HTTP/1.1\r\n", request)));
+    BOOST_CHECK(boost::indeterminate(
+        ParseInOneRead("POST /table HTTP/1.1\r\nContent-Length: 10\r\n\r\n12345", request)));
+}
+
+BOOST_AUTO_TEST_CASE(percent_escapes_at_buffer_ends)
+{
+    const std::string input = "GET /locate?loc=52.5%2C13.4%2c HTTP/1.1\r\n\r\n";
+    const std::size_t first_escape = input.find('%');
+    // end the first read before, on and behind each character of the escape
+    for (std::size_t read_size = first_escape; read_size <= first_escape + 3; ++read_size)
+    {
+        http::Request request;
+        http::CompressionType compression_type = http::noCompression;
+        BOOST_CHECK(IsAccepted(ParseInReads(input, read_size, request, compression_type)));
+        BOOST_CHECK_EQUAL(request.uri, "/locate?loc=52.5,13.4,");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(invalid_escapes)
+{
+    // incomplete and non-hexadecimal escapes are kept verbatim and left to the API grammar
+    http::Request request;
+    BOOST_CHECK(
+        IsAccepted(ParseInOneRead("GET /nearest?loc=%zz%4%%41% HTTP/1.1\r\n\r\n", request)));
+    BOOST_CHECK_EQUAL(request.uri, "/nearest?loc=%zz%4%A%");
+
+    // an escaped control character does not make the request line malformed
+    http::Request escaped_request;
+    BOOST_CHECK(
+        IsAccepted(ParseInOneRead("GET /nearest%0A HTTP/1.1\r\n\r\n", escaped_request)));
+    BOOST_CHECK_EQUAL(escaped_request.uri, "/nearest\n");
+}
+
+BOOST_AUTO_TEST_CASE(malformed_requests)
+{
+    const std::vector<std::string> inputs = {"GET /nearest\r\n\r\n",
+                                             "GET  HTTP/1.1\r\n\r\n",
+                                             "GET /nearest HTTP/x.1\r\n\r\n",
+                                             "G(T /nearest HTTP/1.1\r\n\r\n",
+                                             "GET /nearest HTTP/1.1\r\nno colon\r\n\r\n",
+                                             "GET /nearest HTTP/1.1\r\nContent-Length: 1x\r\n\r\n",
+                                             "GET /nearest HTTP/1.1\r\nContent-Length:\r\n\r\n"};
+    for (const std::string &input : inputs)
+    {
+        http::Request request;
+        BOOST_CHECK_MESSAGE(IsRejected(ParseInOneRead(input, request)), input);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(oversized_body)
+{
+    http::Request request;
+    const std::string input = "POST /table HTTP/1.1\r\nContent-Length: " +
+                              std::to_string(http::MAX_CONTENT_LENGTH + 1) + "\r\n\r\n";
+    BOOST_CHECK(IsRejected(ParseInOneRead(input, request)));
+}
+
+BOOST_AUTO_TEST_CASE(oversized_headers)
+{
+    std::string input = "GET /nearest HTTP/1.1\r\n";
+    while (input.size() <= http::MAX_HEADER_LENGTH)
+    {
+        input += "User-Agent: " + std::string(1000, 'a') + "\r\n";
+    }
+
+    // rejected before the end of the headers was seen, whether in one read or in many
+    http::Request request;
+    BOOST_CHECK(IsRejected(ParseInOneRead(input, request)));
+    http::Request split_request;
+    http::CompressionType compression_type = http::noCompression;
+    BOOST_CHECK(IsRejected(ParseInReads(input, 8192, split_request, compression_type)));
+
+    // headers just below the limit are fine
+    http::Request small_request;
+    const std::string small_input =
+        "GET /nearest HTTP/1.1\r\nUser-Agent: " +
+        std::string(http::MAX_HEADER_LENGTH - 100, 'a') + "\r\n\r\n";
+    BOOST_CHECK(IsAccepted(ParseInReads(small_input, 8192, small_request, compression_type)));
+}
+
+BOOST_AUTO_TEST_CASE(pipelined_requests)
+{
+    std::string input = "POST /table HTTP/1.1\r\n"
+                        "Content-Length: 4\r\n"
+                        "\r\n"
+                        "abcd"
+                        "GET /nearest?loc=1,2 HTTP/1.1\r\n"
+                        "\r\n";
+    std::vector<char> buffer(input.begin(), input.end());
+    char *const buffer_end = buffer.data() + buffer.size();
+    http::CompressionType compression_type = http::noCompression;
+
+    // the parser stops behind the body of the first request
+    http::RequestParser parser;
+    http::Request first_request;
+    boost::tribool result;
+    char *consumed_end;
+    boost::tie(result, consumed_end) =
+        parser.Parse(first_request, buffer.data(), buffer_end, &compression_type);
+    BOOST_CHECK(IsAccepted(result));
+    BOOST_CHECK_EQUAL(first_request.uri, "/table");
+    BOOST_CHECK_EQUAL(std::string(first_request.body.begin(), first_request.body.end()), "abcd");
+    BOOST_CHECK_EQUAL(consumed_end - buffer.data(), input.find("GET"));
+
+    // and the second request is parsed from there after a reset
+    parser.Reset();
+    http::Request second_request;
+    boost::tie(result, consumed_end) =
+        parser.Parse(second_request, consumed_end, buffer_end, &compression_type);
+    BOOST_CHECK(IsAccepted(result));
+    BOOST_CHECK_EQUAL(second_request.uri, "/nearest?loc=1,2");
+    BOOST_CHECK(second_request.body.empty());
+    BOOST_CHECK(consumed_end == buffer_end);
+
+    // the same without a body
+    const std::string two_gets =
+        "GET /locate?loc=1,2 HTTP/1.1\r\n\r\nGET /nearest?loc=1,2 HTTP/1.1\r\n\r\n";
+    std::vector<char> get_buffer(two_gets.begin(), two_gets.end());
+    http::RequestParser get_parser;
+    http::Request get_request;
+    boost::tie(result, consumed_end) = get_parser.Parse(
+        get_request, get_buffer.data(), get_buffer.data() + get_buffer.size(), &compression_type);
+    BOOST_CHECK(IsAccepted(result));
+    BOOST_CHECK_EQUAL(get_request.uri, "/locate?loc=1,2");
+    BOOST_CHECK_EQUAL(consumed_end - get_buffer.data(), two_gets.find("GET /nearest"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,249 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef NUMA_UTIL_H
+#define NUMA_UTIL_H
+
+#include "simple_logger.hpp"
+#include "ThreadAffinity.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// NUMA topology is read from sysfs and memory policies are set by system calls, so that no
+// additional library is needed. Elsewhere the machine is treated as a single node.
+
+// parses a sysfs CPU or node list like "0-3,8-11"
+inline std::vector<unsigned> ParseCPUList(const std::string &cpu_list)
+{
+    std::vector<unsigned> cpus;
+    std::string::size_type begin = 0;
+    while (begin < cpu_list.size())
+    {
+        std::string::size_type end = cpu_list.find(',', begin);
+        if (std::string::npos == end)
+        {
+            end = cpu_list.size();
+        }
+        const std::string range = cpu_list.substr(begin, end - begin);
+        const std::string::size_type dash = range.find('-');
+        if (!range.empty())
+        {
+            const unsigned first = std::stoul(range.substr(0, dash));
+            const unsigned last =
+                (std::string::npos == dash) ? first : std::stoul(range.substr(dash + 1));
+            for (unsigned cpu = first; cpu <= last; ++cpu)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        begin = end + 1;
+    }
+    return cpus;
+}
+
+// ids of the online NUMA nodes, which need not be numbered consecutively, at least node 0
+inline std::vector<unsigned> GetNUMANodeIds()
+{
+    std::string node_list;
+#ifdef __linux__
+    boost::filesystem::ifstream node_list_stream("/sys/devices/system/node/online");
+    std::getline(node_list_stream, node_list);
+#endif
+    std::vector<unsigned> node_ids = ParseCPUList(node_list);
+    if (node_ids.empty())
+    {
+        node_ids.push_back(0);
+    }
+    return node_ids;
+}
+
+inline unsigned GetNumberOfNUMANodes() { return static_cast<unsigned>(GetNUMANodeIds().size()); }
+
+inline std::vector<unsigned> GetCPUsOfNUMANode(const unsigned node)
+{
+    std::string cpu_list;
+#ifdef __linux__
+    boost::filesystem::ifstream cpu_list_stream("/sys/devices/system/node/node" +
+                                                std::to_string(node) + "/cpulist");
+    std::getline(cpu_list_stream, cpu_list);
+#endif
+    return ParseCPUList(cpu_list);
+}
+
+// node of the CPU the calling thread currently runs on
+inline unsigned GetCurrentNUMANode()
+{
+#ifdef __linux__
+    unsigned cpu = 0, node = 0;
+    if (0 == syscall(SYS_getcpu, &cpu, &node, nullptr))
+    {
+        return node;
+    }
+#endif
+    return 0;
+}
+
+// position of the current node among GetNUMANodeIds(), by which per-node replicas are indexed
+inline unsigned GetCurrentNUMANodeIndex()
+{
+    static const std::vector<unsigned> node_ids = GetNUMANodeIds();
+    const auto position = std::find(node_ids.begin(), node_ids.end(), GetCurrentNUMANode());
+    return (node_ids.end() == position) ? 0 : static_cast<unsigned>(position - node_ids.begin());
+}
+
+// Restricts the calling thread to the CPUs of a node. Memory that the thread touches first is
+// then allocated on that node.
+inline bool BindCurrentThreadToNUMANode(const unsigned node)
+{
+#ifdef __linux__
+    const std::vector<unsigned> cpus = GetCPUsOfNUMANode(node);
+    if (cpus.empty())
+    {
+        SimpleLogger().Write(logWARNING) << "numa node " << node << " has no cpus";
+        return false;
+    }
+    return BindCurrentThreadToCPUs(cpus);
+#else
+    return 0 == node;
+#endif
+}
+
+// Spreads the pages that the calling thread faults in round-robin over all nodes, or restores
+// the default local allocation.
+inline bool SetInterleavedAllocation(const bool interleave)
+{
+#ifdef __linux__
+    unsigned long node_mask = 0;
+    for (const unsigned node : GetNUMANodeIds())
+    {
+        if (node < 8 * sizeof(node_mask))
+        {
+            node_mask |= (1ul << node);
+        }
+    }
+    const long result =
+        interleave ? syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, &node_mask, 8 * sizeof(node_mask))
+                   : syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+    if (0 != result)
+    {
+        SimpleLogger().Write(logWARNING) << "could not set numa memory policy";
+        return false;
+    }
+    return true;
+#else
+    return !interleave;
+#endif
+}
+
+// CPUs of the network threads and of the compute workers
+struct ThreadPlacement
+{
+    std::vector<unsigned> network_cpus;
+    // one set per node, holding the CPUs of the node that no network thread is pinned to
+    std::vector<std::vector<unsigned>> compute_cpu_sets;
+};
+
+// Network threads take one CPU of each node in turn and the compute workers get the remaining
+// CPUs of every node, so that the two do not share cores. Only if the network threads occupy
+// all CPUs, the compute workers may run anywhere on their node.
+inline ThreadPlacement PlaceThreads(const unsigned number_of_network_threads)
+{
+    std::vector<std::vector<unsigned>> node_cpus;
+    for (const unsigned node : GetNUMANodeIds())
+    {
+        std::vector<unsigned> cpus = GetCPUsOfNUMANode(node);
+        if (!cpus.empty())
+        {
+            node_cpus.emplace_back(std::move(cpus));
+        }
+    }
+    if (node_cpus.empty())
+    { // no topology information, the machine is a single node then
+        node_cpus.emplace_back();
+        for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu)
+        {
+            node_cpus.back().push_back(cpu);
+        }
+    }
+
+    // (node, cpu) pairs, taking the n-th CPU of every node before the (n+1)-th of any node
+    std::size_t max_cpus_per_node = 0;
+    for (const std::vector<unsigned> &cpus : node_cpus)
+    {
+        max_cpus_per_node = std::max(max_cpus_per_node, cpus.size());
+    }
+    std::vector<std::pair<unsigned, unsigned>> interleaved_cpus;
+    for (std::size_t rank = 0; rank < max_cpus_per_node; ++rank)
+    {
+        for (unsigned node = 0; node < node_cpus.size(); ++node)
+        {
+            if (rank < node_cpus[node].size())
+            {
+                interleaved_cpus.emplace_back(node, node_cpus[node][rank]);
+            }
+        }
+    }
+
+    ThreadPlacement placement;
+    std::vector<unsigned> taken(node_cpus.size(), 0);
+    for (unsigned i = 0; i < number_of_network_threads; ++i)
+    {
+        const std::pair<unsigned, unsigned> &node_and_cpu =
+            interleaved_cpus[i % interleaved_cpus.size()];
+        placement.network_cpus.push_back(node_and_cpu.second);
+        if (i < interleaved_cpus.size())
+        {
+            ++taken[node_and_cpu.first];
+        }
+    }
+    const bool all_cpus_taken = (number_of_network_threads >= interleaved_cpus.size());
+    for (unsigned node = 0; node < node_cpus.size(); ++node)
+    {
+        const unsigned first_free = all_cpus_taken ? 0 : taken[node];
+        if (first_free < node_cpus[node].size())
+        {
+            placement.compute_cpu_sets.emplace_back(node_cpus[node].begin() + first_free,
+                                                    node_cpus[node].end());
+        }
+    }
+    return placement;
+}
+
+#endif // NUMA_UTIL_H
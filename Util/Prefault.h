@@ -0,0 +1,102 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PREFAULT_H
+#define PREFAULT_H
+
+#include "simple_logger.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+
+#include <vector>
+
+// Touches every page of a region so that the first queries do not fault them in. With
+// lock_to_ram the region is also pinned, which only logs a warning beyond RLIMIT_MEMLOCK.
+inline void PrefaultMemory(const void *address, const uint64_t size, const bool lock_to_ram)
+{
+    if (nullptr == address || 0 == size)
+    {
+        return;
+    }
+#ifndef WIN32
+    const uint64_t page_size = sysconf(_SC_PAGESIZE);
+    // madvise and mlock want a page aligned start address
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(address) & ~uintptr_t(page_size - 1);
+    const uint64_t length = reinterpret_cast<uintptr_t>(address) + size - begin;
+    madvise(reinterpret_cast<void *>(begin), length, MADV_WILLNEED);
+#else
+    const uint64_t page_size = 4096;
+#endif
+    const volatile char *bytes = static_cast<const volatile char *>(address);
+    char checksum = 0;
+    for (uint64_t offset = 0; offset < size; offset += page_size)
+    {
+        checksum ^= bytes[offset];
+    }
+    checksum ^= bytes[size - 1];
+    (void)checksum;
+
+    if (lock_to_ram)
+    {
+#ifndef WIN32
+        if (-1 == mlock(reinterpret_cast<void *>(begin), length))
+        {
+            SimpleLogger().Write(logWARNING) << "could not lock " << size << " bytes to RAM";
+        }
+#else
+        SimpleLogger().Write(logWARNING) << "locking memory is not supported on this platform";
+#endif
+    }
+}
+
+// Reads a file front to back to pull it into the page cache, returns the number of bytes read
+inline uint64_t PrefaultFile(const boost::filesystem::path &path)
+{
+    boost::filesystem::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        SimpleLogger().Write(logWARNING) << "could not open " << path.string() << " for warm-up";
+        return 0;
+    }
+    std::vector<char> buffer(1024 * 1024);
+    uint64_t bytes_read = 0;
+    while (file.read(buffer.data(), buffer.size()) || 0 < file.gcount())
+    {
+        bytes_read += file.gcount();
+    }
+    return bytes_read;
+}
+
+#endif // PREFAULT_H
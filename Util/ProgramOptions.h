@@ -40,6 +40,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <fstream>
 #include <string>
+#include <vector>
 
 const static unsigned INIT_OK_START_ENGINE = 0;
 const static unsigned INIT_OK_DO_NOT_START_ENGINE = 1;
@@ -143,17 +144,58 @@ inline void populate_base_path(ServerPaths &server_paths)
     SimpleLogger().Write(logDEBUG) << "Timestamp file:\t" << server_paths["timestamp"];
 }
 
+// parses name=base.osrm specifications of additional datasets
+inline void populate_named_paths(const std::vector<std::string> &dataset_specifications,
+                                 NamedServerPaths &named_paths)
+{
+    for (const std::string &specification : dataset_specifications)
+    {
+        const std::string::size_type separator = specification.find('=');
+        if (std::string::npos == separator || 0 == separator ||
+            specification.size() == separator + 1)
+        {
+            throw OSRMException("dataset must be given as name=base.osrm: " + specification);
+        }
+        const std::string name = specification.substr(0, separator);
+        // the name is the first segment of the request path
+        if (std::string::npos != name.find_first_not_of("abcdefghijklmnopqrstuvwxyz"
+                                                        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                                        "0123456789_-"))
+        {
+            throw OSRMException("dataset name may only contain letters, digits, _ and -: " + name);
+        }
+        if (named_paths.find(name) != named_paths.end())
+        {
+            throw OSRMException("dataset given twice: " + name);
+        }
+        named_paths[name]["base"] = specification.substr(separator + 1);
+    }
+}
+
 // generate boost::program_options object for the routing part
 inline unsigned GenerateServerProgramOptions(const int argc,
                                              const char *argv[],
                                              ServerPaths &paths,
+                                             NamedServerPaths &named_paths,
                                              std::string &ip_address,
                                              int &ip_port,
                                              int &requested_num_threads,
+                                             int &requested_num_compute_threads,
+                                             int &max_query_cost,
+                                             int &max_query_time,
+                                             bool &use_reuse_port,
+                                             bool &pin_threads,
+                                             bool &parallel_search,
+                                             bool &cancel_on_close,
+                                             std::string &unix_socket_path,
+                                             bool &prefault,
+                                             bool &lock_memory,
+                                             std::string &numa_policy,
                                              bool &use_shared_memory,
                                              bool &trial)
 {
     // declare a group of options that will be allowed only on command line
+    std::vector<std::string> dataset_specifications;
     boost::program_options::options_description generic_options("Options");
     generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message")(
         "config,c",
@@ -196,6 +238,49 @@ inline unsigned GenerateServerProgramOptions(const int argc,
         "threads,t",
         boost::program_options::value<int>(&requested_num_threads)->default_value(8),
         "Number of threads to use")(
+        "compute-threads",
+        boost::program_options::value<int>(&requested_num_compute_threads)->default_value(8),
+        "Number of threads to compute queries, a quarter of them for cheap services")(
+        "max-query-cost",
+        boost::program_options::value<int>(&max_query_cost),
+        "Estimated cost of queued and running queries before shedding load, 0 = unlimited. "
+        "Defaults to two tables of the maximal size per compute thread")(
+        "max-query-time",
+        boost::program_options::value<int>(&max_query_time)->default_value(0),
+        "Milliseconds a search may run before it is aborted, 0 = unlimited")(
+        "reuseport",
+        boost::program_options::value<bool>(&use_reuse_port)->implicit_value(true),
+        "One acceptor per thread, balanced by the kernel with SO_REUSEPORT")(
+        "pin-threads",
+        boost::program_options::value<bool>(&pin_threads)->implicit_value(true),
+        "Pin network threads to CPUs and keep compute threads off them, per NUMA node")(
+        "parallel-search",
+        boost::program_options::value<bool>(&parallel_search)->implicit_value(true),
+        "Search the legs and alternatives of one route on several threads. These come from a shared "
+        "pool that is neither bounded by --compute-threads nor pinned to a NUMA node")(
+        "cancel-on-close",
+        boost::program_options::value<bool>(&cancel_on_close)->default_value(true),
+        "Cancel the query of a client that closes the connection. Disable for clients that "
+        "shut down their sending side once the request is sent")(
+        "unix-socket",
+        boost::program_options::value<std::string>(&unix_socket_path),
+        "Also accept requests on this Unix domain socket")(
+        "prefault",
+        boost::program_options::value<bool>(&prefault)->implicit_value(true),
+        "Fault in the dataset before accepting requests")(
+        "lock-memory",
+        boost::program_options::value<bool>(&lock_memory)->implicit_value(true),
+        "Also lock the prefaulted dataset into RAM, bounded by RLIMIT_MEMLOCK")(
+        "warmup-log",
+        boost::program_options::value<boost::filesystem::path>(&paths["warmuplog"]),
+        "Replay the request URIs in this file, one per line, before accepting requests")(
+        "numa",
+        boost::program_options::value<std::string>(&numa_policy)->default_value("off"),
+        "Placement of the dataset on NUMA machines: off, interleave or replicate")(
+        "dataset",
+        boost::program_options::value<std::vector<std::string>>(&dataset_specifications)
+            ->composing(),
+        "Additional dataset name=base.osrm, queried with the path prefix /name/")(
         "sharedmemory,s",
         boost::program_options::value<bool>(&use_shared_memory)->implicit_value(true),
         "Load data from shared memory");
@@ -256,6 +341,7 @@ inline unsigned GenerateServerProgramOptions(const int argc,
         boost::program_options::store(parse_config_file(config_stream, config_file_options),
                                       option_variables);
         boost::program_options::notify(option_variables);
+        populate_named_paths(dataset_specifications, named_paths);
         return INIT_OK_START_ENGINE;
     }
 
@@ -264,6 +350,33 @@ inline unsigned GenerateServerProgramOptions(const int argc,
         throw OSRMException("Number of threads must be a positive number");
     }
 
+    if (1 > requested_num_compute_threads)
+    {
+        throw OSRMException("Number of compute threads must be a positive number");
+    }
+
+    if (!option_variables.count("max-query-cost"))
+    {
+        // a table of 100x100 locations is estimated at 10200
+        max_query_cost = 2 * 10200 * requested_num_compute_threads;
+    }
+    else if (0 > max_query_cost)
+    {
+        throw OSRMException("Maximum query cost must not be negative");
+    }
+
+    if (0 > max_query_time)
+    {
+        throw OSRMException("Maximum query time must not be negative");
+    }
+
+    if ("off" != numa_policy && "interleave" != numa_policy && "replicate" != numa_policy)
+    {
+        throw OSRMException("NUMA policy must be one of off, interleave or replicate");
+    }
+
+    populate_named_paths(dataset_specifications, named_paths);
+
     if (!use_shared_memory && option_variables.count("base"))
     {
         return INIT_OK_START_ENGINE;
@@ -146,6 +146,27 @@ inline std::size_t URIDecode(const std::string &input, std::string &output)
 
 inline std::size_t URIDecodeInPlace(std::string &URI) { return URIDecode(URI, URI); }
 
+// decodes [begin, end) in place and returns the end of the decoded range
+inline char *URIDecodeInPlace(char *begin, char *end)
+{
+    char *output = begin;
+    for (char *input = begin; input != end; ++output)
+    {
+        if (input[0] == '%' && end - input > 2 && isxdigit(input[1]) && isxdigit(input[2]))
+        {
+            char a = input[1];
+            char b = input[2];
+            a -= input[1] < 58 ? 48 : input[1] < 71 ? 55 : 87;
+            b -= input[2] < 58 ? 48 : input[2] < 71 ? 55 : 87;
+            *output = 16 * a + b;
+            input += 3;
+            continue;
+        }
+        *output = *input++;
+    }
+    return output;
+}
+
 // TODO: remove after switch to libosmium
 inline bool StringStartsWith(const std::string &input, const std::string &prefix)
 {
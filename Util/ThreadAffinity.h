@@ -0,0 +1,81 @@
+/*
+
+Copyright (c) 2013, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef THREAD_AFFINITY_H
+#define THREAD_AFFINITY_H
+
+#include "simple_logger.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <vector>
+
+// binds the calling thread to a single CPU, returns false where unsupported
+inline bool PinCurrentThreadToCPU(const unsigned cpu)
+{
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    if (0 != pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set))
+    {
+        SimpleLogger().Write(logWARNING) << "could not pin thread to cpu " << cpu;
+        return false;
+    }
+    return true;
+#else
+    SimpleLogger().Write(logWARNING) << "pinning threads is not supported on this platform";
+    return false;
+#endif
+}
+
+// lets the calling thread run on any of the given CPUs, returns false where unsupported
+inline bool BindCurrentThreadToCPUs(const std::vector<unsigned> &cpus)
+{
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const unsigned cpu : cpus)
+    {
+        CPU_SET(cpu, &cpu_set);
+    }
+    if (0 != pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set))
+    {
+        SimpleLogger().Write(logWARNING) << "could not bind thread to " << cpus.size() << " cpus";
+        return false;
+    }
+    return true;
+#else
+    SimpleLogger().Write(logWARNING) << "pinning threads is not supported on this platform";
+    return false;
+#endif
+}
+
+#endif // THREAD_AFFINITY_H
@@ -57,6 +57,7 @@ using QueryGraph = StaticGraph<QueryEdge::EdgeData>;
 
 #include <cstdint>
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 
@@ -344,6 +345,8 @@ int main(const int argc, const char *argv[])
         geometry_input_stream.read((char *)&number_of_compressed_geometries, sizeof(unsigned));
         shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::GEOMETRIES_LIST,
                                                   number_of_compressed_geometries);
+        shared_layout_ptr->SetBlockSize<SimplificationRank>(
+            SharedDataLayout::GEOMETRIES_RANK_LIST, number_of_compressed_geometries);
         // allocate shared memory block
         SimpleLogger().Write() << "allocating shared memory of "
                                << shared_layout_ptr->GetSizeOfLayout() << " bytes";
@@ -476,6 +479,25 @@ int main(const int argc, const char *argv[])
                 shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_LIST));
         }
 
+        SimplificationRank *geometries_rank_list_ptr =
+            shared_layout_ptr->GetBlockPtr<SimplificationRank, true>(
+                shared_memory_ptr, SharedDataLayout::GEOMETRIES_RANK_LIST);
+        if (shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_RANK_LIST) > 0)
+        {
+            geometry_input_stream.read(
+                (char *)geometries_rank_list_ptr,
+                shared_layout_ptr->GetBlockSize(SharedDataLayout::GEOMETRIES_RANK_LIST));
+            if (!geometry_input_stream)
+            {
+                SimpleLogger().Write(logWARNING)
+                    << "geometry file has no simplification ranks, rerun osrm-prepare";
+                std::fill(geometries_rank_list_ptr,
+                          geometries_rank_list_ptr +
+                              shared_layout_ptr->num_entries[SharedDataLayout::GEOMETRIES_RANK_LIST],
+                          INVALID_SIMPLIFICATION_RANK);
+            }
+        }
+
         // Loading list of coordinates
         FixedPointCoordinate *coordinates_ptr =
             shared_layout_ptr->GetBlockPtr<FixedPointCoordinate, true>(
@@ -533,6 +555,10 @@ int main(const int argc, const char *argv[])
         SharedDataTimestamp *data_timestamp_ptr =
             static_cast<SharedDataTimestamp *>(data_type_memory->Ptr());
 
+        // the r-tree leaves stay on disk, pull them into the page cache before switching over
+        SimpleLogger().Write() << "read " << PrefaultFile(file_index_path)
+                               << " bytes of r-tree leaves";
+
         boost::interprocess::scoped_lock<boost::interprocess::named_mutex> query_lock(
             barrier.query_mutex);
 
@@ -26,8 +26,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "Library/OSRM.h"
+#include "Server/QueryLogReplay.h"
 #include "Server/Server.h"
 #include "Util/GitDescription.h"
+#include "Util/make_unique.hpp"
+#include "Util/NUMAUtil.h"
 #include "Util/ProgramOptions.h"
 #include "Util/simple_logger.hpp"
 #include "Util/FingerPrint.h"
@@ -40,11 +43,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <signal.h>
 
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <future>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
 #ifdef _WIN32
 boost::function0<void> console_ctrl_function;
@@ -71,18 +78,34 @@ int main(int argc, const char *argv[])
     {
         LogPolicy::GetInstance().Unmute();
 
-        bool use_shared_memory = false, trial_run = false;
-        std::string ip_address;
-        int ip_port, requested_thread_num;
+        bool use_shared_memory = false, trial_run = false, use_reuse_port = false,
+             pin_threads = false, parallel_search = false, cancel_on_close = true,
+             prefault = false, lock_memory = false;
+        std::string ip_address, unix_socket_path, numa_policy;
+        int ip_port, requested_thread_num, requested_compute_thread_num, max_query_cost,
+            max_query_time;
 
         ServerPaths server_paths;
+        NamedServerPaths named_paths;
 
         const unsigned init_result = GenerateServerProgramOptions(argc,
                                                                   argv,
                                                                   server_paths,
+                                                                  named_paths,
                                                                   ip_address,
                                                                   ip_port,
                                                                   requested_thread_num,
+                                                                  requested_compute_thread_num,
+                                                                  max_query_cost,
+                                                                  max_query_time,
+                                                                  use_reuse_port,
+                                                                  pin_threads,
+                                                                  parallel_search,
+                                                                  cancel_on_close,
+                                                                  unix_socket_path,
+                                                                  prefault,
+                                                                  lock_memory,
+                                                                  numa_policy,
                                                                   use_shared_memory,
                                                                   trial_run);
         if (init_result == INIT_OK_DO_NOT_START_ENGINE)
@@ -109,6 +132,9 @@ int main(int argc, const char *argv[])
         }
 
         SimpleLogger().Write(logDEBUG) << "Threads:\t" << requested_thread_num;
+        SimpleLogger().Write(logDEBUG) << "Compute threads:\t" << requested_compute_thread_num;
+        SimpleLogger().Write(logDEBUG) << "Max. query cost:\t" << max_query_cost;
+        SimpleLogger().Write(logDEBUG) << "Max. query time:\t" << max_query_time << " ms";
         SimpleLogger().Write(logDEBUG) << "IP address:\t" << ip_address;
         SimpleLogger().Write(logDEBUG) << "IP port:\t" << ip_port;
 #ifndef _WIN32
@@ -119,11 +145,93 @@ int main(int argc, const char *argv[])
         pthread_sigmask(SIG_BLOCK, &new_mask, &old_mask);
 #endif
 
-        OSRM osrm_lib(server_paths, use_shared_memory);
+        bool replicate = ("replicate" == numa_policy);
+        if (replicate && use_shared_memory)
+        {
+            SimpleLogger().Write(logWARNING)
+                << "data in shared memory is placed by osrm-datastore, not replicating it";
+            replicate = false;
+        }
+        if ("interleave" == numa_policy && use_shared_memory)
+        {
+            SimpleLogger().Write(logWARNING)
+                << "data in shared memory is placed by osrm-datastore, not interleaving it";
+            numa_policy = "off";
+        }
+        // node ids may have gaps, replica i is placed on numa_nodes[i]
+        const std::vector<unsigned> numa_nodes = GetNUMANodeIds();
+        const unsigned number_of_replicas =
+            replicate ? static_cast<unsigned>(numa_nodes.size()) : 1;
+        // the replicas share the budget of queued and running queries
+        const unsigned replica_query_cost =
+            (0 == max_query_cost) ? 0 : std::max(1u, max_query_cost / number_of_replicas);
+        std::vector<std::unique_ptr<OSRM>> routing_machines(number_of_replicas);
+        const auto warmup_log = server_paths.find("warmuplog");
+        const auto load_replica = [&](const unsigned replica)
+        {
+            // pages are allocated on the node of the thread that touches them first
+            if (replicate)
+            {
+                BindCurrentThreadToNUMANode(numa_nodes[replica]);
+            }
+            else if ("interleave" == numa_policy)
+            {
+                SetInterleavedAllocation(true);
+            }
+            routing_machines[replica] = osrm::make_unique<OSRM>(server_paths,
+                                                                use_shared_memory,
+                                                                replica_query_cost,
+                                                                max_query_time,
+                                                                named_paths,
+                                                                parallel_search);
+
+            // warm up before the acceptor opens, so that the first requests do not hit cold pages
+            if (prefault || lock_memory)
+            {
+                routing_machines[replica]->Prefault(lock_memory);
+            }
+            if (server_paths.end() != warmup_log && !warmup_log->second.empty())
+            {
+                ReplayQueryLog(*routing_machines[replica], warmup_log->second);
+            }
+        };
+        for (unsigned replica = 0; replica < number_of_replicas; ++replica)
+        {
+            if (replicate)
+            {
+                SimpleLogger().Write() << "loading replica for numa node " << numa_nodes[replica];
+            }
+            std::async(std::launch::async, load_replica, replica).get();
+        }
+
         auto routing_server =
-            Server::CreateServer(ip_address, ip_port, requested_thread_num);
+            Server::CreateServer(ip_address,
+                                 ip_port,
+                                 requested_thread_num,
+                                 requested_compute_thread_num,
+                                 use_reuse_port,
+                                 pin_threads,
+                                 cancel_on_close,
+                                 unix_socket_path);
 
-        routing_server->GetRequestHandlerPtr().RegisterRoutingMachine(&osrm_lib);
+        // the status service also reports the queues of the compute threads
+        ComputeExecutor &compute_executor = routing_server->GetComputeExecutor();
+        for (const std::unique_ptr<OSRM> &routing_machine : routing_machines)
+        {
+            routing_server->GetRequestHandlerPtr().RegisterRoutingMachine(routing_machine.get());
+            for (const ComputeExecutor::Lane lane :
+                 {ComputeExecutor::light, ComputeExecutor::heavy})
+            {
+                const std::string prefix = (ComputeExecutor::light == lane) ? "light" : "heavy";
+                routing_machine->AddStatusCounter(prefix + "_queue_depth",
+                                                  [&compute_executor, lane]() -> uint64_t
+                                                  { return compute_executor.QueueDepth(lane); });
+                routing_machine->AddStatusCounter(
+                    prefix + "_queue_rejected",
+                    [&compute_executor, lane]()
+                    { return compute_executor.GetRejectedCount(lane); });
+            }
+        }
 
         if (trial_run)
         {
@@ -142,9 +250,59 @@ int main(int argc, const char *argv[])
             sigaddset(&wait_mask, SIGINT);
             sigaddset(&wait_mask, SIGQUIT);
             sigaddset(&wait_mask, SIGTERM);
+            sigaddset(&wait_mask, SIGHUP);
             pthread_sigmask(SIG_BLOCK, &wait_mask, 0);
             SimpleLogger().Write() << "running and waiting for requests";
-            sigwait(&wait_mask, &sig);
+            // SIGHUP reloads the datasets in the background while queries continue on the old data
+            std::future<void> reload;
+            const auto reload_replica = [&](const unsigned replica)
+            {
+                if (replicate)
+                {
+                    BindCurrentThreadToNUMANode(numa_nodes[replica]);
+                }
+                else if ("interleave" == numa_policy)
+                {
+                    SetInterleavedAllocation(true);
+                }
+                routing_machines[replica]->Reload();
+                // the swapped in data is as cold as it was at startup
+                if (server_paths.end() != warmup_log && !warmup_log->second.empty())
+                {
+                    try
+                    {
+                        ReplayQueryLog(*routing_machines[replica], warmup_log->second);
+                    }
+                    catch (const std::exception &e)
+                    {
+                        SimpleLogger().Write(logWARNING) << "warm-up after reload failed: "
+                                                         << e.what();
+                    }
+                }
+            };
+            const auto reload_replicas = [&]()
+            {
+                for (unsigned replica = 0; replica < number_of_replicas; ++replica)
+                {
+                    std::async(std::launch::async, reload_replica, replica).get();
+                }
+            };
+            while (0 == sigwait(&wait_mask, &sig) && SIGHUP == sig)
+            {
+                if (reload.valid() &&
+                    std::future_status::ready != reload.wait_for(std::chrono::seconds(0)))
+                {
+                    SimpleLogger().Write(logWARNING) << "reload already in progress, ignoring SIGHUP";
+                    continue;
+                }
+                SimpleLogger().Write() << "reloading datasets";
+                reload = std::async(std::launch::async, reload_replicas);
+            }
+            if (reload.valid())
+            {
+                SimpleLogger().Write() << "waiting for reload to finish";
+                reload.wait();
+            }
 #else
             // Set console control handler to allow server to be stopped.
             console_ctrl_function = std::bind(&Server::Stop, routing_server);
@@ -40,10 +40,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 using NodeID = unsigned int;
 using EdgeID = unsigned int;
 using EdgeWeight = int;
+// lowest zoom level at which a geometry point is part of the generalized polyline
+using SimplificationRank = unsigned char;
 
 static const NodeID SPECIAL_NODEID = std::numeric_limits<unsigned>::max();
 static const EdgeID SPECIAL_EDGEID = std::numeric_limits<unsigned>::max();
 static const unsigned INVALID_NAMEID = std::numeric_limits<unsigned>::max();
 static const EdgeWeight INVALID_EDGE_WEIGHT = std::numeric_limits<int>::max();
+static const SimplificationRank INVALID_SIMPLIFICATION_RANK =
+    std::numeric_limits<SimplificationRank>::max();
 
 #endif /* TYPEDEFS_H */